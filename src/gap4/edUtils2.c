@@ -17,6 +17,7 @@
 #include "fort.h"
 #include "misc.h"
 #include "tman_interface.h"
+#include "tkTraceIO.h"
 #include "locks.h"
 #include "io_utils.h"
 #include "IO2.h"
@@ -2990,6 +2991,29 @@ DisplayContext *showTrace(EdStruct *xx, int seq, int pos, int baseSpacing,
 }
 
 
+/*
+ * Queues the traces of the readings either side of 'seq' in the display
+ * order for decoding when idle, so that moving on to them is quick.
+ */
+static void prefetchTraces(EdStruct *xx, int seq)
+{
+    int i, j;
+    char fileName[256];
+    char t_type[5];
+
+    for (i = 1; i <= DBI_gelCount(xx) && DBI_order(xx)[i] != seq; i++)
+	;
+    if (i > DBI_gelCount(xx))
+	return;
+
+    for (j = i-1; j <= i+1; j += 2) {
+	if (j < 1 || j > DBI_gelCount(xx))
+	    continue;
+	if (0 == get_trace_path(xx, DBI_order(xx)[j], fileName, t_type))
+	    trace_prefetch(fileName, "anytr");
+    }
+}
+
 void edInvokeTrace(EdStruct *xx) {
     int baseSpacing = xx->fontWidth * 2;
     int *slist;
@@ -3002,6 +3026,7 @@ void edInvokeTrace(EdStruct *xx) {
 		  baseSpacing,
 		  0,
 		  0 /* full */);
+	prefetchTraces(xx, xx->cursorSeq);
     } else {
 	int *seqList;
 	int i, j, tmpcmp, tmpdiff, tmprp;
@@ -916,6 +916,81 @@ StringMatch(GapIO *io,                                                 /* in */
     return n_matches;
 }
 
+/*
+ * Computes the consensus over each range in contig_array.
+ * Returns a malloced array of num_contigs strings, to be freed with
+ * free_oligo_consensus(), or NULL on failure.
+ */
+static char **find_oligo_consensus(GapIO *io,
+				   int num_contigs,
+				   contig_list_t *contig_array)
+{
+    char **cons_array;
+    int i, seq_len;
+
+    if (NULL == (cons_array = (char **)xcalloc(num_contigs, sizeof(char *))))
+	return NULL;
+
+    for (i = 0; i < num_contigs; i++) {
+	seq_len = contig_array[i].end - contig_array[i].start + 1;
+	if (NULL == (cons_array[i] = (char *)xmalloc(seq_len + 1)))
+	    goto error;
+
+	calc_consensus(contig_array[i].contig,
+		       contig_array[i].start, contig_array[i].end,
+		       CON_SUM, cons_array[i],
+		       NULL, NULL, NULL, consensus_cutoff, quality_cutoff,
+		       database_info, io);
+	cons_array[i][seq_len] = '\0';
+    }
+
+    return cons_array;
+
+ error:
+    for (i = 0; i < num_contigs; i++) {
+	if (cons_array[i])
+	    xfree(cons_array[i]);
+    }
+    xfree(cons_array);
+    return NULL;
+}
+
+static void free_oligo_consensus(char **cons_array, int num_contigs) {
+    int i;
+
+    for (i = 0; i < num_contigs; i++) {
+	if (cons_array[i])
+	    xfree(cons_array[i]);
+    }
+    xfree(cons_array);
+}
+
+/*
+ * The maximum number of matches to store per oligo. Also returns the
+ * longest contig length in *max_clen.
+ */
+static int find_oligo_max_matches(GapIO *io,
+				  int num_contigs,
+				  contig_list_t *contig_array,
+				  int *max_clen)
+{
+    int i, max_matches, abs_max;
+
+    for (max_matches = 0, *max_clen = 0, i=0; i<num_contigs; i++) {
+	if (io_clength(io, contig_array[i].contig) > *max_clen)
+	    *max_clen = io_clength(io, contig_array[i].contig);
+	max_matches += io_clength(io, contig_array[i].contig);
+    }
+    max_matches *= 2; /* both strands */
+
+    abs_max = get_default_int(GetInterp(), gap_defs, "FINDOLIGO.MAX_MATCHES");
+
+    if (max_matches > abs_max)
+	max_matches = abs_max;
+
+    return max_matches;
+}
+
 int
 find_oligos(GapIO *io,
 	    int num_contigs,
@@ -925,32 +1000,19 @@ find_oligos(GapIO *io,
 	    int consensus_only,
 	    int in_cutoff)
 {
-    int i;
     int *pos1 = NULL;
     int *pos2 = NULL;
     int *score = NULL;
     int *length = NULL;
     int *c1 = NULL;
     int *c2 = NULL;
-    int max_matches, abs_max;
-    int seq_len;
+    int max_matches;
     int n_matches;
     int max_clen;
     char **cons_array = NULL;
 
-    /* Calculate maximum contig length and total contig length */
-    max_clen = io_clength(io, CalcLongContig(io));
-    for (max_matches = 0, max_clen = 0, i=0; i<num_contigs; i++) {
-	if (io_clength(io, contig_array[i].contig) > max_clen)
-	    max_clen = io_clength(io, contig_array[i].contig);
-	max_matches += io_clength(io, contig_array[i].contig);
-    }
-    max_matches *= 2; /* both strands */
-
-    abs_max = get_default_int(GetInterp(), gap_defs, "FINDOLIGO.MAX_MATCHES");
-
-    if (max_matches > abs_max)
-	max_matches = abs_max;
+    max_matches = find_oligo_max_matches(io, num_contigs, contig_array,
+					 &max_clen);
 
     if (NULL == (pos1 = (int *)xmalloc((max_matches + 1) * sizeof(int ))))
 	goto error;
@@ -966,22 +1028,10 @@ find_oligos(GapIO *io,
 	goto error;
 
     /* save consensus for each contig */
-    if (NULL == (cons_array = (char **)xmalloc(num_contigs * sizeof(char *))))
+    if (NULL == (cons_array = find_oligo_consensus(io, num_contigs,
+						   contig_array)))
 	goto error;
 
-    for (i = 0; i < num_contigs; i++) {
-	seq_len = contig_array[i].end - contig_array[i].start + 1;
-	if (NULL == (cons_array[i] = (char *)xmalloc(seq_len + 1)))
-	    goto error;
-
-	calc_consensus(contig_array[i].contig,
-		       contig_array[i].start, contig_array[i].end,
-		       CON_SUM, cons_array[i],
-		       NULL, NULL, NULL, consensus_cutoff, quality_cutoff,
-		       database_info, io);
-	cons_array[i][seq_len] = '\0';
-    }
-
     /* do match on either tag(s) or string */
     if (string && *string) {
 	n_matches = StringMatch(io, num_contigs, contig_array,
@@ -1002,11 +1052,7 @@ find_oligos(GapIO *io,
 	    goto error;
     }
 
-    for (i = 0; i < num_contigs; i++) {
-	if (cons_array[i])
-	    xfree(cons_array[i]);
-    }
-    xfree(cons_array);
+    free_oligo_consensus(cons_array, num_contigs);
     xfree(c1);
     xfree(c2);
     xfree(pos1);
@@ -1021,7 +1067,7 @@ find_oligos(GapIO *io,
     if (c2)
 	xfree(c2);
     if (cons_array)
-	xfree(cons_array);
+	free_oligo_consensus(cons_array, num_contigs);
     if (pos1)
 	xfree(pos1);
     if (pos2)
@@ -1036,7 +1082,170 @@ find_oligos(GapIO *io,
 
 
 /*
- * Wrapper around find_oligos() to look for all oligos listed in a FASTA file.
+ * A match found by find_oligo_file(), stored until all sequences have been
+ * searched.
+ */
+typedef struct {
+    int pos;		/* contig position */
+    int c1, c2;		/* as for RegFindOligo */
+    int rn;		/* reading number, 0 for consensus */
+    int length;		/* padded length of match */
+    int score;
+    char *match;	/* depadded matching sequence, for list_alignment */
+} oligo_hit_t;
+
+/* An oligo from the file, and the matches found so far */
+typedef struct {
+    char *id;
+    char *seq[2];	/* depadded upper case oligo and its complement */
+    int len;
+    int mis_match;	/* number of mismatches allowed */
+    oligo_hit_t *hits;
+    int nhits;
+    int ahits;
+    int too_many;
+} oligo_query_t;
+
+static int add_oligo_hit(oligo_query_t *o, int max_matches, oligo_hit_t *h,
+			 char *match) {
+    if (o->nhits >= max_matches) {
+	verror(ERR_WARN, "find_oligos", "Too many matches");
+	o->too_many = 1;
+	return 0;
+    }
+
+    if (o->nhits >= o->ahits) {
+	oligo_hit_t *tmp;
+	int ahits = o->ahits ? o->ahits * 2 : 16;
+	if (NULL == (tmp = (oligo_hit_t *)xrealloc(o->hits,
+						   ahits * sizeof(*tmp))))
+	    return -1;
+	o->hits = tmp;
+	o->ahits = ahits;
+    }
+
+    if (NULL == (h->match = (char *)xmalloc(o->len + 1)))
+	return -1;
+    strcpy(h->match, match);
+    o->hits[o->nhits++] = *h;
+
+    return 0;
+}
+
+/*
+ * Searches a single sequence for all the oligos at once, adding the hits
+ * that lie within contig_array[i]'s range to each oligo. 'offset' converts
+ * a 1-based position in seq to a contig position.
+ */
+static int oligo_file_match(oligo_query_t *oq, int nq, search_query **sq,
+			    int *max_err, int max_matches,
+			    contig_list_t *contig, int rn, char *seq,
+			    int offset, char *cons_match)
+{
+    search_hit *hits;
+    int nh, i;
+    int seq_len = strlen(seq);
+
+    for (i = 0; i < seq_len; i++)
+	seq[i] = toupper(seq[i]);
+
+    if (-1 == (nh = search_query_multi(sq, 2*nq, seq, seq_len, max_err,
+				       &hits)))
+	return -1;
+
+    for (i = 0; i < nh; i++) {
+	oligo_query_t *o = &oq[hits[i].query / 2];
+	oligo_hit_t h;
+
+	if (o->too_many)
+	    continue;
+
+	h.pos = hits[i].start + 1 + offset;
+	if (h.pos < contig->start || h.pos > contig->end)
+	    continue;
+
+	h.c1 = contig->contig;
+	h.c2 = hits[i].query & 1 ? -contig->contig : contig->contig;
+	h.rn = rn;
+	h.score = o->len - hits[i].n_err;
+	h.length = depad_seq_len(cons_match, &seq[hits[i].start], o->len);
+	if (-1 == add_oligo_hit(o, max_matches, &h, cons_match)) {
+	    xfree(hits);
+	    return -1;
+	}
+    }
+
+    if (hits)
+	xfree(hits);
+
+    return 0;
+}
+
+/*
+ * Reports the matches for one oligo in the order find_oligos() would have
+ * found them; all forward strand matches first.
+ */
+static int oligo_file_report(GapIO *io, oligo_query_t *o) {
+    int *pos1, *score, *length, *c1, *c2;
+    int i, j, c, r;
+    char title[1024];
+    char name1[10];
+
+    vmessage("Sequence search for ID '%s'\n", o->id);
+
+    pos1   = (int *)xmalloc((o->nhits + 1) * sizeof(int));
+    score  = (int *)xmalloc((o->nhits + 1) * sizeof(int));
+    length = (int *)xmalloc((o->nhits + 1) * sizeof(int));
+    c1     = (int *)xmalloc((o->nhits + 1) * sizeof(int));
+    c2     = (int *)xmalloc((o->nhits + 1) * sizeof(int));
+    if (!pos1 || !score || !length || !c1 || !c2) {
+	r = -1;
+	goto out;
+    }
+
+    for (j = c = 0; c < 2; c++) {
+	for (i = 0; i < o->nhits; i++) {
+	    oligo_hit_t *h = &o->hits[i];
+
+	    if ((h->c2 < 0) != c)
+		continue;
+
+	    sprintf(name1, "%d", io_clnbr(io, ABS(h->c1)));
+	    sprintf(title, "Match found with contig %d read #%d "
+		    "in the %c sense",
+		    io_clnbr(io, ABS(h->c2)), h->rn,
+		    h->c2 > 0 ? '+' : '-');
+	    list_alignment(o->seq[c], h->match, "oligo", name1, 1,
+			   h->pos, title);
+
+	    pos1  [j] = h->pos;
+	    c1    [j] = h->c1;
+	    c2    [j] = h->c2;
+	    length[j] = h->length;
+	    score [j] = h->score;
+	    j++;
+	}
+    }
+
+    vmessage("Number of matches found %d \n", j);
+    r = RegFindOligo(io, SEQUENCE, pos1, pos1, score, length, c1, c2, j);
+    vmessage("\n");
+
+ out:
+    if (pos1)   xfree(pos1);
+    if (score)  xfree(score);
+    if (length) xfree(length);
+    if (c1)     xfree(c1);
+    if (c2)     xfree(c2);
+
+    return r;
+}
+
+/*
+ * Looks for all oligos listed in a FASTA file. This gives the same results
+ * as calling find_oligos() for each one, but the consensus is computed
+ * once and each consensus and reading is scanned once for all the oligos
+ * on both strands.
  */
 int
 find_oligo_file(GapIO *io,
@@ -1049,13 +1258,21 @@ find_oligo_file(GapIO *io,
 {
     char **ids;
     int nids;
-    int i;
+    int i, j, nq = 0, max_len = 0, max_matches, max_clen;
     int r = 0; /* ret. code */
+    oligo_query_t *oq = NULL;
+    search_query **sq = NULL;
+    int *max_err = NULL;
+    char **cons_array = NULL;
+    char *cons_match = NULL;
 
     /* Use seq_utils to parse the input file */
     if (0 != get_identifiers(file, &ids, &nids))
 	return -1;
 
+    if (NULL == (oq = (oligo_query_t *)xcalloc(nids + 1, sizeof(*oq))))
+	goto error;
+
     for (i = 0; i < nids; i++) {
 	char *seq;
 	int seq_len;
@@ -1072,16 +1289,133 @@ find_oligo_file(GapIO *io,
 	    continue;
 	}
 
-	vmessage("Sequence search for ID '%s'\n", ids[i]);
-	r |= find_oligos(io, num_contigs, contig_array, mis_match,
-			 seq, consensus_only, in_cutoff);
-	vmessage("\n");
+	/* convert percentage mis-matches into number of mis matches */
+	seq_len = strlen(seq);
+	oq[nq].mis_match = seq_len - (ceil(seq_len * mis_match / 100.));
 
-	if (seq)
+	depad_seq(seq, &seq_len, NULL);
+	if (seq_len == 0) {
 	    xfree(seq);
+	    continue;
+	}
+	for (j = 0; j < seq_len; j++)
+	    seq[j] = toupper(seq[j]);
+
+	oq[nq].id = ids[i];
+	oq[nq].len = seq_len;
+	oq[nq].seq[0] = seq;
+	if (NULL == (oq[nq].seq[1] = (char *)xmalloc(seq_len + 1))) {
+	    xfree(seq);
+	    goto error;
+	}
+	strcpy(oq[nq].seq[1], seq);
+	complement_seq(oq[nq].seq[1], seq_len);
+
+	if (max_len < seq_len)
+	    max_len = seq_len;
+	nq++;
+    }
+
+    if (nq == 0)
+	goto tidy;
+
+    /* Query 2*i is oligo i, 2*i+1 is its complement */
+    if (NULL == (sq = (search_query **)xcalloc(2*nq, sizeof(*sq))))
+	goto error;
+    if (NULL == (max_err = (int *)xmalloc(2*nq * sizeof(int))))
+	goto error;
+    for (i = 0; i < 2*nq; i++) {
+	if (NULL == (sq[i] = search_query_create(oq[i/2].seq[i&1],
+						 oq[i/2].len, 0)))
+	    goto error;
+	max_err[i] = oq[i/2].mis_match;
+    }
+
+    if (NULL == (cons_match = (char *)xmalloc(max_len + 1)))
+	goto error;
+
+    max_matches = find_oligo_max_matches(io, num_contigs, contig_array,
+					 &max_clen);
+    if (NULL == (cons_array = find_oligo_consensus(io, num_contigs,
+						   contig_array)))
+	goto error;
+
+    for (i = 0; i < num_contigs; i++) {
+	int rn;
+
+	/* Consensus first, followed by the readings in that contig */
+	if (-1 == oligo_file_match(oq, nq, sq, max_err, max_matches,
+				   &contig_array[i], 0, cons_array[i],
+				   contig_array[i].start - 1, cons_match))
+	    goto error;
+
+	for (rn = consensus_only ? 0 : io_clnbr(io, contig_array[i].contig);
+	     rn;
+	     rn = io_rnbr(io, rn)) {
+	    GReadings r;
+	    char *seq_alloc, *seq;
+	    int offset, err;
+
+	    gel_read(io, rn, r);
+
+	    /* Basic bounds checking to optimise */
+	    if (r.position > contig_array[i].end)
+		break;
+	    if (r.position + r.sequence_length < contig_array[i].start)
+		continue;
+
+	    if (NULL == (seq_alloc = (char *)TextAllocRead(io, r.sequence)))
+		continue;
+	    if (in_cutoff) {
+		seq = seq_alloc;
+		offset = r.position-1 - r.start;
+	    } else {
+		seq = seq_alloc + r.start;
+		seq_alloc[r.end-1] = 0;
+		offset = r.position-1;
+	    }
+
+	    err = oligo_file_match(oq, nq, sq, max_err, max_matches,
+				   &contig_array[i], rn, seq, offset,
+				   cons_match);
+	    xfree(seq_alloc);
+	    if (err)
+		goto error;
+	}
     }
 
+    for (i = 0; i < nq; i++)
+	r |= oligo_file_report(io, &oq[i]);
+
+    goto tidy;
+
+ error:
+    r = -1;
+
+ tidy:
     /* Tidy up memory */
+    if (cons_array)
+	free_oligo_consensus(cons_array, num_contigs);
+    if (cons_match)
+	xfree(cons_match);
+    if (sq) {
+	for (i = 0; i < 2*nq; i++)
+	    search_query_destroy(sq[i]);
+	xfree(sq);
+    }
+    if (max_err)
+	xfree(max_err);
+    if (oq) {
+	for (i = 0; i < nq; i++) {
+	    for (j = 0; j < oq[i].nhits; j++)
+		xfree(oq[i].hits[j].match);
+	    if (oq[i].hits)
+		xfree(oq[i].hits);
+	    xfree(oq[i].seq[0]);
+	    xfree(oq[i].seq[1]);
+	}
+	xfree(oq);
+    }
     for (i = 0; i < nids; i++) {
 	xfree(ids[i]);
     }
@@ -13,6 +13,7 @@ proc DBClose {} {
 	close_db -io $io
 	set io 0
     }
+    trace_cache_flush
 
     DisableMenu_Open
 }
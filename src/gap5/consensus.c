@@ -995,6 +995,9 @@ static double e_tab_a[1002];
 static double *e_tab = &e_tab_a[500];
 static double e_log[501];
 
+/* Phred quality to probability of error */
+static double q2p[101];
+
 static void consensus_init(double p_het) {
     int i;
     double acc = 0;
@@ -1046,6 +1049,25 @@ static void consensus_init(double p_het) {
     pMM[0] = pMM[1];
     p__[0] = p__[1];
     p_M[0] = p_M[1];
+
+    for (i = 0; i <= 100; i++)
+	q2p[i] = pow(10, -i/10.0);
+}
+
+/*
+ * Fills out the tables used by the consensus algorithms. This is done up
+ * front by gio_open() rather than on first use, so nothing computing a
+ * consensus ever needs to check or build them. Later opens, eg of a second
+ * database, leave the tables alone as they may be in use.
+ */
+void consensus_tables_init(void) {
+    static int done = 0;
+
+    if (done)
+	return;
+
+    consensus_init(P_HET);
+    done = 1;
 }
 
 /* 
@@ -1103,9 +1125,6 @@ int calculate_consensus_bit_het(GapIO *io, tg_rec contig,
 				consensus_t *cons) {
     int i, j;
     int len = end - start + 1;
-    static int loop = 0;
-    static int init_done =0;
-    static double q2p[101];
     double min_e_exp = DBL_MIN_EXP * log(2) + 1;
 
     double (*scores)[15];
@@ -1125,15 +1144,6 @@ int calculate_consensus_bit_het(GapIO *io, tg_rec contig,
 			                 18, 19,
 			                     24};
 
-    if (!init_done) {
-	init_done = 1;
-	consensus_init(P_HET);
-
-	for (i = 0; i <= 100; i++) {
-	    q2p[i] = pow(10, -i/10.0);
-	}
-    }
-
     /* Currently always needed for the N vs non-N evaluation */
     flags |= CONS_COUNTS;
 
@@ -1297,11 +1307,9 @@ int calculate_consensus_bit_het(GapIO *io, tg_rec contig,
     }
 
     /* Determine valid ranges, if necessary */
-    if ((flags & CONS_NO_END_N) && depth[0] == 0 && loop == 0) {
+    if ((flags & CONS_NO_END_N) && depth[0] == 0) {
 	/* Check left edge */
-	loop = 1;
 	consensus_valid_range(io, contig, &vst, NULL);
-	loop = 0;
 	if (vst > start) {
 	    vst -= start;
 	} else {
@@ -1311,11 +1319,9 @@ int calculate_consensus_bit_het(GapIO *io, tg_rec contig,
 	vst = 0;
     }
 
-    if ((flags & CONS_NO_END_N) && depth[len-1] == 0 && loop == 0) {
+    if ((flags & CONS_NO_END_N) && depth[len-1] == 0) {
 	/* Check right edge */
-	loop = 1;
 	consensus_valid_range(io, contig, NULL, &ven);
-	loop = 0;
 	if (ven > start) {
 	    ven -= start;
 	} else {
@@ -1831,8 +1837,6 @@ int update_uniqueness_hash(GapIO *io) {
     size_t cons_l = 0;
     uint32_t w, W;
 
-    consensus_init(P_HET);
-
     memset(uhash, 0, WSIZE);
 
     for (cnum = 0; cnum < io->db->Ncontigs; cnum++) {
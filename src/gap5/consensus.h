@@ -73,6 +73,13 @@ int calculate_consensus(GapIO *io, tg_rec contig, int start, int end,
 int calculate_consensus_fast(GapIO *io, tg_rec contig, int start, int end,
 			     consensus_t *cons);
 
+/*
+ * Fills out the tables used by the consensus algorithms. Called by
+ * gio_open() before any consensus can be computed; only the first call
+ * does anything.
+ */
+void consensus_tables_init(void);
+
 /*
  * Internal function, called by calculate_consensus(). Exposed here for when
  * we already have a rangec_t array loaded so we can avoid recomputing the
@@ -379,7 +379,14 @@ proc io_undo {ed crec} {
     upvar \#0 contigIO_$crec cio
     
     foreach {cmdu cmdr} [lindex [set cio(Undo)] end] break
-    io_undo_exec $ed $crec $cmdu
+
+    # Merge the per-operation LENGTH/CHILD_EDIT events into one each
+    contig_notify_batch -io $cio(base) -job start
+    set err [catch {io_undo_exec $ed $crec $cmdu} msg]
+    contig_notify_batch -io $cio(base) -job end
+    if {$err} {
+	return -code error -errorinfo $::errorInfo $msg
+    }
     #eval $cmdu
     #lappend cio(Redo) [list $cmdu $cmdr]
     set cio(Undo) [lrange $cio(Undo) 0 end-1]
@@ -1098,14 +1105,34 @@ proc editor_lock {w} {
     $ed lock [set ${w}(Lock)]
 }
 
-proc editor_save {w} {
+# Saves every editor in $w, returning the number that failed. In a join
+# editor each save raises its own LENGTH event, so these are batched to
+# reach the other displays once per contig. With stop_on_error set the
+# remaining editors are left unsaved after the first failure.
+proc editor_save_all {w {stop_on_error 0}} {
     upvar \#0 $w opt
 
-    foreach ed $opt(all_editors) {
-	if {[log_call $ed save] != 0} {
-	    bell
+    set failed 0
+    contig_notify_batch -io $opt(io_base) -job start
+    set err [catch {
+	foreach ed $opt(all_editors) {
+	    if {[log_call $ed save] != 0} {
+		bell
+		incr failed
+		if {$stop_on_error} break
+	    }
 	}
+    } msg]
+    contig_notify_batch -io $opt(io_base) -job end
+    if {$err} {
+	return -code error -errorinfo $::errorInfo $msg
     }
+
+    return $failed
+}
+
+proc editor_save {w} {
+    editor_save_all $w
 }
 
 proc editor_join {w} {
@@ -1145,11 +1172,8 @@ proc editor_join {w} {
     if {$ret == "cancel"} return
 
     if {$ret == "yes"} {
-	foreach ed $opt(all_editors) {
-	    if {[log_call $ed save] != 0} {
-		bell
-		return
-	    }
+	if {[editor_save_all $w 1] != 0} {
+	    return
 	}
 	set ed [lindex $opt(all_editors) 0]
 
@@ -571,9 +571,10 @@ static void redraw_depth_image(DepthTrackItem *dti, Display *display) {
     /* clear the pixmap */
     XFillRectangle(display, dti->pm, dti->copy, 0, 0, dti->width, dti->height);
     
-    // use some values beyond the window size.
-    working_wx0 = dti->wx0 - tsize;
-    working_wx1 = dti->wx1 + tsize;
+    // use some values beyond the tile holding the window
+    gap_range_tile(dti->wx0, dti->wx1, &working_wx0, &working_wx1);
+    working_wx0 -= tsize;
+    working_wx1 += tsize;
     
     if (gap_range_recalculate(dti->gr, dti->width, working_wx0, working_wx1, dti->gr->template_mode, force_change)) {
 
@@ -5,10 +5,12 @@
 #include <assert.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 
 #include "editor_view.h"
 #include "tkSheet.h"
 #include "tman_interface.h"
+#include "tkTraceIO.h"
 #include "gap_globals.h"
 #include "qualIO.h"
 #include "qual.h"
@@ -125,6 +127,7 @@ edview *edview_new(GapIO *io, tg_rec contig, tg_rec crec, int cpos,
     }
 
     xx->r = NULL;
+    xx->r_win = NULL;
     xx->anno_hash = NULL;
     xx->rec_hash = NULL;
 
@@ -179,6 +182,9 @@ void edview_destroy(edview *xx) {
     if (xx->r)
 	free(xx->r);
 
+    if (xx->r_win)
+	free(xx->r_win);
+
     if (xx->anno_hash)
 	HacheTableDestroy(xx->anno_hash, 0);
     
@@ -1001,9 +1007,68 @@ char *edGetBriefCon(edview *xx, tg_rec crec, int pos, char *format) {
     return status_buf;
 }
 
+/*
+ * Copies the items in xx->r_win overlapping start..end into xx->r.
+ *
+ * The Y coordinates were allocated over the whole cached window, so rows
+ * holding no visible sequence are squeezed out here. The mapping is
+ * monotonic so xx->r stays sorted by Y, and reads keep their relative
+ * rows while we scroll within the window.
+ *
+ * Returns 0 for success
+ *        -1 for failure
+ */
+static int edview_window_items(edview *xx, int start, int end) {
+    int i, n, last_y, y_seq, nrows;
+
+    if (xx->r)
+	free(xx->r);
+    xx->nr = 0;
+    if (NULL == (xx->r = malloc((xx->nr_win+1) * sizeof(*xx->r))))
+	return -1;
+
+    for (i = n = 0; i < xx->nr_win; i++) {
+	if (xx->r_win[i].end < start || xx->r_win[i].start > end)
+	    continue;
+	xx->r[n++] = xx->r_win[i];
+    }
+    xx->nr = n;
+
+    /*
+     * New y is the number of distinct sequence rows above the old one.
+     * Negative Y (consensus tags) is left as is.
+     */
+    last_y = INT_MIN;
+    y_seq = 0;
+    nrows = 0;
+    for (i = 0; i < n; i++) {
+	int y = xx->r[i].y;
+
+	if (y < 0)
+	    continue;
+
+	if (y != last_y) {
+	    nrows += y_seq;
+	    y_seq = 0;
+	    last_y = y;
+	}
+	if ((xx->r[i].flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ)
+	    y_seq = 1;
+
+	xx->r[i].y = nrows;
+    }
+
+    return 0;
+}
+
 /*
  * Populates the cache of visible items in xx->r and xx->nr.
  *
+ * The range query is made over a window one screen wider each side than
+ * requested and kept in xx->r_win, so scrolling only needs to re-cut the
+ * visible items from it. Edits are spotted via the contig timestamp;
+ * freeing xx->r also forces a reload.
+ *
  * Returns 0 for success
  *        -1 for failure
  */
@@ -1013,26 +1078,50 @@ int edview_visible_items(edview *xx, int start, int end) {
     int mode = xx->ed->stack_mode
 	? CSIR_ALLOCATE_Y_MULTIPLE
 	: CSIR_ALLOCATE_Y_SINGLE;
+    int reload;
 
     if (NULL == c) return -1;
 
     /* sort... */
     mode |= CSIR_DEFAULT;
-    
-    /* Always reload for now as we can't spot edits yet */
-    if (xx->r && xx->r_start == start && xx->r_end == end)
+
+    reload = !xx->r || !xx->r_win ||
+	xx->r_win_cnum != xx->cnum ||
+	xx->r_win_mode != mode ||
+	xx->r_win_timestamp != c->timestamp;
+
+    if (!reload && xx->r_start == start && xx->r_end == end)
 	return 0;
-	
-    /* Query sequences */
-    if (xx->r)
-	free(xx->r);
-	
+
+    if (reload || start < xx->r_win_start || end > xx->r_win_end) {
+	int margin = end - start + 1;
+
+	/* Query sequences */
+	if (xx->r_win)
+	    free(xx->r_win);
+
+	xx->r_win_start = start - margin;
+	xx->r_win_end = end + margin;
+	xx->r_win_cnum = xx->cnum;
+	xx->r_win_mode = mode;
+	xx->r_win_timestamp = c->timestamp;
+	xx->r_win = contig_items_in_range(xx->io, &c, &xx->sort_settings,
+					  xx->r_win_start, xx->r_win_end,
+					  CSIR_SORT_BY_Y | mode, CSIR_DEFAULT,
+					  &xx->nr_win);
+	if (!xx->r_win) {
+	    if (xx->r)
+		free(xx->r);
+	    xx->r = NULL;
+	    xx->nr = xx->nr_win = 0;
+	    return -1;
+	}
+    }
+
     xx->r_start = start;
     xx->r_end = end;
-    xx->r = contig_items_in_range(xx->io, &c, &xx->sort_settings, start, end,
-				  CSIR_SORT_BY_Y | mode, CSIR_DEFAULT,
-				  &xx->nr);
-    if (!xx->r) {
+    if (edview_window_items(xx, start, end) == -1) {
+	xx->r = NULL;
 	xx->nr = 0;
 	return -1;
     }
@@ -2221,6 +2310,13 @@ int set_displayPos(edview *xx, int pos) {
 	    xx->refresh_flags |= ED_DISP_YSCROLL;
 	}
 
+	/*
+	 * A purely sideways scroll keeps most of the sheet, so shift what is
+	 * already drawn; the redraw below then only paints the new columns.
+	 */
+	if (xx->ed && !(xx->refresh_flags & ED_DISP_YSCROLL))
+	    XawSheetScrollColumns(&xx->ed->sw, -delta);
+
 	xx = (xx->link && xx->link->locked)
 	    ? xx->link->xx[1] : NULL;
     }
@@ -3111,6 +3207,40 @@ int inJoinMode(edview *xx) {
     return xx->link ? 1 : 0;
 }
 
+/*
+ * Queues the traces of the sequences on the rows just above and below
+ * 'rec' for decoding when idle, so moving the cursor on to them does not
+ * then wait on the disk.
+ */
+static void edview_prefetch_traces(edview *xx, tg_rec rec) {
+    HacheItem *hi;
+    int i, y;
+
+    if (!xx->rec_hash || !xx->r)
+	return;
+    if (!(hi = HacheTableSearch(xx->rec_hash, (char *)&rec, sizeof(rec))))
+	return;
+    if ((y = xx->r[hi->data.i].y) < 0)
+	return;
+
+    for (i = edview_binary_search_y(xx->r, xx->nr, y-1);
+	 i < xx->nr && xx->r[i].y <= y+1; i++) {
+	seq_t *s;
+
+	if (xx->r[i].y == y ||
+	    (xx->r[i].flags & GRANGE_FLAG_ISMASK) != GRANGE_FLAG_ISSEQ)
+	    continue;
+
+	s = cache_search(xx->io, GT_Seq, xx->r[i].rec);
+	if (NULL == s ||
+	    s->seq_tech == STECH_SOLEXA ||
+	    s->seq_tech == STECH_SOLID)
+	    continue;
+
+	trace_prefetch(sequence_get_name(&s), "anytr");
+    }
+}
+
 void edDisplayTrace(edview *xx) {
     seq_t *s;
 
@@ -3124,6 +3254,7 @@ void edDisplayTrace(edview *xx) {
 			  1, /* base spacing */
 			  sequence_get_name(&s),
 			  xx, xx->cursor_rec, 0, 0);
+	edview_prefetch_traces(xx, xx->cursor_rec);
     } else if (xx->cursor_type == GT_Contig) {
 	/* Consensus click */
 	rangec_t *r;
@@ -3582,7 +3713,11 @@ void edview_set_sort_order(edview *xx) {
     	contig_set_default_sort(&linked->sort_settings, linked->ed->group_primary, linked->ed->group_secondary);
     }
     
-    if (xx->r) xx->r_start = xx->r_end; // force re-calc in edview_visible_items
+    /* force re-calc in edview_visible_items */
+    if (xx->r_win) {
+	free(xx->r_win);
+	xx->r_win = NULL;
+    }
 }
 
 int depad_and_opos(char *str, int len, char *depad, int *opos) {
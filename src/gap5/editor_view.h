@@ -101,6 +101,18 @@ typedef struct _edview {
     int r_start, r_end;
     /* FIXME: add cached index into r[] foreach row[y], as it's sorted on y */
 
+    /*
+     * Wider window of items that xx->r is cut from, so scrolling within
+     * it needs no new range query. Reloaded when the view leaves it or
+     * when the contig timestamp, contig or stacking mode changes.
+     */
+    rangec_t *r_win;
+    int nr_win;
+    int r_win_start, r_win_end;
+    int r_win_timestamp;
+    int r_win_mode;
+    tg_rec r_win_cnum;
+
     /* Maps r[i].anno.obj_rec to i */
     HacheTable *anno_hash;
 
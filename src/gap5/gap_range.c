@@ -102,6 +102,9 @@ static int tcl_range(ClientData clientData, Tcl_Interp *interp,
     gr->template_mode = -1;
     gr->width         = -1;
     gr->ntl           = -1;
+    gr->timestamp     = -1;
+    gr->ax            = 0;
+    gr->bx            = 0;
     set_filter(gr, -1, -1, -1, -1, -1);
     update_filter(gr);
     
@@ -200,15 +203,18 @@ int gap_range_recalculate(gap_range_t *gr, int width, double new_wx0,
     int changed = 0;
     contig_t *c;
 
+    c = cache_search(gr->io, GT_Contig, gr->crec);
+    if (NULL == c) goto fail;
+
     /* only change if needed or if force is true */
     if (force || gr->r == NULL
 	|| new_wx0 != gr->wx0 || new_wx1 != gr->wx1
 	|| new_mode != gr->template_mode || gr->width != width
-	|| gr->new_filter.accuracy != gr->old_filter.accuracy) {
+	|| gr->new_filter.accuracy != gr->old_filter.accuracy
+	|| c->timestamp != gr->timestamp) {
 
-	c = cache_search(gr->io, GT_Contig, gr->crec);
-	if (NULL == c) goto fail;
 	cache_incr(gr->io, c);
+	gr->timestamp = c->timestamp;
 
     	if (gr->r) free(gr->r);
 	gr->r = contig_seqs_in_range(gr->io, &c, new_wx0, new_wx1,
@@ -257,10 +263,13 @@ int gap_range_x(gap_range_t *gr, double ax_conv, double bx_conv,
     int lib_type;
     HacheTable *h;
 
-    if (!is_filter_change(gr) && !force)
+    if (!is_filter_change(gr) && !force &&
+	ax_conv == gr->ax && bx_conv == gr->bx)
 	return gr->ntl;
 
     update_filter(gr);
+    gr->ax = ax_conv;
+    gr->bx = bx_conv;
     gr->ntl = 0;
     memset(gr->depth, 0, gr->width * sizeof(gap_depth_t));
 
@@ -529,6 +538,24 @@ int gap_range_x(gap_range_t *gr, double ax_conv, double bx_conv,
 
 
 
+/*
+    Computes the tile holding the view wx0 to wx1. The grid is one view
+    wide, so the view always lies inside the tile with at least a view's
+    width to spare on the left. The grid is rounded so that rounding
+    noise in wx0/wx1 while panning doesn't change it; the extra base on
+    the right covers the half base this may lose.
+*/
+void gap_range_tile(double wx0, double wx1, double *tx0, double *tx1) {
+    double grid = floor(wx1 - wx0 + 0.5);
+
+    if (grid < 1)
+	grid = 1;
+
+    *tx0 = (floor(wx0 / grid) - 1) * grid;
+    *tx1 = *tx0 + GR_TILE_SPAN * grid + 1;
+}
+
+
 /*
     reset to starting values, free any memory
     leave the gap and contig values
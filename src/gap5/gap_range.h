@@ -51,6 +51,8 @@ typedef struct {
     gap_filter_t new_filter; // new filter settings
     gap_depth_t  *depth;     // store depth
     tg_rec crec;
+    int timestamp;           // contig timestamp when r was fetched
+    double ax, bx;           // world to raster values used for depth
 } gap_range_t;
 
 /* If bit set we filter our this data type */
@@ -64,6 +66,13 @@ typedef struct {
 /* Add i.size + 3sd to window size for read pairing. This is the max size */
 #define GR_WINDOW_RANGE 40000
 
+/*
+ * Range queries are snapped to tiles this many view widths wide, aligned
+ * on a grid of one view width, so panning within a tile re-uses both the
+ * query and anything drawn from it.
+ */
+#define GR_TILE_SPAN 3
+
 /* Global gap range_option */
 extern Tk_CustomOption range_option;
 
@@ -72,6 +81,7 @@ void gap_range_destroy(gap_range_t *gr);
 int  gap_range_test(gap_range_t *gr);
 int  gap_range_recalculate(gap_range_t *gr, int width, double new_wx0, double new_wx1, int new_mode, int force); 
 void gap_range_reset(gap_range_t *gr);
+void gap_range_tile(double wx0, double wx1, double *tx0, double *tx1);
 void set_filter(gap_range_t *gr, int filter, int min, int max, int mode, int accuracy);
 int  gap_range_x(gap_range_t *gr, double ax_conv, double bx_conv, 
 		 int forward_col, int reverse_col, int single_col,
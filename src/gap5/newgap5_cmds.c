@@ -2565,6 +2565,10 @@ NewGap_Init(Tcl_Interp *interp) {
     Tcl_CreateObjCommand(interp, "contig_notify", tk_contig_notify,
 			 (ClientData) NULL,
 			 NULL);
+    Tcl_CreateObjCommand(interp, "contig_notify_batch",
+			 tk_contig_notify_batch,
+			 (ClientData) NULL,
+			 NULL);
     Tcl_CreateObjCommand(interp, "result_notify", tk_result_notify,
 			 (ClientData) NULL,
 			 NULL);
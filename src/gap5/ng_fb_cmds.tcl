@@ -30,6 +30,7 @@ proc DBClose {} {
 	$io close
 	set io ""
     }
+    trace_cache_flush
     
     DisableMenu_Open
 }
@@ -403,6 +403,28 @@ HashTable *create_lib_hash(tg_rec *library, int nlibrary) {
     return lib_hash;
 }
 
+/*
+ * Returns true if the cached pair_{contig,start,end,mqual} fields of r
+ * are known to be current, using the same timestamp rules as
+ * sequence_get_range_pair_position(). Nothing is loaded or updated.
+ */
+static int pair_cache_valid(GapIO *io, rangec_t *r) {
+    contig_t *c;
+
+    if (!r->pair_rec || !r->pair_contig)
+	return 0;
+
+    io = gio_base(io);
+    if (r->pair_timestamp == io->db->timestamp)
+	return 1;
+
+    if (!cache_exists(io, GT_Contig, r->pair_contig))
+	return 0;
+
+    c = cache_search(io, GT_Contig, r->pair_contig);
+    return c && r->pair_timestamp >= c->timestamp;
+}
+
 /*
  * Identifies spanning read pairs within end_size of the end of each contig.
  * Library/nlibrary is used to filter read-pairs as coming only from specific
@@ -524,6 +546,15 @@ read_pair_t *spanning_pairs(GapIO *io, int num_contigs,
 	    if (large_contig && r->start - cstart > 2*end_size)
 		break;
 
+	    /*
+	     * For end vs end nothing past end_size can be added. Going on
+	     * to 2*end_size only weeds out internal pairs early, which the
+	     * pairing below rejects anyway.
+	     */
+	    if (large_contig && mode == end_end &&
+		r->start - cstart >= end_size)
+		break;
+
 	    if ((hi = HashTableSearch(h, (char *)&r->pair_rec,
 				      sizeof(r->pair_rec)))) {
 		rangec_t *r2 = hi->data.p;
@@ -535,6 +566,10 @@ read_pair_t *spanning_pairs(GapIO *io, int num_contigs,
 		}
 	    }
 
+	    /* Mate known to be in this contig too, so never spanning */
+	    if (r->pair_contig == crec && pair_cache_valid(io, r))
+		continue;
+
 	    if (mode == all_all || mode == end_all ||
 		r->start - cstart < end_size || cend - r->start < end_size) {
 		HashData hd;
@@ -544,9 +579,9 @@ read_pair_t *spanning_pairs(GapIO *io, int num_contigs,
 		r2->orig_rec = crec; /* convenient place to store contig */
 		if (r->start - cstart < end_size ||
 		    cend - r->start < end_size)
-		    r2->pair_start = 1; /* near end */
+		    r2->pair_ind = 1; /* near end */
 		else
-		    r2->pair_start = 0;
+		    r2->pair_ind = 0;
 		hd.p = r2;
 
 		if (!HashTableAdd(h, (char *)&r->rec, sizeof(r->rec),
@@ -559,7 +594,10 @@ read_pair_t *spanning_pairs(GapIO *io, int num_contigs,
 	/* Other end, if not yet done (for large contigs) */
 	if (large_contig) {
 	    ci = contig_iter_new(io, crec, 1, CITER_FIRST,
-				 MAX(cstart, cend - 2*end_size), CITER_CEND);
+				 MAX(cstart, cend - (mode == end_end
+						     ? end_size
+						     : 2*end_size)),
+				 CITER_CEND);
 	    if (NULL == ci) goto fail;
 
 	    while (NULL != (r = contig_iter_next(io, ci))) {
@@ -587,6 +625,9 @@ read_pair_t *spanning_pairs(GapIO *io, int num_contigs,
 		    }
 		}
 
+		if (r->pair_contig == crec && pair_cache_valid(io, r))
+		    continue;
+
 		if (mode == end_all || cend - r->start < end_size) {
 		    HashData hd;
 		    rangec_t *r2 = pool_alloc(rp_pool);
@@ -595,9 +636,9 @@ read_pair_t *spanning_pairs(GapIO *io, int num_contigs,
 		    r2->orig_rec = crec;
 		    if (r->start - cstart < end_size ||
 			cend - r->start < end_size)
-			r2->pair_start = 1; /* near end */
+			r2->pair_ind = 1; /* near end */
 		    else
-			r2->pair_start = 0;
+			r2->pair_ind = 0;
 		    hd.p = r2;
 
 		    if (!HashTableAdd(h, (char *)&r->rec, sizeof(r->rec),
@@ -639,17 +680,45 @@ read_pair_t *spanning_pairs(GapIO *io, int num_contigs,
 	if (!(hi = HashTableSearch(h, (char *)&rec2, sizeof(rec1)))) {
 	    tg_rec contig;
 	    int start, end, orient;
+	    range_t r_out;
+	    contig_t *c2;
 
 	    if (mode != end_all || no_large_contigs)
 		continue; // unpaired
 
-	    /* Maybe rec2 was in a large contig that we didn't scan through */
-	    sequence_get_position(io, rec2, &contig, &start, &end, &orient);
+	    /*
+	     * Maybe rec2 was in a large contig that we didn't scan through.
+	     * Finding it means loading the sequence, so first reject what
+	     * we can from the mate data cached in r1.
+	     */
+	    if (pair_cache_valid(io, r1)) {
+		if (r1->pair_contig == r1->orig_rec ||
+		    r1->mqual < min_mq || r1->pair_mqual < min_mq)
+		    continue;
+
+		if (!r1->pair_ind) {
+		    c2 = cache_search(io, GT_Contig, r1->pair_contig);
+		    if (c2 &&
+			r1->pair_start - c2->start >= end_size &&
+			c2->end - r1->pair_start >= end_size)
+			continue;
+		}
+	    }
+
+	    if (bin_get_item_position(io, GT_Seq, rec2, &contig, &start, &end,
+				      &orient, NULL, &r_out, NULL))
+		continue;
 	    r2 = &r2_tmp;
 	    r2->rec = rec2;
 	    r2->orig_rec = contig;
 	    r2->start = start;
 	    r2->end = end;
+	    r2->mqual = r_out.mqual;
+	    r2->flags = r_out.flags;
+	    r2->comp = orient;
+	    c2 = cache_search(io, GT_Contig, contig);
+	    r2->pair_ind = c2 &&
+		(start - c2->start < end_size || c2->end - start < end_size);
 	} else {
 	    r2 = (rangec_t *)hi->data.p;
 	}
@@ -659,7 +728,7 @@ read_pair_t *spanning_pairs(GapIO *io, int num_contigs,
 	    /* Same contig */
 	    continue;
 
-	if (mode == end_all && !(r1->pair_start || r2->pair_start))
+	if (mode == end_all && !(r1->pair_ind || r2->pair_ind))
 	    /* Spanning pair, but not with a match near an end */
 	    continue;
 
@@ -96,6 +96,7 @@ void print_moverlap(MALIGN *malign, MOVERLAP *o, int offset);
 void malign_padcon(MALIGN *malign, int pos, int size, Array indels) {
     CONTIGL *cl = malign->contigl;
     con_indel_t *id;
+    int depth = 0, old_len = malign->length;
 
     id = ARRP(con_indel_t, indels, ArrayMax(indels));
     id->pos = pos;
@@ -121,9 +122,20 @@ void malign_padcon(MALIGN *malign, int pos, int size, Array indels) {
 		cl->mseg->length-size - (pos - cl->mseg->offset));
 	memset(&cl->mseg->seq[pos - cl->mseg->offset], '*', size);
 	cl->mseg->seq[cl->mseg->length] = 0;
+	depth++;
     }
 
     malign_insert_scores(malign, pos, size);
+
+    /*
+     * The new columns hold only the pads we inserted, so we can fill
+     * them out directly rather than recounting from the contigl list.
+     * Appending beyond the end is rare and handled the slow way.
+     */
+    if (pos >= old_len)
+	malign_recalc_scores(malign, old_len-1, malign->length-1);
+    else
+	malign_set_pad_columns(malign, pos, size, depth);
 }
 
 /*
@@ -485,13 +497,12 @@ MALIGN *realign_seqs(int contig, MALIGN *malign, int band, Array indels) {
 	// TODO
 
 
-	/* Update the malign structure */
-	if (npads > 0) {
-	    malign_recalc_scores(malign,
-				 MIN(old_start, new_start),
-				 MAX(old_end, new_end));
-	}
-	    
+	/*
+	 * The malign structure is already up to date: malign_padcon
+	 * fills out the new pad columns and malign_add_contigl applies
+	 * this sequence's own counts as a delta.
+	 */
+
 	/* TODO:
 	 *
 	 * X Realloc malign->consensus / malign->score
@@ -569,29 +580,24 @@ MALIGN *realign_seqs(int contig, MALIGN *malign, int band, Array indels) {
     return malign;
 }
 
-/**
- * Builds and returns MALIGN from a Gap5 IO handle for the contig 'cnum'.
+/*
+ * Expands start and end to the range covered by the clipped portions of
+ * the sequences overlapping them. Either pointer may be NULL.
  */
-MALIGN *build_malign(GapIO *io, tg_rec cnum, int start, int end) {
-    CONTIGL *contig, *first_contig = NULL, *last_contig = NULL;
-    int i, j;
+static void malign_expand_range(GapIO *io, tg_rec cnum, int *start, int *end) {
     contig_iterator *citer;
     rangec_t *r;
+    seq_t *s;
 
-    /* Expand start and end to the range covered by seqs overlapping
-     * start .. end
-     */
-
-    {
-	seq_t *s;
+    if (start) {
 	citer = contig_iter_new(io, cnum, 0,
 				CITER_FIRST | CITER_ICLIPPEDSTART,
-				start, start);
+				*start, *start);
 	r = contig_iter_next(io, citer);
 	if (r) {
 	    s = cache_search(io, GT_Seq, r->rec);
 
-	    start = ((s->len < 0) ^ r->comp)
+	    *start = ((s->len < 0) ^ r->comp)
 		? r->end - s->right - 2
 		: r->start + s->left - 2;
 	}
@@ -599,22 +605,38 @@ MALIGN *build_malign(GapIO *io, tg_rec cnum, int start, int end) {
 	contig_iter_del(citer);
     }
 
-    {
-	seq_t *s;
+    if (end) {
 	citer = contig_iter_new(io, cnum, 0,
 				CITER_LAST | CITER_ICLIPPEDEND,
-				end, end);
+				*end, *end);
 	r = contig_iter_next(io, citer);
 	if (r) {
 	    s = cache_search(io, GT_Seq, r->rec);
 
-	    end = ((s->len < 0) ^ r->comp)
+	    *end = ((s->len < 0) ^ r->comp)
 		? r->end - s->left + 2
 		: r->start + s->right + 2;
 	}
 
 	contig_iter_del(citer);
     }
+}
+
+/**
+ * Builds and returns MALIGN from a Gap5 IO handle for the contig 'cnum'.
+ *
+ * Returns NULL on failure or if no sequences overlap start..end.
+ */
+MALIGN *build_malign(GapIO *io, tg_rec cnum, int start, int end) {
+    CONTIGL *contig, *first_contig = NULL, *last_contig = NULL;
+    int i, j;
+    contig_iterator *citer;
+    rangec_t *r;
+
+    /* Expand start and end to the range covered by seqs overlapping
+     * start .. end
+     */
+    malign_expand_range(io, cnum, &start, &end);
     
     //printf("Generating data for %d..%d\n", start, end);
 
@@ -681,6 +703,9 @@ MALIGN *build_malign(GapIO *io, tg_rec cnum, int start, int end) {
     }
     contig_iter_del(citer);
 
+    if (!first_contig)
+	return NULL;
+
     /* for 454 data -6 to -10 seem to work fine */
     return contigl_to_malign(first_contig, -7, -7);
 }
@@ -1413,78 +1438,209 @@ void reassign_confidence_values(GapIO *io, int cnum) {
 #endif
 
 
+/*
+ * Large contigs are realigned in windows of roughly SHUFFLE_WINDOW bases
+ * so that only the reads overlapping one window are held in a MALIGN at
+ * any one time. Each window boundary is chosen from the following
+ * SHUFFLE_WINDOW_SLOP bases as the column with lowest depth (preferring
+ * confident non-pad consensus calls), so few reads straddle two windows.
+ */
+#define SHUFFLE_WINDOW      10000
+#define SHUFFLE_WINDOW_SLOP 2000
+
+/*
+ * Picks the window boundaries for realigning contig 'cnum' between start
+ * and end. The inclusive end coordinate of each window is appended to
+ * 'bp' in ascending order, with the final element always being 'end'.
+ *
+ * Returns 0 on success,
+ *        -1 on failure
+ */
+static int shuffle_breakpoints(GapIO *io, tg_rec cnum, int start, int end,
+			       Array bp) {
+    consensus_t *cons;
+    int pos = start;
+
+    if (NULL == (cons = malloc(SHUFFLE_WINDOW_SLOP * sizeof(*cons))))
+	return -1;
+
+    while (end - pos + 1 > SHUFFLE_WINDOW + SHUFFLE_WINDOW_SLOP) {
+	int from = pos + SHUFFLE_WINDOW;
+	int to   = from + SHUFFLE_WINDOW_SLOP - 1;
+	int j, best = 0, best_depth = INT_MAX, best_phred = -1;
+
+	if (0 != calculate_consensus(io, cnum, from, to, cons)) {
+	    free(cons);
+	    return -1;
+	}
+
+	for (j = 0; j <= to - from; j++) {
+	    if (cons[j].call == 4)
+		continue;
+
+	    if (cons[j].depth < best_depth ||
+		(cons[j].depth == best_depth && cons[j].phred > best_phred)) {
+		best       = j;
+		best_depth = cons[j].depth;
+		best_phred = cons[j].phred;
+	    }
+	}
+
+	pos = from + best;
+	ARR(int, bp, ArrayMax(bp)) = pos++;
+    }
+
+    ARR(int, bp, ArrayMax(bp)) = end;
+    free(cons);
+
+    return 0;
+}
+
+/*
+ * Realigns the sequences in contig 'cnum' overlapping start..end,
+ * iterating until the consensus difference score stops improving, and
+ * then writes any edits back to the database.
+ *
+ * The original, final and maximum scores are returned in orig_p, new_p
+ * and tot_p.
+ *
+ * Returns 0 on success,
+ *        -1 on failure
+ */
+static int shuffle_window(GapIO *io, tg_rec cnum, int start, int end,
+			  int band, Array indels, int64_t *orig_p,
+			  int64_t *new_p, int64_t *tot_p) {
+    int64_t old_score, new_score, tot_score, orig_score;
+    MALIGN *malign;
+    int c_start, c_shift, orig_len;
+
+    *orig_p = *new_p = *tot_p = 0;
+
+    /*
+     * The shuffle pads code (malign) comes from gap4 and has lots of
+     * assumptions that the contig goes from base 1 to base N.
+     * Fixing these assumptions is a lot of work, so for now we will take
+     * the cheat route of moving the contig to ensure the assumption
+     * is valid. We move it so that base 1 is the start of this window
+     * (including the reads overlapping it) to keep the MALIGN small.
+     */
+    c_start = start;
+    malign_expand_range(io, cnum, &c_start, NULL);
+    c_shift = 1-c_start;
+    if (c_shift != 0) {
+	if (move_contig(io, cnum, c_shift) != 0)
+	    return -1;
+    }
+
+    malign = build_malign(io, cnum, start + c_shift, end + c_shift);
+    if (!malign) {
+	/* Nothing to align */
+	return c_shift ? move_contig(io, cnum, -c_shift) : 0;
+    }
+    resort_contigl(malign);
+
+    malign_add_region(malign, start + c_shift, end + c_shift);
+    orig_len = malign->length;
+
+    ArrayMax(indels) = 0;
+    orig_score = new_score = malign_diffs(malign, &tot_score);
+    do {
+	old_score = new_score;
+	malign = realign_seqs(cnum, malign, band, indels);
+	new_score = malign_diffs(malign, &tot_score);
+    } while (new_score < old_score);
+
+    if (new_score < orig_score) {
+	contig_list_t cl;
+
+	update_io(io, cnum, malign, indels);
+
+	/* Remove pad columns, allowing for the consensus having grown */
+	cl.contig = cnum;
+	cl.start  = start + c_shift;
+	cl.end    = end + c_shift + malign->length - orig_len;
+	remove_pad_columns(io, 1, &cl, 100, 1);
+    }
+
+    destroy_malign(malign, 1);
+
+    /* Shift contig back */
+    if (c_shift != 0) {
+	if (move_contig(io, cnum, -c_shift) != 0)
+	    return -1;
+    }
+
+    *orig_p = orig_score;
+    *new_p  = new_score;
+    *tot_p  = tot_score;
+
+    return 0;
+}
+
 int shuffle_contigs_io(GapIO *io, int ncontigs, contig_list_t *contigs,
 		       int band, int flush) {
-    int i; //, start;
-    Array indels;
+    int i, ret = -1;
+    Array indels, bp;
     
     set_malign_lookup(5);
     /* set_alignment_matrix("/tmp/nuc_matrix", "ACGTURYMWSKDHVB-*"); */
 
     indels = ArrayCreate(sizeof(con_indel_t), 0);
+    bp     = ArrayCreate(sizeof(int), 0);
 
     for (i = 0; i < ncontigs; i++) {
 	tg_rec cnum = contigs[i].contig;
-	int64_t old_score, new_score, tot_score, orig_score;
-	//for (start = 0; start < 1000000; start += 1000) {
-	//  MALIGN *malign = build_malign(io, cnum, start, start + 1000);
-	MALIGN *malign;
-	int c_start, c_shift;
+	int64_t new_score = 0, tot_score = 0, orig_score = 0;
+	int w, nwin, nedited = 0;
 
 	vmessage("Shuffling pads for contig %s\n", get_contig_name(io, cnum));
 
-	/*
-	 * The shuffle pads code (malign) comes from gap4 and has lots of
-	 * assumptions that the contig goes from base 1 to base N.
-	 * Fixing these assumptions is a lot of work, so for now we will take
-	 * the cheat route of moving the contig to ensure the assumption
-	 * is valid.
-	 */
-	if (-1 == consensus_valid_range(io, cnum, &c_start, NULL)) {
+	ArrayMax(bp) = 0;
+	if (-1 == shuffle_breakpoints(io, cnum, contigs[i].start,
+				      contigs[i].end, bp)) {
 	    verror(ERR_WARN, "shuffle_contigs_io",
-		   "Failure in consensus_valid_range()");
-	    return -1;
-	}
-	//printf("Contig starts at base %d\n", c_start);
-	c_shift = 1-c_start;
-	if (c_shift != 0) {
-	    if (move_contig(io, cnum, c_shift) != 0)
-		return -1;
+		   "Failed to compute realignment windows");
+	    goto error;
 	}
 
-	//printf("Shuffle #%"PRIrec" from %d..%d, shift %d\n",
-	//       contigs[i].contig, contigs[i].start, contigs[i].end, c_shift);
+	nwin = ArrayMax(bp);
+	if (nwin > 1)
+	    vmessage("Realigning in %d windows\n", nwin);
 
-	malign = build_malign(io, cnum,
-			      contigs[i].start + c_shift,
-			      contigs[i].end   + c_shift);
-	resort_contigl(malign);
+	/*
+	 * Work from right to left. Consensus pads added or removed in one
+	 * window then only move the windows we have already processed.
+	 */
+	for (w = nwin-1; w >= 0; w--) {
+	    int start = w ? arr(int, bp, w-1)+1 : contigs[i].start;
+	    int end   = arr(int, bp, w);
+	    int64_t o, n, t;
 
-	malign_add_region(malign,
-			  contigs[i].start + c_shift,
-			  contigs[i].end + c_shift);
+	    if (-1 == shuffle_window(io, cnum, start, end, band, indels,
+				     &o, &n, &t))
+		goto error;
 
-	ArrayMax(indels) = 0;
-	orig_score = new_score = malign_diffs(malign, &tot_score);
-	vmessage("Initial score %.2f%% mismatches (%"PRId64" mismatches)\n",
-		 (100.0 * orig_score)/tot_score, orig_score/128);
-	if (flush)
-	    UpdateTextOutput();
-	//print_malign(malign);
-	do {
-	    old_score = new_score;
-	    malign = realign_seqs(cnum, malign, band, indels);
-	    //print_malign(malign);
-	    new_score = malign_diffs(malign, &tot_score);
-	    vmessage("  Consensus difference score: %"PRId64"\n", new_score);
+	    if (n < o)
+		nedited++;
+
+	    orig_score += o;
+	    new_score  += n;
+	    tot_score  += t;
+
+	    if (nwin > 1)
+		vmessage("  Window %d..%d: %"PRId64" -> %"PRId64
+			 " mismatches\n", start, end, o/128, n/128);
 	    if (flush)
 		UpdateTextOutput();
-	} while (new_score < old_score);
+	}
 
-	if (new_score < orig_score) {
-	    //print_malign(malign);
-	    update_io(io, cnum, malign, indels);
+	if (!tot_score)
+	    tot_score = 1;
 
+	vmessage("Initial score %.2f%% mismatches (%"PRId64" mismatches)\n",
+		 (100.0 * orig_score)/tot_score, orig_score/128);
+
+	if (nedited) {
 	    /*
 	     * It's possible the contig ends could move if a sequence that
 	     * was previously the end of a contig has been moved such that
@@ -1498,22 +1654,6 @@ int shuffle_contigs_io(GapIO *io, int ncontigs, contig_list_t *contigs,
 	    vmessage("Could not reduce number of consensus differences.\n");
 	}
 
-	/* Remove pad columns */
-	//printf("New score=%d, orig_score=%d\n", new_score, orig_score);
-	if (new_score < orig_score) {
-	    contigs[i].start += c_shift;
-	    contigs[i].end += c_shift;
-	    remove_pad_columns(io, 1, &contigs[i], 100, 1);
-
-	    //contig_t *c;
-	    //c = cache_search(io, GT_Contig, cnum);
-	    //cache_incr(io, c);
-	    //remove_pads(io, malign, c, contigs[i].start, contigs[i].end);
-	    //cache_decr(io, c);
-	}
-
-	destroy_malign(malign, 1);
-
 	vmessage("Final score %.2f%% mismatches\n",
 		 (100.0 * new_score)/tot_score);
 
@@ -1527,21 +1667,19 @@ int shuffle_contigs_io(GapIO *io, int ncontigs, contig_list_t *contigs,
 	// remove_contig_holes(io, cnum);
 
 	/* reassign_confidence_values(io, cnum); */
-      //}
-
-	/* Shift contig back */
-	if (c_shift != 0) {
-	    if (move_contig(io, cnum, -c_shift) != 0)
-		return -1;
-	}
 
+	/* All windows for this contig are written back in one go */
 	if (flush)
 	    cache_flush(io);
     }
 
+    ret = 0;
+
+ error:
     ArrayDestroy(indels);
+    ArrayDestroy(bp);
 
-    return 0;
+    return ret;
 }
 
 /*
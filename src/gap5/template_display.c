@@ -27,6 +27,47 @@
 
 /* Define the template display item */
 
+/*
+ * The settings that change how a template image is drawn. Tiles drawn
+ * with different settings can't be re-used.
+ */
+typedef struct {
+    int logy;
+    int cmode;
+    int ymode;
+    int yoffset;
+    int accuracy;
+    int spread;
+    int reads_only;
+    int sep_by_strand;
+    int filter;
+    int min_qual;
+    int max_qual;
+    int min_sz;
+    double yzoom;
+} td_settings;
+
+/*
+ * A rendered tile GR_TILE_SPAN view widths wide (see gap_range_tile).
+ * Panning within it only needs an XPutImage from the appropriate offset,
+ * and keeping a few around lets zooming back to a previous level
+ * re-use them too.
+ */
+#define TD_NTILES 3
+
+typedef struct {
+    XImage *img;            /* NULL when unused */
+    int width, height;      /* image size */
+    double ax;              /* pixels per base */
+    double tx0, tx1;        /* world X covered */
+    double wy0, wy1;        /* world Y covered */
+    gap_range_t *gr;
+    int timestamp;          /* contig timestamp when drawn */
+    td_settings set;
+    double y_start, y_end;  /* world edges in y, as computed when drawn */
+    int age;                /* for LRU replacement */
+} td_tile;
+
 typedef struct TemplateDisplayItem {
     Tk_Item header; 	    /* mandatory entry */
     GC gc;  	    	    /* graphics context */
@@ -71,6 +112,9 @@ typedef struct TemplateDisplayItem {
     int ntl;
 
     int force_redraw;
+
+    td_tile tile[TD_NTILES];
+    int tile_age;
 } TemplateDisplayItem;
 
 
@@ -109,6 +153,7 @@ static int  initialise_template_image(TemplateDisplayItem *tdi,
 				      Tk_Window tkwin,
 				      Display *display);
 static void redraw_template_image(TemplateDisplayItem *tdi, Display *display);
+static void template_tiles_clear(TemplateDisplayItem *tdi);
 
 
 
@@ -216,6 +261,8 @@ static int create_template(Tcl_Interp *interp,
     tdi->wy1 = tdi->y_end = Tk_Height(Tk_CanvasTkwin(canvas)); /* initial world height */
     tdi->width = -1;
     tdi->height = -1;
+    memset(tdi->tile, 0, TD_NTILES * sizeof(*tdi->tile));
+    tdi->tile_age = 0;
    
     if(initialise_template_image(tdi,
 				 interp,
@@ -354,6 +401,8 @@ static void delete_template(Tk_Canvas canvas, Tk_Item *itemPtr, Display *display
     	Tk_FreeGC(display, tdi->gc);
     }
     
+    template_tiles_clear(tdi);
+
     if (tdi->image != NULL) {
     	image_destroy(tdi->image);
     }
@@ -785,28 +834,144 @@ static int sort_tline_by_x(const void *p1, const void *p2) {
     return r1->x[0] - r2->x[1];
 }
 
+/* tile cache handling */
+
+static void template_settings(TemplateDisplayItem *tdi, td_settings *set) {
+    memset(set, 0, sizeof(*set));
+    set->logy          = tdi->logy;
+    set->cmode         = tdi->cmode;
+    set->ymode         = tdi->ymode;
+    set->yoffset       = tdi->yoffset;
+    set->accuracy      = tdi->accuracy;
+    set->spread        = tdi->spread;
+    set->reads_only    = tdi->reads_only;
+    set->sep_by_strand = tdi->sep_by_strand;
+    set->filter        = tdi->filter;
+    set->min_qual      = tdi->min_qual;
+    set->max_qual      = tdi->max_qual;
+    set->min_sz        = tdi->min_sz;
+    set->yzoom         = tdi->yzoom;
+}
+
+static void template_tiles_clear(TemplateDisplayItem *tdi) {
+    int i;
+
+    for (i = 0; i < TD_NTILES; i++) {
+	if (tdi->tile[i].img)
+	    XDestroyImage(tdi->tile[i].img); // frees the buffer too
+	tdi->tile[i].img = NULL;
+    }
+}
+
+/*
+ * Finds a tile that covers the current view as drawn with the current
+ * settings and data. Returns it with the X offset of the view in *src_x,
+ * or NULL if none.
+ */
+static td_tile *template_tile_find(TemplateDisplayItem *tdi, td_settings *set,
+				   double ax, double tx0, int timestamp,
+				   int *src_x) {
+    int i;
+
+    for (i = 0; i < TD_NTILES; i++) {
+	td_tile *t = &tdi->tile[i];
+	int x;
+
+	if (!t->img ||
+	    t->tx0 != tx0 ||
+	    fabs(t->ax - ax) > ax * 1e-9 ||
+	    t->wy0 != tdi->wy0 || t->wy1 != tdi->wy1 ||
+	    t->height != tdi->height ||
+	    t->gr != tdi->gr ||
+	    t->timestamp != timestamp ||
+	    memcmp(&t->set, set, sizeof(*set)) != 0)
+	    continue;
+
+	x = (tdi->wx0 - t->tx0) * t->ax + 0.5;
+	if (x < 0 || x + tdi->width > t->width)
+	    continue;
+
+	t->age = ++tdi->tile_age;
+	*src_x = x;
+	return t;
+    }
+
+    return NULL;
+}
+
+/* Returns the tile to draw a new image into; unused or least recent */
+static td_tile *template_tile_new(TemplateDisplayItem *tdi) {
+    td_tile *t = &tdi->tile[0];
+    int i;
+
+    for (i = 0; i < TD_NTILES; i++) {
+	if (!tdi->tile[i].img) {
+	    t = &tdi->tile[i];
+	    break;
+	}
+	if (t->age > tdi->tile[i].age)
+	    t = &tdi->tile[i];
+    }
+
+    if (t->img)
+	XDestroyImage(t->img);
+    t->img = NULL;
+    t->age = ++tdi->tile_age;
+
+    return t;
+}
+
 /* do the actual work of drawing the template track, uses the gap_range
-   functions for most of the data handling */
+   functions for most of the data handling.
+
+   Drawing is done into a tile wider than the window (see gap_range_tile)
+   and copied from there to the pixmap, so panning within the tile or
+   returning to a recently used one needs no redrawing. */
    	    
 static void redraw_template_image(TemplateDisplayItem *tdi, Display *display) {
     double working_wx0, working_wx1;
+    double tx0, tx1;
     int force_change = tdi->force_redraw;
     int mode;
     double ax, bx, ay, by;
     int fwd_col, rev_col;
     int half_height;
-    int i;
+    int i, src_x;
     int ymin = INT_MAX;
     int ymax = INT_MIN;
     int tsize = MIN(template_max_size(tdi->gr->io), GR_WINDOW_RANGE);
+    int timestamp;
+    td_settings set;
+    td_tile *t;
+    contig_t *c;
     
     tdi->force_redraw = 0;
     image_remove(tdi->image);
-    if(!create_image_buffer(tdi->image, tdi->width, tdi->height, tdi->background)) return;
 
-    // use some values beyond the window size.
-    working_wx0 = tdi->wx0 - tsize;
-    working_wx1 = tdi->wx1 + tsize;
+    if (force_change)
+	template_tiles_clear(tdi);
+
+    /* world to pixmap conversion values */
+    if (tdi->wx1 - tdi->wx0 == 0) return;
+    
+    ax = tdi->width / (tdi->wx1 - tdi->wx0);
+    
+    ay = tdi->height / (tdi->wy1 - tdi->wy0);
+    by = tdi->wy0;    
+
+    gap_range_tile(tdi->wx0, tdi->wx1, &tx0, &tx1);
+    bx = tx0;
+
+    c = cache_search(tdi->gr->io, GT_Contig, tdi->gr->crec);
+    timestamp = c ? c->timestamp : -1;
+    template_settings(tdi, &set);
+
+    if ((t = template_tile_find(tdi, &set, ax, tx0, timestamp, &src_x)))
+	goto blit;
+
+    // use some values beyond the tile size.
+    working_wx0 = tx0 - tsize;
+    working_wx1 = tx1 + tsize;
  
     mode = tdi->reads_only ? 0 : CSIR_PAIR;
     
@@ -817,6 +982,7 @@ static void redraw_template_image(TemplateDisplayItem *tdi, Display *display) {
     if (gap_range_recalculate(tdi->gr, tdi->width, working_wx0, working_wx1, mode, force_change)) {
 	if (tdi->gr->r == NULL) {
 	    // either lack of memory or an empty part of contig, blank to black 
+	    if(!create_image_buffer(tdi->image, tdi->width, tdi->height, tdi->background)) return;
 	    create_image_from_buffer(tdi->image);
 	    XPutImage(display, (Drawable)tdi->pm, tdi->gc, tdi->image->img, 0, 0, 0, 0, tdi->width, tdi->height);
 	    return;
@@ -825,18 +991,16 @@ static void redraw_template_image(TemplateDisplayItem *tdi, Display *display) {
 	force_change = 1;
     }
     
+    t = template_tile_new(tdi);
+    t->width = ceil((tx1 - tx0) * ax);
+    if (t->width < tdi->width)
+	t->width = tdi->width;
+    t->height = tdi->height;
+    if(!create_image_buffer(tdi->image, t->width, t->height, tdi->background)) return;
+
     fwd_col = tdi->yzoom >= 150 ? tdi->fwd_col3 : tdi->fwd_col;
     rev_col = tdi->yzoom >= 150 ? tdi->rev_col3 : tdi->rev_col;
     
-    /* world to pixmap conversion values */
-    if (tdi->wx1 - tdi->wx0 == 0) return;
-    
-    ax = tdi->width / (tdi->wx1 - tdi->wx0);
-    bx = tdi->wx0;
-    
-    ay = tdi->height / (tdi->wy1 - tdi->wy0);
-    by = tdi->wy0;    
-    
     /* 1) Compute X */
     tdi->ntl = gap_range_x(tdi->gr, ax, bx, fwd_col, rev_col, 
 			   tdi->single_col, tdi->span_col, tdi->inconsistent_col,
@@ -905,29 +1069,35 @@ static void redraw_template_image(TemplateDisplayItem *tdi, Display *display) {
 	}
     }
     
+    /* Hand the image over to the tile */
     create_image_from_buffer(tdi->image);
-    XPutImage(display, (Drawable)tdi->pm, tdi->gc, tdi->image->img, 0, 0, 0, 0, tdi->width, tdi->height);
+    t->img = tdi->image->img;
+    tdi->image->img = NULL;
+    tdi->image->buf = NULL;
+
+    t->ax        = ax;
+    t->tx0       = tx0;
+    t->tx1       = tx1;
+    t->wy0       = tdi->wy0;
+    t->wy1       = tdi->wy1;
+    t->gr        = tdi->gr;
+    t->timestamp = timestamp;
+    t->set       = set;
     
     /* some last bits of size calculation for scrolling */
-    tdi->y_start = ymin - 10;
-    tdi->y_end   = ymax + 10;
-    
-    if (tdi->y_start > 0) tdi->y_start = 0;
-    if (tdi->y_end < tdi->height) tdi->y_end = tdi->height;
-}
-    
-    
-    
-    
-    
+    t->y_start = ymin - 10;
+    t->y_end   = ymax + 10;
     
-   
+    if (t->y_start > 0) t->y_start = 0;
+    if (t->y_end < tdi->height) t->y_end = tdi->height;
 
-	    
+    src_x = (tdi->wx0 - tx0) * ax + 0.5;
+    if (src_x < 0) src_x = 0;
+    if (src_x + tdi->width > t->width) src_x = t->width - tdi->width;
 
-    
-    
-    
-    
-    
-    
+ blit:
+    XPutImage(display, (Drawable)tdi->pm, tdi->gc, t->img, src_x, 0, 0, 0, tdi->width, tdi->height);
+
+    tdi->y_start = t->y_start;
+    tdi->y_end   = t->y_end;
+}
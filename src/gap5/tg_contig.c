@@ -1797,8 +1797,6 @@ static int sort_range_by_x_end(const void *v1, const void *v2) {
 	return 0;
 }
 
-static GapIO *sort_io = NULL; /* Hack to pass into qsort() */
-
 /* Sort comparison function for range_t; sort by ascending position */
 static int sort_range_by_y(const void *v1, const void *v2) {
     const rangec_t *r1 = (const rangec_t *)v1;
@@ -1814,23 +1812,30 @@ static int sort_range_by_y(const void *v1, const void *v2) {
 * TRY A NEW SORTING SYSTEM
 ***********************************************************************/
 
-/* Variables for holding sort related values,
-   not the prettiest of solutions having it here.
-*/
-
-static int (*primary)(const void *, const void *);
-static int (*secondary)(const void *, const void *);
+/*
+ * Sort state for a single contig_objects_in_range() call. This is passed
+ * down to each comparison rather than held in file globals so that
+ * concurrent or nested range queries cannot trample each other.
+ */
+typedef struct range_sort {
+    GapIO *io;
+    int base_pos;
+    int (*primary)(const void *, const void *, struct range_sort *);
+    int (*secondary)(const void *, const void *, struct range_sort *);
+} range_sort_t;
+
+/* Default for range_sort_t.base_pos when no seq_sort_t is given */
 static int base_sort_pos = 1;
 
 
 // empty sort
-static int no_sort(const void *v1, const void *v2) {
+static int no_sort(const void *v1, const void *v2, range_sort_t *rs) {
     return 0;
 }
 
 
 // the sort types
-static int simple_sort_range_by_x(const void *v1, const void *v2) {
+static int simple_sort_range_by_x(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
 
@@ -1838,7 +1843,7 @@ static int simple_sort_range_by_x(const void *v1, const void *v2) {
 }
 
 
-static int simple_sort_range_by_x_end(const void *v1, const void *v2) {
+static int simple_sort_range_by_x_end(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
 
@@ -1846,14 +1851,14 @@ static int simple_sort_range_by_x_end(const void *v1, const void *v2) {
 }
 
 
-static int simple_sort_range_by_x_clipped(const void *v1, const void *v2) {
+static int simple_sort_range_by_x_clipped(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
     int r1_start, r2_start;
     
     /* Use clipped coordinate in seqs */
     if ((r1->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ) {
-	seq_t *s = cache_search(sort_io, GT_Seq, r1->rec);
+	seq_t *s = cache_search(rs->io, GT_Seq, r1->rec);
 	if ((s->len < 0) ^ r1->comp) {
 	    r1_start = r1->start + ABS(s->len) - (s->right-1) - 1;
 	} else {
@@ -1864,7 +1869,7 @@ static int simple_sort_range_by_x_clipped(const void *v1, const void *v2) {
     }
 
     if ((r2->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ) {
-	seq_t *s = cache_search(sort_io, GT_Seq, r2->rec);
+	seq_t *s = cache_search(rs->io, GT_Seq, r2->rec);
 	if ((s->len < 0) ^ r2->comp)
 	    r2_start = r2->start + ABS(s->len) - (s->right-1) - 1;
 	else
@@ -1877,14 +1882,14 @@ static int simple_sort_range_by_x_clipped(const void *v1, const void *v2) {
 }
 
 
-static int simple_sort_range_by_x_clipped_end(const void *v1, const void *v2) {
+static int simple_sort_range_by_x_clipped_end(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
     int r1_end, r2_end;
 
     /* Use clipped coordinate in seqs */
     if ((r1->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ) {
-	seq_t *s = cache_search(sort_io, GT_Seq, r1->rec);
+	seq_t *s = cache_search(rs->io, GT_Seq, r1->rec);
 	if ((s->len < 0) ^ r1->comp)
 	    r1_end = r1->start + ABS(s->len) - (s->left-1) - 1;
 	else
@@ -1894,7 +1899,7 @@ static int simple_sort_range_by_x_clipped_end(const void *v1, const void *v2) {
     }
 
     if ((r2->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ) {
-	seq_t *s = cache_search(sort_io, GT_Seq, r2->rec);
+	seq_t *s = cache_search(rs->io, GT_Seq, r2->rec);
 	if ((s->len < 0) ^ r2->comp)
 	    r2_end = r2->start + ABS(s->len) - (s->left-1) - 1;
 	else
@@ -1907,7 +1912,7 @@ static int simple_sort_range_by_x_clipped_end(const void *v1, const void *v2) {
 }
 
 
-static int simple_sort_range_by_template(const void *v1, const void *v2) {
+static int simple_sort_range_by_template(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
     
@@ -1919,7 +1924,7 @@ static int simple_sort_range_by_template(const void *v1, const void *v2) {
     
     /* use template name if exists, otherwise by name */
     if ((r1->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ) {
-    	seq_t *s1 = cache_search(sort_io, GT_Seq, r1->rec);
+    	seq_t *s1 = cache_search(rs->io, GT_Seq, r1->rec);
 	
 	if (s1->template_name_len > 0) {
 	    strncpy(template1, s1->name, s1->template_name_len);
@@ -1932,7 +1937,7 @@ static int simple_sort_range_by_template(const void *v1, const void *v2) {
     }
 
     if ((r2->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ) {
-    	seq_t *s2 = cache_search(sort_io, GT_Seq, r2->rec);
+    	seq_t *s2 = cache_search(rs->io, GT_Seq, r2->rec);
 	
 	if (s2->template_name_len > 0) {
 	    strncpy(template2, s2->name, s2->template_name_len);
@@ -1978,16 +1983,16 @@ static int get_base(seq_t *s, const rangec_t *r, int pos, char *base, int *cutof
  * Collate bases by alphabetical (A, C, G, T), N(123, first value are z),
  * "*"(124), and then any arbitrary unknown/failure(125).
  */
-static int simple_sort_by_base(const void *v1, const void *v2) {
+static int simple_sort_by_base(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
     char b1, b2;
     
     if ((r1->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ) {
-    	seq_t *s = cache_search(sort_io, GT_Seq, r1->rec);
+    	seq_t *s = cache_search(rs->io, GT_Seq, r1->rec);
 	int cutoff = 0;
 	
-	if (get_base(s, r1, base_sort_pos - r1->start, &b1, &cutoff) || cutoff) {
+	if (get_base(s, r1, rs->base_pos - r1->start, &b1, &cutoff) || cutoff) {
 	    b1 = 125;
 	}
 
@@ -2001,10 +2006,10 @@ static int simple_sort_by_base(const void *v1, const void *v2) {
     }
     
     if ((r2->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ) {
-    	seq_t *s = cache_search(sort_io, GT_Seq, r2->rec);
+    	seq_t *s = cache_search(rs->io, GT_Seq, r2->rec);
 	int cutoff = 0;
 
-	if (get_base(s, r2, base_sort_pos - r2->start, &b2, &cutoff) || cutoff) {
+	if (get_base(s, r2, rs->base_pos - r2->start, &b2, &cutoff) || cutoff) {
 	    b2 = 125;
 	}
 	
@@ -2020,7 +2025,7 @@ static int simple_sort_by_base(const void *v1, const void *v2) {
     return b1 - b2;
 }
 
-static int simple_sort_by_strand(const void *v1, const void *v2) {
+static int simple_sort_by_strand(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
     
@@ -2039,19 +2044,19 @@ static int simple_sort_by_strand(const void *v1, const void *v2) {
 }
 
 
-static int simple_sort_by_template_status(const void *v1, const void *v2) {
+static int simple_sort_by_template_status(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
     int status1 = 0, status2 = 0;
     seq_t *s1, *s2;
     
     if ((r1->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ)
-	if ((s1 = cache_search(sort_io, GT_Seq, r1->rec)))
-	    status1 = sequence_get_template_info(sort_io, s1, NULL, NULL);
+	if ((s1 = cache_search(rs->io, GT_Seq, r1->rec)))
+	    status1 = sequence_get_template_info(rs->io, s1, NULL, NULL);
 
     if ((r2->flags & GRANGE_FLAG_ISMASK) == GRANGE_FLAG_ISSEQ)
-	if ((s2 = cache_search(sort_io, GT_Seq, r2->rec)))
-	    status2 = sequence_get_template_info(sort_io, s2, NULL, NULL);
+	if ((s2 = cache_search(rs->io, GT_Seq, r2->rec)))
+	    status2 = sequence_get_template_info(rs->io, s2, NULL, NULL);
     
     return status1 - status2;
 }
@@ -2059,7 +2064,7 @@ static int simple_sort_by_template_status(const void *v1, const void *v2) {
 /*
  * Only on DB format >= 5
  */
-static int simple_sort_by_library(const void *v1, const void *v2) {
+static int simple_sort_by_library(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
     
@@ -2078,14 +2083,14 @@ static int simple_sort_by_library(const void *v1, const void *v2) {
 }
 
 
-static int simple_sort_range_by_tech_x(const void *v1, const void *v2) {
+static int simple_sort_range_by_tech_x(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
 
     return r1->seq_tech - r2->seq_tech;
 }
 
-static int simple_sort_by_sequence(const void *v1, const void *v2) {
+static int simple_sort_by_sequence(const void *v1, const void *v2, range_sort_t *rs) {
     const rangec_t *r1 = (const rangec_t *)v1;
     const rangec_t *r2 = (const rangec_t *)v2;
     
@@ -2098,13 +2103,13 @@ static int simple_sort_by_sequence(const void *v1, const void *v2) {
 
 
 /* runs the simple sort choices */
-static int chosen_sort(const void *v1, const void *v2) {
+static int chosen_sort(const void *v1, const void *v2, range_sort_t *rs) {
     
     int ret;
     
-    if ((ret = (*primary)(v1, v2))) {
+    if ((ret = (*rs->primary)(v1, v2, rs))) {
     	return ret;
-    } else if ((ret = (*secondary)(v1, v2))) {
+    } else if ((ret = (*rs->secondary)(v1, v2, rs))) {
     	return ret;
     } else {
     	return sort_range_by_x(v1, v2);
@@ -2112,6 +2117,62 @@ static int chosen_sort(const void *v1, const void *v2) {
 }
 
 
+/*
+ * Merge sort of r[0..n-1] using chosen_sort(). We can't use qsort() as it
+ * has no portable way to hand over rs. tmp must hold n/2 items.
+ */
+static void sort_ranges_r(rangec_t *r, rangec_t *tmp, int n,
+			  range_sort_t *rs) {
+    int i, j, k, h;
+
+    if (n <= 8) {
+	/* Insertion sort for small runs */
+	for (i = 1; i < n; i++) {
+	    rangec_t t = r[i];
+	    for (j = i; j > 0 && chosen_sort(&r[j-1], &t, rs) > 0; j--)
+		r[j] = r[j-1];
+	    r[j] = t;
+	}
+	return;
+    }
+
+    h = n/2;
+    sort_ranges_r(r,   tmp, h,   rs);
+    sort_ranges_r(r+h, tmp, n-h, rs);
+
+    /* Already in order? Common as bins are mostly sorted on X */
+    if (chosen_sort(&r[h-1], &r[h], rs) <= 0)
+	return;
+
+    memcpy(tmp, r, h * sizeof(*r));
+    i = 0; j = h; k = 0;
+    while (i < h && j < n)
+	r[k++] = chosen_sort(&r[j], &tmp[i], rs) < 0 ? r[j++] : tmp[i++];
+    while (i < h)
+	r[k++] = tmp[i++];
+}
+
+/*
+ * Sorts r[] by rs->primary, rs->secondary and then X.
+ *
+ * Returns 0 on success
+ *        -1 on failure
+ */
+static int sort_ranges(rangec_t *r, int n, range_sort_t *rs) {
+    rangec_t *tmp;
+
+    if (n < 2)
+	return 0;
+
+    if (NULL == (tmp = malloc((n/2+1) * sizeof(*tmp))))
+	return -1;
+
+    sort_ranges_r(r, tmp, n, rs);
+    free(tmp);
+
+    return 0;
+}
+
 void contig_set_base_sort_point(int pos) {
     base_sort_pos = pos;
 }
@@ -2204,7 +2265,7 @@ void contig_set_default_sort(seq_sort_t *set, int pri, int sec) {
 
 
 /* return a pointer to a function */
-static int (*set_sort(int job))(const void *, const void *) {
+static int (*set_sort(int job))(const void *, const void *, range_sort_t *) {
 
     if (job & CSIR_SORT_BY_TEMPLATE) {
 	return simple_sort_range_by_template;
@@ -2832,9 +2893,9 @@ static int contig_seqs_in_range2(GapIO *io, tg_rec bin_num,
 void update_range_y(GapIO *io, rangec_t *r, int count) {
     int i;
     tg_rec last_bin = -1;
+    bin_index_t *bin = NULL;
 
     for (i = 0; i < count; i++) {
-	bin_index_t *bin = NULL;
 	range_t *rng;
 
 	if (last_bin != r[i].orig_rec) {
@@ -2879,6 +2940,7 @@ static rangec_t *contig_objects_in_range(GapIO *io, contig_t **c, seq_sort_t *so
 
     if (r) {
     	int job;
+	range_sort_t rs;
     
     	if (first & CSIR_DEFAULT) {
 	    first |= sort_set->p_sort;
@@ -2920,16 +2982,13 @@ static rangec_t *contig_objects_in_range(GapIO *io, contig_t **c, seq_sort_t *so
 		}
 	    }
 	    
-	    sort_io = io;
+	    rs.io        = io;
+	    rs.base_pos  = sort_set ? sort_set->base_pos : base_sort_pos;
+	    rs.primary   = set_sort(first);
+	    rs.secondary = set_sort(second);
 	    
-	    if (sort_set) {
-	    	contig_set_base_sort_point(sort_set->base_pos);
-	    }
-	    
-	    primary   = set_sort(first);
-	    secondary = set_sort(second);
-	    
-	    qsort(r, *count, sizeof(*r), chosen_sort);
+	    if (sort_ranges(r, *count, &rs))
+		verror(ERR_WARN, "tg_contig", "Out of memory - unable to sort objects\n");
 
 	    if (job & CSIR_ALLOCATE_Y) {
 		if (job & CSIR_SORT_BY_SEQ_TECH) {
@@ -2960,6 +3019,15 @@ static rangec_t *contig_objects_in_range(GapIO *io, contig_t **c, seq_sort_t *so
 		    } while (i < n);
 		} else {
 		    compute_ypos(r, *count, job & CSIR_ALLOCATE_Y);
+
+		    /*
+		     * Remember the rows in the cached bin ranges. The next
+		     * query over an overlapping region then starts from
+		     * these (see KEEP_Y), so reads don't jump rows as we
+		     * scroll and most of them take the quick path.
+		     */
+		    if (job & CSIR_ALLOCATE_Y_MULTIPLE)
+			update_range_y(io, r, *count);
 		}
 
 		compute_ypos_tags(r, *count);
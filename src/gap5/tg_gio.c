@@ -15,6 +15,7 @@
 #include "actf.h"
 
 #include "tg_iface_g.h"
+#include "consensus.h"
 
 /* ------------------------------------------------------------------------
  * This is the primary IO layer that the rest of Gap5 uses. It consists of a
@@ -113,6 +114,9 @@ GapIO *gio_open(char *fn, int ro, int create) {
     /* Initialise the cache */
     cache_create(io);
 
+    /* And the consensus tables, once here instead of on first use */
+    consensus_tables_init();
+
     if (NULL == (io->dbh = io->iface->connect(fn, ro))) {
 	if (!ro) {
 	    ro = 1;
@@ -55,6 +55,12 @@ typedef struct GapIO {
     HacheTable *contig_reg;     /* Registration arrays for each contig */
     HacheTable *contig_cursor;	/* Hash of cursor_t lists */
 
+    /* Batched contig_notify() events; see contig_notify_batch_start() */
+    int notify_batch;		/* Nesting depth, 0 => deliver at once */
+    struct reg_queue *notify_queue;
+    int notify_raised;		/* Events passed to contig_notify() */
+    int notify_delivered;	/* Events actually dispatched */
+
     /* Minimum size for newly created bins */
     int min_bin_size;
 
@@ -37,6 +37,29 @@
 #include "xalloc.h"
 #include "tcl_utils.h"
 
+/*
+ * Events queued while a notification batch is open, in the order first
+ * raised. The hache maps (contig, job, except) to an index in ev[].
+ */
+typedef struct {
+    tg_rec contig;
+    int job;
+    int except;
+} reg_queue_key;
+
+typedef struct {
+    tg_rec contig;
+    int except;
+    reg_data msg;
+} reg_queue_ev;
+
+struct reg_queue {
+    HacheTable *h;
+    reg_queue_ev *ev;
+    int nev;
+    int nalloc;
+};
+
 /* Debugging aid */
 #define LOG_FILE
 #ifdef LOG_FILE
@@ -92,6 +115,14 @@ void contig_register_destroy(GapIO *io) {
 
     io_contig_reg(io) = NULL;
     io_cursor_reg(io) = NULL;
+
+    if (io->notify_queue) {
+	if (io->notify_queue->h)
+	    HacheTableDestroy(io->notify_queue->h, 0);
+	free(io->notify_queue->ev);
+	free(io->notify_queue);
+	io->notify_queue = NULL;
+    }
 }
 
 /*
@@ -686,33 +717,173 @@ void delete_contig_cursor(GapIO *io, tg_rec contig, int id, int private)
  */
 
 /*
- * Uses the register list for a given contig to call a particular job.
- * Contig 0 is a special registration list for windows that want to track
- * all contigs, so we always duplicate data there too.
+ * Sends an event straight to the registered callbacks.
  */
-void contig_notify(GapIO *io, tg_rec contig, reg_data *jdata) {
-    while (io->base)
-	io = io->base;
+static void notify_deliver(GapIO *io, tg_rec contig, reg_data *jdata,
+			   int except) {
+    io->notify_delivered++;
 
     /* Hack for QUIT_DISPLAYS, but need to tidy up contig 0 I think */
     /* Do this for all contig 0 events? */
     /* Or always register every method with contig 0? */
-    if (jdata->job == REG_QUIT && contig == 0) {
-	broadcast_event(io, io_contig_reg(io), jdata, -1);
+    if (jdata->job == REG_QUIT && contig == 0 && except == -1) {
+	broadcast_event(io, io_contig_reg(io), jdata, except);
     } else {
-	send_event(io, io_contig_reg(io), contig, jdata, -1);
+	send_event(io, io_contig_reg(io), contig, jdata, except);
 	if (contig)
-	    send_event(io, io_contig_reg(io), -contig, jdata, -1);
+	    send_event(io, io_contig_reg(io), -contig, jdata, except);
+    }
+}
+
+/*
+ * Adds an event to the batch queue, replacing any pending event of the
+ * same type for this contig.
+ *
+ * Returns 0 on success
+ *        -1 on failure (the caller should deliver it directly)
+ */
+static int notify_queue_add(GapIO *io, tg_rec contig, reg_data *jdata,
+			    int except) {
+    struct reg_queue *q = io->notify_queue;
+    reg_queue_key key;
+    HacheItem *hi;
+    HacheData hd;
+    int new;
+
+    if (!q) {
+	if (NULL == (q = calloc(1, sizeof(*q))))
+	    return -1;
+	io->notify_queue = q;
+    }
+
+    if (!q->h) {
+	if (NULL == (q->h = HacheTableCreate(256, HASH_DYNAMIC_SIZE |
+					     HASH_OWN_KEYS)))
+	    return -1;
+	q->h->name = "notify_queue";
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.contig = contig;
+    key.job    = jdata->job;
+    key.except = except;
+
+    hd.i = q->nev;
+    if (NULL == (hi = HacheTableAdd(q->h, (char *)&key, sizeof(key),
+				    hd, &new)))
+	return -1;
+
+    if (!new) {
+	/* Merge: the most recent data wins */
+	q->ev[hi->data.i].msg = *jdata;
+	return 0;
+    }
+
+    if (q->nev >= q->nalloc) {
+	int nalloc = q->nalloc ? q->nalloc * 2 : 16;
+	reg_queue_ev *ev = realloc(q->ev, nalloc * sizeof(*ev));
+	if (!ev) {
+	    HacheTableDel(q->h, hi, 0);
+	    return -1;
+	}
+	q->ev = ev;
+	q->nalloc = nalloc;
+    }
+
+    q->ev[q->nev].contig = contig;
+    q->ev[q->nev].except = except;
+    q->ev[q->nev].msg    = *jdata;
+    q->nev++;
+
+    return 0;
+}
+
+/*
+ * Delivers all queued events. The queue is detached first as callbacks
+ * may raise further events.
+ */
+static void notify_queue_flush(GapIO *io) {
+    struct reg_queue *q = io->notify_queue;
+    reg_queue_ev *ev;
+    int i, nev;
+
+    if (!q || !q->nev)
+	return;
+
+    ev  = q->ev;
+    nev = q->nev;
+    q->ev = NULL;
+    q->nev = q->nalloc = 0;
+    HacheTableDestroy(q->h, 0);
+    q->h = NULL;
+
+    for (i = 0; i < nev; i++)
+	notify_deliver(io, ev[i].contig, &ev[i].msg, ev[i].except);
+
+    free(ev);
+}
+
+/*
+ * Queues or delivers an event, depending on whether a batch is open.
+ */
+static void notify_event(GapIO *io, tg_rec contig, reg_data *jdata,
+			 int except) {
+    while (io->base)
+	io = io->base;
+
+    io->notify_raised++;
+
+    if (io->notify_batch) {
+	if ((jdata->job & REG_COALESCE) &&
+	    0 == notify_queue_add(io, contig, jdata, except))
+	    return;
+
+	/* Keep the order of anything we can't merge */
+	notify_queue_flush(io);
     }
+
+    notify_deliver(io, contig, jdata, except);
+}
+
+/*
+ * Uses the register list for a given contig to call a particular job.
+ * Contig 0 is a special registration list for windows that want to track
+ * all contigs, so we always duplicate data there too.
+ */
+void contig_notify(GapIO *io, tg_rec contig, reg_data *jdata) {
+    notify_event(io, contig, jdata, -1);
 }
 
 void contig_notify_except(GapIO *io, tg_rec contig, reg_data *jdata, int id) {
+    notify_event(io, contig, jdata, id);
+}
+
+void contig_notify_batch_start(GapIO *io) {
+    while (io->base)
+	io = io->base;
+
+    io->notify_batch++;
+}
+
+void contig_notify_batch_end(GapIO *io) {
+    while (io->base)
+	io = io->base;
+
+    if (io->notify_batch <= 0 || --io->notify_batch)
+	return;
+
+    notify_queue_flush(io);
+
+    gio_debug(io, 1, "contig_notify: %d events raised, %d delivered\n",
+	      io->notify_raised, io->notify_delivered);
+}
+
+void contig_notify_stats(GapIO *io, int *raised, int *delivered) {
     while (io->base)
 	io = io->base;
 
-    send_event(io, io_contig_reg(io), contig, jdata, id);
-    if (contig)
-	send_event(io, io_contig_reg(io), -contig, jdata, id);
+    if (raised)    *raised    = io->notify_raised;
+    if (delivered) *delivered = io->notify_delivered;
 }
 
 /*
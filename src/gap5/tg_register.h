@@ -363,6 +363,39 @@ int contig_deregister(GapIO *io, tg_rec contig,
  */
 void contig_notify(GapIO *io, tg_rec contig, reg_data *jdata);
 
+/*
+ * Events that may be merged while a batch is open. A later event of the
+ * same type for the same contig replaces the earlier one.
+ */
+#define REG_COALESCE (REG_LENGTH | REG_CHILD_EDIT | REG_ANNO | REG_ORDER)
+
+/*
+ * Opens (or nests) a notification batch. Until the matching
+ * contig_notify_batch_end(), REG_COALESCE events are queued and merged
+ * instead of being sent. Merging is keyed on (contig, job, except), not
+ * on the registration, so every client registered for the contig still
+ * receives one copy. Any other event first delivers the queue, so
+ * ordering relative to it is kept.
+ *
+ * Currently used by editor undo and by saving all editors in a join
+ * editor. The bulk operations (shuffle pads, break contig, disassemble
+ * readings) are not batched: they shut down the displays with
+ * quit_displays first and raise no per-edit events while running.
+ */
+void contig_notify_batch_start(GapIO *io);
+
+/*
+ * Closes a batch, delivering the queued events once the outermost batch
+ * is closed.
+ */
+void contig_notify_batch_end(GapIO *io);
+
+/*
+ * Returns the number of events raised via contig_notify() and how many
+ * were dispatched after batching.
+ */
+void contig_notify_stats(GapIO *io, int *raised, int *delivered);
+
 
 /*
  * Joins two registers lists. This doesn't check for duplicate entries.
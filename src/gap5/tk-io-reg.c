@@ -1218,6 +1218,49 @@ int tk_contig_notify(ClientData clientData, Tcl_Interp *interp,
     return TCL_OK;
 }
 
+typedef struct {
+    GapIO *io;
+    char *job;
+} cnb_arg;
+
+/*
+ * Tcl interface to contig_notify_batch_start/end. "-job start" and
+ * "-job end" must be paired; "-job stats" returns the number of events
+ * raised and delivered so far.
+ */
+int tk_contig_notify_batch(ClientData clientData, Tcl_Interp *interp,
+			   int objc, Tcl_Obj *CONST objv[])
+{
+    cnb_arg args;
+    cli_args a[] = {
+        {"-io",       ARG_IO,  1, NULL,    offsetof(cnb_arg, io)},
+	{"-job",      ARG_STR, 1, "stats", offsetof(cnb_arg, job)},
+        {NULL,        0,       0, NULL, 0}
+    };
+
+    if (-1 == gap_parse_obj_args(a, &args, objc, objv))
+        return TCL_ERROR;
+
+    if (strcmp(args.job, "start") == 0) {
+	contig_notify_batch_start(args.io);
+    } else if (strcmp(args.job, "end") == 0) {
+	contig_notify_batch_end(args.io);
+    } else if (strcmp(args.job, "stats") == 0) {
+	int raised, delivered;
+	Tcl_Obj *l = Tcl_NewListObj(0, NULL);
+
+	contig_notify_stats(args.io, &raised, &delivered);
+	Tcl_ListObjAppendElement(interp, l, Tcl_NewIntObj(raised));
+	Tcl_ListObjAppendElement(interp, l, Tcl_NewIntObj(delivered));
+	Tcl_SetObjResult(interp, l);
+    } else {
+	Tcl_SetResult(interp, "-job must be start, end or stats", TCL_STATIC);
+	return TCL_ERROR;
+    }
+
+    return TCL_OK;
+}
+
 typedef struct {
     GapIO *io;
     int    id;
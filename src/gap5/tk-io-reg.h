@@ -118,6 +118,12 @@ int tk_contig_notify(ClientData clientData, Tcl_Interp *interp,
 int tk_result_notify(ClientData clientData, Tcl_Interp *interp,
 		     int objc, Tcl_Obj *CONST objv[]);
 
+/*
+ * Opens and closes a batch of coalesced contig notifications.
+ */
+int tk_contig_notify_batch(ClientData clientData, Tcl_Interp *interp,
+			   int objc, Tcl_Obj *CONST objv[]);
+
 /*
  * An arbitray Tcl interface to contig event notification
  */
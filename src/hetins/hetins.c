@@ -8,16 +8,28 @@
 #include <io_lib/Read.h>
 #include <io_lib/traceType.h>
 
-#define FULL_TEST 2
-#define TEST 1
+#include "hetins.h"
 
-typedef struct HETINS_PARAMS_ {
-  int    window;
-  int    mode;
-  double worst_envelope;
-  double worst_half_signal;
-  double good_signal_grad_indel;
-}HETINS_PARAMS;
+/*
+ * Fills out 'params' with the defaults used by the hetins program.
+ */
+void hetins_default_params(HETINS_PARAMS *params) {
+  params->window = 101;
+  params->worst_envelope = 0.5;
+  params->worst_half_signal     = 0.15;
+  params->good_signal_grad_indel = -0.146;
+  params->mode = 0;
+}
+
+/*
+ * Formats the text of the HETI tag for an indel at base 'pos' of 'r'.
+ * buf should be at least HETINS_TAG_LEN long.
+ */
+void hetins_format_tag(char *buf, int pos, Read *r, HETINS_PARAMS params) {
+  sprintf(buf, "HETI = %d..%d\n %d %5.3f %5.3f %6.3f",
+	  pos,r->NBases-1,params.window,params.worst_envelope,
+	  params.worst_half_signal,params.good_signal_grad_indel);
+}
 
 
 
@@ -384,151 +396,12 @@ int heterozygous_indels(Read *r, HETINS_PARAMS params) {
     return ret;
 }
 
-void usage(HETINS_PARAMS params) {
-
-    fprintf(stderr,
-	    "Usage: hetins [options] file_name\n"
-	    "Where options are:\n"
-	    "    [-w window_length (%d)]           [-e worst_envelope (%f)]\n"
-	    "    [-h worst_half_signal (%f)]  [-g good_signal_grad_indel (%f)]\n"
-	    "    [-t debug only]       file_name\n",
-	    params.window, params.worst_envelope, params.worst_half_signal,
-	    params.good_signal_grad_indel);
-    exit(1);
-}
+int hetins_batch(Read **r, int nreads, HETINS_PARAMS params, int *pos) {
+  int i, nfailed = 0;
 
-/* 8/1/99 johnt - must explictly import globals from DLLs with Visual C++ */
-#ifdef _MSC_VER
-#  define DLL_IMPORT __declspec(dllimport)
-#else
-#  define DLL_IMPORT
-#endif
-
-#define BUFSIZE 1024
-
-int main(int argc, char **argv) {
-  char buffer[BUFSIZE];
-  char *fn;
-  int c;
-  HETINS_PARAMS params;
-  Read *read = NULL;
-  Exp_info *exp_file = NULL;
-  int file_type, ret;
-  int qr;
-  extern DLL_IMPORT char *optarg;
-  extern DLL_IMPORT int optind;
-
-  params.window = 101;
-  params.worst_envelope = 0.5;
-  params.worst_half_signal     = 0.15;
-  params.good_signal_grad_indel = -0.146;
-  params.mode = 0;
-
-
-  while ((c = getopt(argc, argv, "w:e:h:g:tT")) != -1) {
-    switch (c) {
-    case 'T':
-      params.mode = FULL_TEST;
-      break;
-    case 't':
-      params.mode = TEST;
-      break;
-    case 'w':
-      params.window = atoi(optarg);
-      break;
-    case 'e':
-      params.worst_envelope = atof(optarg);
-      break;
-    case 'h':
-      params.worst_half_signal = atof(optarg);
-      break;
-    case 'g':
-      params.good_signal_grad_indel = atof(optarg);
-      break;
-    default:
-      usage(params);
-    }
-  }
-  if (optind == argc) usage(params);
-
-  fn = argv[optind];
-  file_type = determine_trace_type(fn);
-
-  if ((file_type == TT_PLN) || (file_type == TT_UNK)) {
-    fprintf(stderr,"Input file not EXP or trace\n");
-    goto bail_out;
+  for (i = 0; i < nreads; i++) {
+    if ((pos[i] = heterozygous_indels(r[i], params)) < 0)
+      nfailed++;
   }
-
-  if (file_type == TT_EXP) {
-
-    if(NULL ==(exp_file = exp_read_info(fn))) {
-      fprintf(stderr, "Couldn't read reading file %s\n",fn);
-      goto bail_out;
-    }
-    /* get the QR value for later */
-
-    if (exp_Nentries(exp_file, EFLT_QR))
-	qr = atoi(exp_get_entry ( exp_file, EFLT_QR ));
-    else
-	qr = 0;
-
-    /* Extract LN record, gives us input trace file name */
-    if( exp_get_str(exp_file,EFLT_LN,buffer,BUFSIZE) ) {
-      fprintf( stderr, "Unable to read LN record from experiment file %s,\n", fn);
-      goto bail_out;
-    }
-
-
-    /* Open input trace */
-
-    if(NULL ==(read = read_reading( buffer, TT_ANY ))) {
-      fprintf( stderr, "Unable to read trace for experiment file %s,\n", fn);
-      goto bail_out;
-    }
-  }
-  else {
-    if(NULL ==(read = read_reading( fn, TT_ANY ))) {
-      fprintf( stderr, "Unable to read trace file %s,\n", fn);
-      goto bail_out;
-    }
-    params.mode = TEST;
-  }
-
-  ret = heterozygous_indels(read, params);
-
-  if (params.mode == TEST ) {
-    printf("%s %d\n",fn,ret);
-  }
-  else if (params.mode != FULL_TEST ) {
-
-    fprintf(stdout,"%d\n",ret);
-    if (ret && (file_type == TT_EXP) && (params.mode != 1)) {
-      /* write out a tag */
-      sprintf(buffer, "HETI = %d..%d\n %d %5.3f %5.3f %6.3f",
-	      ret,read->NBases-1,params.window,params.worst_envelope,
-	      params.worst_half_signal,params.good_signal_grad_indel);
-      if (exp_put_str(exp_file, EFLT_TG, buffer, strlen(buffer))) {
-	fprintf( stderr, "Unable to write to experiment file %s,\n", fn);
-	goto bail_out;
-      }
-      /* Only shift QR to the right, never to the left */
-      /* if qr left of the indel we won't see it in gap4! */
-      if( ret > qr ) {
-	sprintf(buffer, "%d", ret+1);
-	if (exp_put_str(exp_file, EFLT_QR, buffer, strlen(buffer))) {
-	  fprintf( stderr, "Unable to write to experiment file %s,\n", fn);
-	  goto bail_out;
-	}
-      }
-    }
-  }
-  read_deallocate(read);
-  exp_destroy_info ( exp_file );
-  return 0;
-
-  bail_out:
-  read_deallocate(read);
-  exp_destroy_info ( exp_file );
-  return -1;
+  return nfailed;
 }
-
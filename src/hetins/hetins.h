@@ -0,0 +1,43 @@
+#ifndef _HETINS_H_
+#define _HETINS_H_
+
+#include <io_lib/Read.h>
+
+#define FULL_TEST 2
+#define TEST 1
+
+/* Enough for the text of a HETI tag */
+#define HETINS_TAG_LEN 256
+
+typedef struct HETINS_PARAMS_ {
+  int    window;
+  int    mode;
+  double worst_envelope;
+  double worst_half_signal;
+  double good_signal_grad_indel;
+}HETINS_PARAMS;
+
+/*
+ * Fills out 'params' with the defaults used by the hetins program.
+ */
+void hetins_default_params(HETINS_PARAMS *params);
+
+/*
+ * Searches the trace of 'r' for the start of a heterozygous indel.
+ * Returns its base position, 0 if there is none, or -1 on failure.
+ */
+int heterozygous_indels(Read *r, HETINS_PARAMS params);
+
+/*
+ * Runs heterozygous_indels() over 'nreads' traces, storing the results in
+ * pos[i]. Returns the number that failed.
+ */
+int hetins_batch(Read **r, int nreads, HETINS_PARAMS params, int *pos);
+
+/*
+ * Formats the text of the HETI tag for an indel at base 'pos' of 'r'.
+ * buf should be at least HETINS_TAG_LEN long.
+ */
+void hetins_format_tag(char *buf, int pos, Read *r, HETINS_PARAMS params);
+
+#endif /* _HETINS_H_ */
@@ -180,12 +180,15 @@ int Alignment::Execute( algorithm_t a )
    }
    if( m_pOverlap )
    {
-      sp::destroy_overlap(m_pOverlap);
-      m_pOverlap = 0;
+      // Reuse the overlap, just dropping the previous results
+      sp::free_overlap(m_pOverlap);
+   }
+   else
+   {
+      m_pOverlap = sp::create_overlap();
+      if( !m_pOverlap )
+         throw std::bad_alloc();
    }
-   m_pOverlap = sp::create_overlap();
-   if( !m_pOverlap )
-      throw std::bad_alloc();
 
 
 
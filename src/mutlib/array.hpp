@@ -50,6 +50,7 @@ class SimpleArray
    void AutoDestroy( bool s )          { m_bAutoDestroy=s; }
    void Create( int nCapacity );
    void Create( T* p, int nLength );
+   void Resize( int nLength );
    void Wrap( T* p, int nCapacity, bool AutoDestroy=false );
    void SaveAs( const char* pFileName, bool bAppend=false, bool bAsInteger=false );
    void Append( T* p, int n );
@@ -147,6 +148,27 @@ void SimpleArray<T>::Create( T* p, int nLength )
 
 
 
+//--------
+// Resize
+//--------
+// As Create( int ), but reuses the existing storage when we own it and it
+// is large enough, so an array used repeatedly stops allocating once it
+// has reached its working size. The contents are not initialised.
+
+template <typename T>
+void SimpleArray<T>::Resize( int nLength )
+{
+   assert(nLength>0);
+   if( m_pArray && m_bAutoDestroy && (nLength<=m_nCapacity) )
+   {
+      Length( nLength );
+      return;
+   }
+   Create( nLength );
+}
+
+
+
 //--------
 // Length
 //--------
@@ -121,6 +121,19 @@ typedef struct
 }tracealign_t;
 
 
+/** Trace align batch item, see TraceAlignExecuteBatch() */
+typedef struct
+{
+   /* Input objects owned by caller */
+   mutlib_trace_t  Input;
+
+   /* Output objects owned by tracealign until TraceAlignDestroyBatch() */
+   mutlib_trace_t  Alignment[2];
+   mutlib_result_t ResultCode;
+
+}tracealign_batch_t;
+
+
 
 /*----------------*/
 /* TraceAlign API */
@@ -134,6 +147,8 @@ mutlib_result_t TraceAlignGetResultCode( tracealign_t* ta );
 const char*     TraceAlignGetResultString( tracealign_t* ta );
 Read*           TraceAlignGetAlignment( tracealign_t* ta, mutlib_input_t i, int* l, int* r );
 void            TraceAlignDestroy( tracealign_t* ta );
+mutlib_result_t TraceAlignExecuteBatch( tracealign_t* ta, tracealign_batch_t* b, int n );
+void            TraceAlignDestroyBatch( tracealign_batch_t* b, int n );
 
 
 
@@ -249,11 +264,27 @@ typedef struct
    char*             ResultString;
 
    /* Internal objects owned by mutscan */
+   void*             Cache;
    int               Initialised;
 
 }mutscan_t;
 
 
+/** Mutscan batch item, see MutScanExecuteBatch() */
+typedef struct
+{
+   /* Input objects owned by caller */
+   mutlib_trace_t    Input;
+
+   /* Output objects owned by mutscan until MutScanDestroyBatch() */
+   mutlib_tag_t*     Tag;
+   int               TagCount;
+   mutlib_result_t   ResultCode;
+   char*             ResultString;
+
+}mutscan_batch_t;
+
+
 
 /*-------------*/
 /* MutScan API */
@@ -270,6 +301,8 @@ mutlib_result_t MutScanGetResultCode( mutscan_t* ms );
 const char*     MutScanGetResultString( mutscan_t* ms );
 int             MutScanGetTagCount( mutscan_t* ms );
 mutlib_tag_t*   MutScanGetTag( mutscan_t* ms, int n );
+mutlib_result_t MutScanExecuteBatch( mutscan_t* ms, mutscan_batch_t* b, int n );
+void            MutScanDestroyBatch( mutscan_batch_t* b, int n );
 
 
 
@@ -23,6 +23,7 @@
 #include <align.hpp>                    // For Alignment object
 #include <trace.hpp>                    // For Trace object
 #include <mutscan.hpp>                  // For helpers
+#include <tracealign.hpp>               // For TraceAlignDestroyResults()
 #include <mutationtag_utils.hpp>        // For CopyTags(), CompTags(), SortTags(), PruneTags()
 #include <mutscan_parameters.hpp>       // For MutScanParameter object
 #include <mutscan_preprocess.hpp>       // For MutScanPreprocessor object
@@ -60,6 +61,7 @@ void MutScanDestroy( mutscan_t* ms )
    try
    {
       // Delete all data
+      MutScanDestroyCache( ms );
       MutScanDestroyResults( ms );
    }
    catch(...)
@@ -197,7 +199,9 @@ mutlib_tag_t* MutScanGetTag( mutscan_t* ms, int n )
 
 
 /**
-   Executes the trace alignment algorithm.
+   Executes the mutation scanning algorithm. The trace aligner is kept in
+   the cache between calls, so each reference strand is only preprocessed
+   when it is first used or replaced with MutScanSetReference().
 */
 mutlib_result_t MutScanExecute( mutscan_t* ms )
 {
@@ -206,7 +210,7 @@ mutlib_result_t MutScanExecute( mutscan_t* ms )
            STATE_MUTATION_POSITION, STATE_COVERAGE_TAG, STATE_MUTATION_TAG,
            STATE_EXIT };
     int                 n;
-    tracealign_t        ta;
+    tracealign_t*       ta                = 0;
     mutlib_result_t     Result;
     mutlib_strand_t     Strand = MUTLIB_STRAND_FORWARD; // silence warning
     MutScanParameters   Parameter;
@@ -232,12 +236,19 @@ mutlib_result_t MutScanExecute( mutscan_t* ms )
             {
                 case STATE_INITIALISE:
                     // Destroy old results
-                    TraceAlignInit( &ta );
                     MutScanDestroyResults( ms );
                     Strand              = ms->InputTrace.Strand;
                     ms->ResultCode      = MUTLIB_RESULT_SUCCESS;
                     ms->ResultString    = new char [256];
                     ms->ResultString[0] = 0;
+                    // Create the trace aligner if not done
+                    if( !ms->Cache )
+                    {
+                        tracealign_t* p = new tracealign_t;
+                        TraceAlignInit( p );
+                        ms->Cache = static_cast<void*>( p );
+                    }
+                    ta = static_cast<tracealign_t*>( ms->Cache );
                     State = STATE_VALIDATE_INPUT;
                     break;
 
@@ -259,18 +270,23 @@ mutlib_result_t MutScanExecute( mutscan_t* ms )
 
 
                 case STATE_TRACE_ALIGN:
-                    // Align the reference and input traces
-                    TraceAlignSetReference( &ta, Strand, ms->ReferenceTrace[Strand].Trace, ms->ReferenceTrace[Strand].ClipL, ms->ReferenceTrace[Strand].ClipR );
-                    TraceAlignSetInput( &ta, Strand, ms->InputTrace.Trace, ms->InputTrace.ClipL, ms->InputTrace.ClipR );
-                    if( TraceAlignExecute(&ta) != MUTLIB_RESULT_SUCCESS )
+                    // Align the reference and input traces, the aligner keeps its
+                    // preprocessed reference until a new one is supplied.
+                    if( ms->ReferenceTrace[Strand].New )
+                    {
+                        TraceAlignSetReference( ta, Strand, ms->ReferenceTrace[Strand].Trace, ms->ReferenceTrace[Strand].ClipL, ms->ReferenceTrace[Strand].ClipR );
+                        ms->ReferenceTrace[Strand].New = 0;
+                    }
+                    TraceAlignSetInput( ta, Strand, ms->InputTrace.Trace, ms->InputTrace.ClipL, ms->InputTrace.ClipR );
+                    if( TraceAlignExecute(ta) != MUTLIB_RESULT_SUCCESS )
                     {
-                        ms->ResultCode = TraceAlignGetResultCode( &ta );
-                        std::strcpy( ms->ResultString, TraceAlignGetResultString(&ta) );
+                        ms->ResultCode = TraceAlignGetResultCode( ta );
+                        std::strcpy( ms->ResultString, TraceAlignGetResultString(ta) );
                         State = STATE_EXIT;
                         break;
                     }
                     for( int n=0; n<2; n++ )
-                        AlignedTrace[n].Wrap( TraceAlignGetAlignment(&ta, static_cast<mutlib_input_t>(n), &AlignedTraceClipL[n], &AlignedTraceClipR[n]), false );
+                        AlignedTrace[n].Wrap( TraceAlignGetAlignment(ta, static_cast<mutlib_input_t>(n), &AlignedTraceClipL[n], &AlignedTraceClipR[n]), false );
                     State = STATE_TRACE_PREPROCESS;
                     break;
 
@@ -412,7 +428,66 @@ mutlib_result_t MutScanExecute( mutscan_t* ms )
     // Exit
     if( DifferenceTrace )
         delete DifferenceTrace;
-    TraceAlignDestroy( &ta );
+    if( ta )
+        TraceAlignDestroyResults( ta );
     return ms->ResultCode;
 }
 
+
+
+/**
+   Scans each of the 'n' inputs in 'b' against the reference traces already
+   set with MutScanSetReference(). The trace aligner and its preprocessed
+   references are shared by every item, so only the per-input work is
+   repeated.
+
+   Items are processed in order and each takes ownership of its own tags,
+   result code and result string, which remain valid until
+   MutScanDestroyBatch() is called. The return value is the first failure
+   code encountered, or MUTLIB_RESULT_SUCCESS.
+*/
+mutlib_result_t MutScanExecuteBatch( mutscan_t* ms, mutscan_batch_t* b, int n )
+{
+   assert(ms != NULL);
+   assert(ms->Initialised);
+   assert(n==0 || b!=NULL);
+   mutlib_result_t Result = MUTLIB_RESULT_SUCCESS;
+   for( int k=0; k<n; k++ )
+   {
+      mutlib_trace_t& in = b[k].Input;
+      MutScanSetInput( ms, in.Strand, in.Trace, in.ClipL, in.ClipR );
+      b[k].ResultCode = MutScanExecute( ms );
+      // Hand the results over to the batch item
+      b[k].Tag          = ms->Tag;
+      b[k].TagCount     = ms->TagCount;
+      b[k].ResultString = ms->ResultString;
+      ms->Tag           = 0;
+      ms->TagCount      = 0;
+      ms->ResultString  = 0;
+      if( (b[k].ResultCode!=MUTLIB_RESULT_SUCCESS) && (Result==MUTLIB_RESULT_SUCCESS) )
+         Result = b[k].ResultCode;
+   }
+   return Result;
+}
+
+
+
+/**
+   Frees the tags and result strings held by the 'n' items in 'b' after a
+   call to MutScanExecuteBatch(). The input traces are untouched.
+*/
+void MutScanDestroyBatch( mutscan_batch_t* b, int n )
+{
+   assert(n==0 || b!=NULL);
+   for( int k=0; k<n; k++ )
+   {
+      for( int i=0; i<b[k].TagCount; i++ )
+         delete [] b[k].Tag[i].Comment;
+      delete [] b[k].Tag;
+      delete [] b[k].ResultString;
+      b[k].Tag          = 0;
+      b[k].TagCount     = 0;
+      b[k].ResultString = 0;
+   }
+}
+
@@ -37,3 +37,20 @@ void MutScanDestroyResults( mutscan_t* ms )
    ms->TagCount = 0;
 }
 
+
+
+void MutScanDestroyCache( mutscan_t* ms )
+{
+   assert(ms != NULL);
+
+
+   // Delete the trace aligner and its cached reference data
+   tracealign_t* ta = static_cast<tracealign_t*>( ms->Cache );
+   if( ta )
+   {
+      TraceAlignDestroy( ta );
+      delete ta;
+   }
+   ms->Cache = 0;
+}
+
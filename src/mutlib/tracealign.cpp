@@ -166,19 +166,15 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
            STATE_SEQUENCE_MAP, STATE_QUANTISE_ENVELOPE, STATE_ESTIMATE_BANDSIZE,
            STATE_ENVELOPE_ALIGN, STATE_TRACE_ALIGN, STATE_EXIT };
     mutlib_strand_t         Strand = MUTLIB_STRAND_FORWARD; // silence warning
-    Alignment               Aligner;
     int                     AlignedSeqOverlap[2];
     DNAArray<char>          RefSeq;
     TraceAlignPreprocessor* RefData = NULL;
     Trace                   RefTrace;
-    SimpleArray<char>       RefEnvelope;
     SimpleArray<char>       RefEnvelopeAligned;
     int                     RefOverlapBases[2];
     int                     RefOverlapSamples[2];
     DNAArray<char>          InputSeq;
-    TraceAlignPreprocessor  InputData;
     Trace                   InputTrace;
-    SimpleArray<char>       InputEnvelope;
     SimpleArray<char>       InputEnvelopeAligned;
     int                     InputOverlapBases[2];
     int                     InputOverlapSamples[2];
@@ -246,7 +242,7 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
 
                 case STATE_PREPROCESS_INPUT:
                     // Preprocess input trace
-                    InputData.PreprocessTrace( InputTrace );
+                    Cache->InputData.PreprocessTrace( InputTrace );
                     State = STATE_SEQUENCE_ALIGN;
                     break;
 
@@ -255,6 +251,7 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
                 case STATE_SEQUENCE_ALIGN: {
                     // Align sequences first so we can determine which parts of the
                     // trace to align - trace alignment takes a long time using DP!
+                    Alignment& Aligner = Cache->SequenceAligner;
                     char* wseq = &(RefTrace.Raw()->base[ ta->Reference[Strand].ClipL ]);
                     char* iseq = &(InputTrace.Raw()->base[ ta->Input.ClipL ]);
                     int   wlen = ta->Reference[Strand].ClipR - ta->Reference[Strand].ClipL - 1;
@@ -276,8 +273,8 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
                 case STATE_SEQUENCE_OVERLAP:
                     // Checks that there is sufficient sequence overlap for an alignment
                     // operation to make any logical sense!
-                    AlignedSeqOverlap[L] = Aligner.OutputSequenceLeftOverlap(0);
-                    AlignedSeqOverlap[R] = Aligner.OutputSequenceRightOverlap(0);
+                    AlignedSeqOverlap[L] = Cache->SequenceAligner.OutputSequenceLeftOverlap(0);
+                    AlignedSeqOverlap[R] = Cache->SequenceAligner.OutputSequenceRightOverlap(0);
                     if( AlignedSeqOverlap[R] - AlignedSeqOverlap[L] <= MIN_OVERLAP )
                     {
                         std::sprintf( ta->ResultString, "Insufficient sequence overlap to compute "
@@ -319,6 +316,7 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
                     // that the quantised envelope indices will not be relative to the
                     // orignal trace unless you add xxxOverlapSamples[L] to them.
                     int QUPPER[2];
+                    TraceAlignPreprocessor& InputData = Cache->InputData;
                     RefData->Envelope().Range( RefOverlapSamples[L], RefOverlapSamples[R] );
                     InputData.Envelope().Range( InputOverlapSamples[L], InputOverlapSamples[R] );
                     #ifdef VERBOSE_DEBUG
@@ -328,8 +326,8 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
                     QUPPER[0] = RefData->Envelope().Max();
                     QUPPER[1] = InputData.Envelope().Max();
                     QUPPER[0] = std::max( QUPPER[0], QUPPER[1] );
-                    TraceAlignQuantiseEnvelope( RefData->Envelope(), RefEnvelope, QLEVELS, QLOWER, QUPPER[0] );
-                    TraceAlignQuantiseEnvelope( InputData.Envelope(), InputEnvelope, QLEVELS, QLOWER, QUPPER[0] );
+                    TraceAlignQuantiseEnvelope( RefData->Envelope(), Cache->RefEnvelope, QLEVELS, QLOWER, QUPPER[0] );
+                    TraceAlignQuantiseEnvelope( InputData.Envelope(), Cache->InputEnvelope, QLEVELS, QLOWER, QUPPER[0] );
                     State = STATE_ESTIMATE_BANDSIZE;
                     break; }
 
@@ -367,13 +365,14 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
 
                 case STATE_ENVELOPE_ALIGN: {
                     // Align the quantised envelopes of the overlapping region.
+                    Alignment& Aligner = Cache->EnvelopeAligner;
                     Aligner.PadSymbol( QPAD_SYMBOL );
                     Aligner.GapPenalty( 0, QLEVELS );
                     Aligner.EdgeScore( Alignment::EDGE_SCORE_RIGHT );
                     Aligner.Matrix( Cache->AlignmentMatrix.Raw(), Cache->AlignmentMatrix.Rows(), false );
                     Aligner.BandSize( BandSize );
-                    Aligner.InputSequence( 0, RefEnvelope.Raw(), RefEnvelope.Length() );
-                    Aligner.InputSequence( 1, InputEnvelope.Raw(), InputEnvelope.Length() );
+                    Aligner.InputSequence( 0, Cache->RefEnvelope.Raw(), Cache->RefEnvelope.Length() );
+                    Aligner.InputSequence( 1, Cache->InputEnvelope.Raw(), Cache->InputEnvelope.Length() );
                     Aligner.Execute( Alignment::ALGORITHM_NORMAL );
                     RefEnvelopeAligned.Wrap( Aligner.OutputSequence(0), Aligner.OutputSequenceLength(0) );
                     InputEnvelopeAligned.Wrap( Aligner.OutputSequence(1), Aligner.OutputSequenceLength(1) );
@@ -443,3 +442,61 @@ mutlib_result_t TraceAlignExecute( tracealign_t* ta )
     return ta->ResultCode;
 }
 
+
+
+/**
+   Aligns each of the 'n' inputs in 'b' against the reference traces
+   already set with TraceAlignSetReference(). The references are
+   preprocessed once and the scratch storage in the cache is reused for
+   every input, so a batch costs no more than its alignments.
+
+   Each item gets its own result code and takes ownership of its aligned
+   traces, which remain valid until TraceAlignDestroyBatch() is called.
+   Items are processed in order; the return value is the first failure
+   code encountered, or MUTLIB_RESULT_SUCCESS.
+*/
+mutlib_result_t TraceAlignExecuteBatch( tracealign_t* ta, tracealign_batch_t* b, int n )
+{
+   assert(ta != NULL);
+   assert(ta->Initialised);
+   assert(n==0 || b!=NULL);
+   mutlib_result_t Result = MUTLIB_RESULT_SUCCESS;
+   for( int k=0; k<n; k++ )
+   {
+      ta->Input     = b[k].Input;
+      ta->Input.New = 1;
+      b[k].ResultCode = TraceAlignExecute( ta );
+      // Hand the aligned traces over to the batch item
+      for( int i=0; i<2; i++ )
+      {
+         b[k].Alignment[i] = ta->Alignment[i];
+         std::memset( &ta->Alignment[i], 0, sizeof(mutlib_trace_t) );
+      }
+      if( (b[k].ResultCode!=MUTLIB_RESULT_SUCCESS) && (Result==MUTLIB_RESULT_SUCCESS) )
+         Result = b[k].ResultCode;
+   }
+   return Result;
+}
+
+
+
+/**
+   Frees the aligned traces held by the 'n' items in 'b' after a call to
+   TraceAlignExecuteBatch(). The input traces are untouched.
+*/
+void TraceAlignDestroyBatch( tracealign_batch_t* b, int n )
+{
+   assert(n==0 || b!=NULL);
+   for( int k=0; k<n; k++ )
+   {
+      for( int i=0; i<2; i++ )
+      {
+         if( b[k].Alignment[i].Trace )
+         {
+            Trace t;
+            t.Wrap( b[k].Alignment[i].Trace, true );
+         }
+         std::memset( &b[k].Alignment[i], 0, sizeof(mutlib_trace_t) );
+      }
+   }
+}
@@ -27,6 +27,9 @@ void TraceAlignCache::Flush()
    RefData[0].Flush();
    RefData[1].Flush();
    AlignmentMatrix.Empty();
+   InputData.Flush();
+   RefEnvelope.Empty();
+   InputEnvelope.Empty();
 }
 
 
@@ -19,6 +19,8 @@
 
 
 #include <matrix.hpp>
+#include <array.hpp>
+#include <align.hpp>
 #include <tracealign_preprocess.hpp>
 
 
@@ -43,6 +45,16 @@ class TraceAlignCache
    // Cached data
    TraceAlignPreprocessor RefData[2];
    SimpleMatrix<int>      AlignmentMatrix;
+
+
+
+ public:
+   // Scratch data, reused by each execution to avoid reallocation
+   Alignment              SequenceAligner;
+   Alignment              EnvelopeAligner;
+   TraceAlignPreprocessor InputData;
+   SimpleArray<char>      RefEnvelope;
+   SimpleArray<char>      InputEnvelope;
 };
 
 
@@ -70,9 +70,8 @@ void TraceAlignPreprocessor::PreprocessTrace( Trace& t, bool bCacheBaseIntervalS
 
    
 
-   // Make copy of envelope
-   m_oEnvelope.Empty();
-   m_oEnvelope.Create( t.Samples() );
+   // Make copy of envelope, reusing any storage from a previous trace
+   m_oEnvelope.Resize( t.Samples() );
    for( int n=0; n<t.Samples(); n++ )
       m_oEnvelope[n] = Envelope[0][n];
 
@@ -94,9 +93,8 @@ void TraceAlignQuantiseEnvelope( NumericArray<int>& e, SimpleArray<char>& qe, in
 
 
 
-   // Allocate storage for output
-   qe.Empty();
-   qe.Create( e.Range() );
+   // Allocate storage for output, reusing the old buffer if big enough
+   qe.Resize( e.Range() );
 
 
    // Determine quanta, round up
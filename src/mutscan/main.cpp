@@ -20,6 +20,7 @@
 #include <cctype>           // For isspace(), toupper()
 #include <cstring>          // For strcpy(), strcat(), etc
 #include <cstdlib>          // For atof()
+#include <ctime>            // For clock()
 #include <staden.h>         // For io_lib and licence stuff
 #include <mutlib.h>         // For mutation library
 #include <pathutil.h>       // For MakeFullPath()
@@ -34,6 +35,10 @@
 
 const int BUFSIZE = 512;
 
+// Each queued trace keeps its experiment file open until the batch is
+// scanned, so the batch size must stay well inside the process fd limit.
+const int MAX_BATCHSIZE = 256;
+
 
 
 
@@ -55,6 +60,7 @@ void PrintUsage( mutscan_t& ms )
     std::fprintf( stdout, "Usage  : mutscan [options] <experiment-files>\n"
     "Options:\n"
     "[-a<mutation-count>]     = Alignment failure report threshold   (default=%0.0f)\n"
+    "[-b<batch-size>]         = Number of traces scanned per batch   (default=1, max=256)\n"
     "[-c]                     = Complement reverse strand tags       (default=off)\n"
     "[-f<file-of-filenames>]  = File of experiment filenames\n"
     "[-h<heterzygote-SNR>]    = Heterzygote SNR threshold in dB      (default=%0.2f)\n"
@@ -63,6 +69,7 @@ void PrintUsage( mutscan_t& ms )
     "[-q]                     = Quiet mode                           (default=off)\n"
     "[-u<peakdrop-threshold>] = Upper peak drop threshold percentage (default=%0.2f)\n"
     "[-w<search-window-size>] = Peak search window size in bases     (default=%0.2f)\n"
+    "[-x]                     = Throughput benchmark, no tag output  (default=off)\n"
     "[-p]                     = Proximity filter threshold...        (default=7)\n"
     "[-z]                     = Enter debugging loop and wait...     (default=off)\n",
      ms.Parameter[MUTSCAN_PARAMETER_ALIGNFAIL_THRESHOLD],
@@ -76,14 +83,14 @@ void PrintUsage( mutscan_t& ms )
 }
 
 // Filter clusters of tags too close to the end of MCOV
-void filter_tags ( mutscan_t& ms, int nTags, int threshold ) {
+void filter_tags ( mutlib_tag_t* pTags, int nTags, int threshold ) {
     int *scores_a, *scores;
     int cov_start = 0, cov_end = 0;
     const int win_len = 5;
 
     // Get coverage range
     for( int i=0; i<nTags; i++ ) {
-        mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
+        mutlib_tag_t* pTag = &pTags[i];
         assert(pTag != NULL);
 
 	if (std::strcmp(pTag->Type,"MCOV") == 0) {
@@ -106,7 +113,7 @@ void filter_tags ( mutscan_t& ms, int nTags, int threshold ) {
 
     // Convolve tag peaks
     for (int i=0; i < nTags; i++) {
-	mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
+	mutlib_tag_t* pTag = &pTags[i];
 	int pos = pTag->Position[0];
 	if (pos < 0) pos = 0;
 	if (pos > cov_end) pos = cov_end;
@@ -120,7 +127,7 @@ void filter_tags ( mutscan_t& ms, int nTags, int threshold ) {
 
     // Filter tags
     for (int i=0; i < nTags; i++) {
-	mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
+	mutlib_tag_t* pTag = &pTags[i];
 	int pos = pTag->Position[0];
 
 	if (std::strcmp(pTag->Type,"MCOV") == 0)
@@ -138,7 +145,7 @@ void filter_tags ( mutscan_t& ms, int nTags, int threshold ) {
     int cost = 0, highest_cost = 0;
     int range_start = 0, range_end = 0;
     for ( int i=0; i<nTags; i++) {
-        mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
+        mutlib_tag_t* pTag = &pTags[i];
 
 	cost += 4;
 	if (i != range_start)
@@ -169,7 +176,7 @@ void filter_tags ( mutscan_t& ms, int nTags, int threshold ) {
     int cost = -5, last = cov_start;
     puts("==Left==");
     for( int i=0; i<nTags; i++ ) {
-        mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
+        mutlib_tag_t* pTag = &pTags[i];
         assert(pTag != NULL);
 	if (std::strcmp(pTag->Type,"MCOV") == 0)
 	    continue;
@@ -189,7 +196,7 @@ void filter_tags ( mutscan_t& ms, int nTags, int threshold ) {
     last = cov_end;
     puts("==Right==");
     for( int i=nTags-1; i>=0; i-- ) {
-        mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
+        mutlib_tag_t* pTag = &pTags[i];
         assert(pTag);
 	if (std::strcmp(pTag->Type,"MCOV") == 0)
 	    continue;
@@ -206,6 +213,98 @@ void filter_tags ( mutscan_t& ms, int nTags, int threshold ) {
 #endif
 }
 
+// Adjust QR, filter and write the tags for one scanned trace
+void OutputTags( Exp_info* pExpFile, mutlib_tag_t* pTags, int nTags, int nInputClipR, int proximityThreshold, bool bQuiet )
+{
+    char pBuffer[BUFSIZE];
+
+
+    // Find the rightmost tag position for this trace
+    int nRightmostTag = -1;
+    for( int i=0; i<nTags; i++ )
+    {
+        if( pTags[i].Position[0] > nRightmostTag )
+            nRightmostTag = pTags[i].Position[0];
+    }
+
+
+
+    // If mutation tag is beyond the right clip point (as in the case of
+    // insertions/deletions), we adjust QR so that it's visible in gap4.
+    if( (nTags>0) && (nInputClipR<=nRightmostTag) )
+    {
+        std::sprintf( pBuffer, "%d", nRightmostTag+1 );
+        exp_put_str( pExpFile, EFLT_QR, pBuffer, std::strlen(pBuffer) );
+    }
+
+    // Filter clusters of tags too close to the end of MCOV
+    filter_tags( pTags, nTags, proximityThreshold );
+
+    // Output results
+    for( int i=0; i<nTags; i++ )
+    {
+        // Write mutation tags to experiment file & stdout
+        mutlib_tag_t* pTag = &pTags[i];
+
+        if (!*pTag->Type)
+          continue;
+
+        bool bCoverageTag = std::strcmp(pTag->Type,"MCOV") == 0;
+        char sc = (pTag->Strand==MUTLIB_STRAND_FORWARD) ? '+' : '-';
+        if( bCoverageTag )
+        {
+            std::sprintf( pBuffer, "%s %c %d..%d", pTag->Type, sc, pTag->Position[0], pTag->Position[1] );
+            if( !bQuiet )
+            {
+                std::fprintf( stdout, "%s\n", pBuffer );
+                std::fflush( stdout );
+            }
+        }
+        else
+        {
+            std::sprintf( pBuffer, "%s %c %d..%d\n%s", pTag->Type, sc, pTag->Position[0], pTag->Position[1], pTag->Comment );
+            if( !bQuiet )
+            {
+                std::fprintf( stdout, "%s %5d %s\n", pTag->Type, pTag->Position[0], pTag->Comment );
+                std::fflush( stdout );
+            }
+        }
+        exp_put_str(pExpFile, EFLT_TG, pBuffer, std::strlen(pBuffer) );
+    }
+}
+
+
+
+// Scan the queued traces, report the results in input order and release them
+void ScanBatch( mutscan_t& ms, mutscan_batch_t* pBatch, Exp_info** pBatchExp, int nBatch,
+                int proximityThreshold, bool bQuiet, bool bBenchmark, std::clock_t& nScanTime )
+{
+    std::clock_t t = std::clock();
+    MutScanExecuteBatch( &ms, pBatch, nBatch );
+    nScanTime += std::clock() - t;
+    for( int k=0; k<nBatch; k++ )
+    {
+        if( pBatch[k].ResultCode )
+        {
+            // Error
+            std::fprintf( stderr, "%s", pBatch[k].ResultString );
+            std::fflush( stderr );
+        }
+        else if( !bBenchmark )
+        {
+            OutputTags( pBatchExp[k], pBatch[k].Tag, pBatch[k].TagCount,
+                        pBatch[k].Input.ClipR, proximityThreshold, bQuiet );
+        }
+        exp_destroy_info( pBatchExp[k] );
+        read_deallocate( pBatch[k].Input.Trace );
+        pBatchExp[k]          = 0;
+        pBatch[k].Input.Trace = 0;
+    }
+    MutScanDestroyBatch( pBatch, nBatch );
+}
+
+
+
 //-----------
 // Tracediff
 //-----------
@@ -237,6 +336,14 @@ int main( int argc, char* argv[] )
     double          nPeakDropThresholdLower   = -1.0;
     double          nHeterozygoteSNRThreshold = -1.0;
     int 	    proximityThreshold = 7;
+    int             nBatchSize                = 1;
+    int             nBatch                    = 0;
+    int             nScanned                  = 0;
+    bool            bBenchmark                = false;
+    mutscan_batch_t* pBatch                   = 0;
+    Exp_info**      pBatchExp                 = 0;
+    std::clock_t    nStartTime                = std::clock();
+    std::clock_t    nScanTime                 = 0;
     MutScanInit( &ms );
 
 
@@ -285,6 +392,21 @@ int main( int argc, char* argv[] )
                     break;
 
 
+                case 'b':
+                    // Batch size
+                    nBatchSize = std::atoi( pBuffer );
+                    if( nBatchSize < 1 )
+                        nBatchSize = 1;
+                    if( nBatchSize > MAX_BATCHSIZE )
+                    {
+                        std::fprintf( stderr, "Batch size %d is too large, the maximum is %d.\n",
+                                      nBatchSize, MAX_BATCHSIZE );
+                        std::fflush( stderr );
+                        return -1;
+                    }
+                    break;
+
+
                 case 'c':
                     // Complement reverse strand base tags
                     bComplementTags = true;
@@ -339,6 +461,12 @@ int main( int argc, char* argv[] )
                     break;
 
 
+                case 'x':
+                    // Throughput benchmark mode
+                    bBenchmark = true;
+                    break;
+
+
                 case 'z':
                     // Debug mode
                     bDebug = true;
@@ -420,6 +548,15 @@ int main( int argc, char* argv[] )
 
 
 
+        // Allocate the batch queue
+        pBatch    = new mutscan_batch_t[ nBatchSize ];
+        pBatchExp = new Exp_info*[ nBatchSize ];
+        std::memset( pBatch, 0, nBatchSize*sizeof(mutscan_batch_t) );
+        std::memset( pBatchExp, 0, nBatchSize*sizeof(Exp_info*) );
+        nStartTime = std::clock();
+
+
+
         // File processing loop
         for( n=0; n<FileList.Length(); n++ )
         {
@@ -557,78 +694,46 @@ int main( int argc, char* argv[] )
 
 
 
-            // Initialise the algorithm
-            MutScanSetInput( &ms, nStrand, pInputTrace, nInputClipL, nInputClipR );
-
-
-
-            // Execute the algorithm
-            MutScanExecute( &ms );
-            if( MutScanGetResultCode(&ms) )
-            {
-                // Error
-                std::fprintf( stderr, "%s", MutScanGetResultString(&ms) );
-                std::fflush( stderr );
-                continue;
-            }
-            int nTags = MutScanGetTagCount( &ms );
+            // Queue the trace, the batch takes over the experiment file and trace
+            pBatch[nBatch].Input.Trace  = pInputTrace;
+            pBatch[nBatch].Input.ClipL  = nInputClipL;
+            pBatch[nBatch].Input.ClipR  = nInputClipR;
+            pBatch[nBatch].Input.Strand = nStrand;
+            pBatchExp[nBatch]           = pExpFile;
+            pInputTrace                 = 0;
+            pExpFile                    = 0;
+            nBatch++;
+            nScanned++;
 
 
 
-            // Find the rightmost tag position for this trace
-            int nRightmostTag = -1;
-            for( int i=0; i<nTags; i++ )
+            // Scan the batch when full
+            if( nBatch == nBatchSize )
             {
-                mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
-                if( pTag->Position[0] > nRightmostTag )
-                    nRightmostTag = pTag->Position[0];
+                ScanBatch( ms, pBatch, pBatchExp, nBatch, proximityThreshold, bQuiet, bBenchmark, nScanTime );
+                nBatch = 0;
             }
+        }
 
 
 
-            // If mutation tag is beyond the right clip point (as in the case of
-            // insertions/deletions), we adjust QR so that it's visible in gap4.
-            if( (nTags>0) && (nInputClipR<=nRightmostTag) )
-            {
-                std::sprintf( pBuffer, "%d", nRightmostTag+1 );
-                exp_put_str( pExpFile, EFLT_QR, pBuffer, std::strlen(pBuffer) );
-            }
-
-	    // Filter clusters of tags too close to the end of MCOV
-	    filter_tags( ms, nTags, proximityThreshold );
+        // Scan whatever is left over
+        if( nBatch > 0 )
+        {
+            ScanBatch( ms, pBatch, pBatchExp, nBatch, proximityThreshold, bQuiet, bBenchmark, nScanTime );
+            nBatch = 0;
+        }
 
-            // Output results
-            for( int i=0; i<nTags; i++ )
-            {
-                // Write mutation tags to experiment file & stdout
-                mutlib_tag_t* pTag = MutScanGetTag( &ms, i );
-                assert(pTag != NULL);
 
-		if (!*pTag->Type)
-		  continue;
 
-                bool bCoverageTag = std::strcmp(pTag->Type,"MCOV") == 0;
-                char sc = (pTag->Strand==MUTLIB_STRAND_FORWARD) ? '+' : '-';
-                if( bCoverageTag )
-                {
-                    std::sprintf( pBuffer, "%s %c %d..%d", pTag->Type, sc, pTag->Position[0], pTag->Position[1] );
-                    if( !bQuiet )
-                    {
-                        std::fprintf( stdout, "%s\n", pBuffer );
-                        std::fflush( stdout );
-                    }
-                }
-                else
-                {
-                    std::sprintf( pBuffer, "%s %c %d..%d\n%s", pTag->Type, sc, pTag->Position[0], pTag->Position[1], pTag->Comment );
-                    if( !bQuiet )
-                    {
-                        std::fprintf( stdout, "%s %5d %s\n", pTag->Type, pTag->Position[0], pTag->Comment );
-                        std::fflush( stdout );
-                    }
-                }
-                exp_put_str(pExpFile, EFLT_TG, pBuffer, std::strlen(pBuffer) );
-            }
+        // Report throughput
+        if( bBenchmark )
+        {
+            double t     = double(std::clock() - nStartTime) / CLOCKS_PER_SEC;
+            double tscan = double(nScanTime) / CLOCKS_PER_SEC;
+            std::fprintf( stdout, "Scanned %d traces in %0.2fs (%0.2fs scanning), %0.1f traces/sec\n",
+                          nScanned, t, tscan, (t>0.0) ? nScanned/t : 0.0 );
+            std::fflush( stdout );
         }
     }
     catch( std::bad_alloc& )
@@ -649,6 +754,14 @@ int main( int argc, char* argv[] )
 
 
     // Cleanup & exit
+    for( n=0; n<nBatch; n++ )
+    {
+        exp_destroy_info( pBatchExp[n] );
+        read_deallocate( pBatch[n].Input.Trace );
+    }
+    MutScanDestroyBatch( pBatch, nBatch );
+    delete [] pBatch;
+    delete [] pBatchExp;
     if(pExpFile)     exp_destroy_info(pExpFile);
     if(pInputTrace)  read_deallocate(pInputTrace);
     if(pRefTrace[0]) read_deallocate(pRefTrace[0]);
@@ -8,34 +8,27 @@
 
 #include <os.h>
 #include "seqInfo.h"
+#include "polyA_clip.h"
 #include "dna_utils.h"
 #include "xalloc.h"
 #include <io_lib/misc.h>
 
-/* johnt 1/6/99 must explicitly import globals from DLLs with Visual C++*/
-#ifdef _MSC_VER
-#  define DLL_IMPORT __declspec(dllimport)
-#else
-#  define DLL_IMPORT
-#endif
- 
-extern DLL_IMPORT char *optarg;
-extern DLL_IMPORT int optind;
-
-typedef struct {
-  int score; 
-  int window_len;
-  int verbose;
-  int test_mode;
-  int min_len;
-} params;
-
+/*
+ * Fills out 'p' with the defaults used by the polyA_clip program.
+ */
+void polyA_default_params(polyA_params *p) {
+    p->min_len = 0;
+    p->verbose = 0;
+    p->window_len = 50;
+    p->test_mode = 0;
+    p->score = p->window_len * 95.0/100.0;
+}
 
 /*
  * Scans leftwards in a sequence the percentage A and T drops below
  * a specific threshold
  */
-int scan_left(params p, char *seq, int start_pos, int len) {
+static int scan_left(polyA_params p, char *seq, int start_pos, int len) {
   int i, left_edge, right_edge;
     int counts[5] = {0,0,0,0,0};
     int win_len = p.window_len;
@@ -92,7 +85,7 @@ int scan_left(params p, char *seq, int start_pos, int len) {
  * Scans rightwards in a sequence the percentage A and T drops below
  * a specific threshold
  */
-int scan_right(params p, char *seq, int start_pos, int len) {
+static int scan_right(polyA_params p, char *seq, int start_pos, int len) {
   int i, left_edge, right_edge;
     int counts[5] = {0,0,0,0,0};
     int win_len = p.window_len;
@@ -144,26 +137,22 @@ int scan_right(params p, char *seq, int start_pos, int len) {
 }
 
 /*
- * Quality clips file 'file', updating the QL and QR records in the process.
+ * Looks for a polyA tail and polyT head in an already loaded sequence,
+ * within its existing quality and vector clip points. *sr and *sl are set
+ * to the new SR and SL, or -1 if no tail or head was found; *len is the
+ * length remaining.
  *
  * Returns 0 for success.
- *        -1 for failure.
+ *        -1 if clipping the tail leaves less than p->min_len bases.
+ *        -2 if clipping the head leaves less than p->min_len bases (*sr
+ *           is still valid).
  */
-static int polyA_clip(char *file, params p) {
-    SeqInfo *si = NULL;
+int polyA_clip_seq(SeqInfo *si, polyA_params *p, int *sl, int *sr, int *len) {
     int i1, i2, seq_length, right_pos, left_pos;
     char *seq;
     char *expline;
-    FILE *fp;
 
-    if (p.verbose)
-	printf("Clipping file %s\n", file);
-
-    /* Read the sequence and confidence */
-    if (NULL == (si = read_sequence_details(file, 0))) {
-	fprintf(stderr, "Failed to read file '%s'\n", file);
-	return -1;
-    }
+    *sl = *sr = -1;
 
     seq = exp_get_entry(si->e, EFLT_SQ);
     seq_length = strlen ( seq );
@@ -192,128 +181,108 @@ static int polyA_clip(char *file, params p) {
     right_pos = MIN(i1,i2);
 
     i1 = right_pos;
-    right_pos = scan_left(p, seq, left_pos, right_pos);
+    right_pos = scan_left(*p, seq, left_pos, right_pos);
     
     if (right_pos > 0 ) {
-      if (right_pos - left_pos < p.min_len) {
-	fprintf(stderr, "Sequence too short (length=%d)\n",
-		right_pos - left_pos);
+      *len = right_pos - left_pos;
+      if (right_pos - left_pos < p->min_len)
+	return -1;
+      *sr = right_pos;
+    }
+    else {
+      /* first window not polyA or T so do nothing */
+      right_pos = i1;
+    }
+
+    left_pos = scan_right(*p, seq, left_pos, right_pos);
+    if (left_pos > 0 ) {
+      *len = right_pos - left_pos;
+      if (right_pos - left_pos < p->min_len)
+	return -2;
+      *sl = left_pos;
+    }
+
+    return 0;
+}
+
+/*
+ * Clips 'nseqs' loaded sequences. Returns the number that failed.
+ */
+int polyA_clip_batch(SeqInfo **si, int nseqs, polyA_params *p,
+		     int *sl, int *sr, int *status) {
+    int i, len, nfailed = 0;
+
+    for (i = 0; i < nseqs; i++) {
+	if ((status[i] = polyA_clip_seq(si[i], p, &sl[i], &sr[i], &len)) != 0)
+	    nfailed++;
+    }
+
+    return nfailed;
+}
+
+/*
+ * PolyA clips file 'file', updating the SL and SR records in the process.
+ *
+ * Returns 0 for success.
+ *        -1 for failure.
+ */
+int polyA_clip_file(char *file, polyA_params *p) {
+    SeqInfo *si = NULL;
+    int ret, sl, sr, len;
+    FILE *fp;
+
+    if (p->verbose)
+	printf("Clipping file %s\n", file);
+
+    /* Read the sequence and confidence */
+    if (NULL == (si = read_sequence_details(file, 0))) {
+	fprintf(stderr, "Failed to read file '%s'\n", file);
+	return -1;
+    }
+
+    ret = polyA_clip_seq(si, p, &sl, &sr, &len);
+    if (ret == -1) {
+	fprintf(stderr, "Sequence too short (length=%d)\n", len);
 	freeSeqInfo(si);
 	return -1;
-      }
+    }
 
-      /* Append details onto the end of the Exp File */
-      if (!p.test_mode) {
+    /* Append details onto the end of the Exp File */
+    if (sr > 0) {
+      if (!p->test_mode) {
 	if (NULL == (fp = fopen(file, "a"))) {
 	  fprintf(stderr, "Failed to write file '%s'\n", file);
 	  freeSeqInfo(si);
 	  return -1;
 	}
-	fprintf(fp, "SR   %d\n", right_pos);
+	fprintf(fp, "SR   %d\n", sr);
 	fclose(fp);
       } else {
-	printf("%-30s SR %4d\n", file, right_pos);
+	printf("%-30s SR %4d\n", file, sr);
       }
     }
-    else {
-      /* first window not polyA or T so do nothing */
-      right_pos = i1;
-      /*printf("%-30s no PolyA tail\n", file);*/
-    }
 
-    left_pos = scan_right(p, seq, left_pos, right_pos);
-    if (left_pos > 0 ) {
-      if (right_pos - left_pos < p.min_len) {
-	fprintf(stderr, "Sequence too short (length=%d)\n",
-		right_pos - left_pos);
+    if (ret == -2) {
+	fprintf(stderr, "Sequence too short (length=%d)\n", len);
 	freeSeqInfo(si);
 	return -1;
-      }
+    }
 
-      /* Append details onto the end of the Exp File */
-      if (!p.test_mode) {
+    if (sl > 0) {
+      if (!p->test_mode) {
 	if (NULL == (fp = fopen(file, "a"))) {
 	  fprintf(stderr, "Failed to write file '%s'\n", file);
 	  freeSeqInfo(si);
 	  return -1;
 	}
-	fprintf(fp, "SL   %d\n", left_pos);
+	fprintf(fp, "SL   %d\n", sl);
 	fclose(fp);
       } else {
-	printf("%-30s SL %4d\n", file, left_pos);
+	printf("%-30s SL %4d\n", file, sl);
       }
     }
-    else {
-      /* first window not polyA or T so do nothing */
-      /*printf("%-30s no PolyT head\n", file);*/
-    }
+
     freeSeqInfo(si);
     return 0;
 }
 
-static void usage(void) {
-fprintf(stderr,
-	"Usage:\n"
-	"polyA_clip [-vt] [-p percent cutoff(95)] [-x min_length(0)]\n"
-	"                  [-w window length(50)] file...\n");
-    exit(1);
-}
-
-int main(int argc, char **argv) {
-    int c, i, ret = 0;
-double perc;
-    params p;
-
-    /* Defaults */
-    p.min_len = 0;
-    p.verbose = 0;
-    p.window_len = 50;
-    p.test_mode = 0;
-    perc = 95.0;
-    set_dna_lookup();
-    set_char_set(1);
-    while ((c = getopt(argc, argv, "w:x:p:vtx")) != -1) {
-	switch (c) {
-
-	case 'v':
-	    p.verbose = 1;
-	    break;
-
-	case 't':
-	    p.test_mode = 1;
-	    break;
-
-	case 'x':
-	    p.min_len = atoi(optarg);
-	    break;
-
-	case 'w':
-	    p.window_len = atoi(optarg);
-	    break;
-
-	case 'p':
-	    perc = atof(optarg);
-	    break;
-
-	default:
-	    usage();
-	}
-    }
-
-    if (optind == argc)
-	usage();
-
-    p.score = p.window_len * perc/100.0;
-
-    for (i = optind; i < argc; i++) {
-	int ret_val;
-
-	ret_val = polyA_clip(argv[i], p);
-	if (p.verbose)
-	    printf("    polyA_clip() returned %d\n", ret_val);
-
-	ret |= ret_val;
-    }
-
-    return ret ? 1 : 0;
-}
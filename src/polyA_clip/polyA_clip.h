@@ -0,0 +1,49 @@
+#ifndef _POLYA_CLIP_H_
+#define _POLYA_CLIP_H_
+
+#include "seqInfo.h"
+
+typedef struct {
+  int score; 		/* number of A (or T) needed in a window */
+  int window_len;
+  int verbose;
+  int test_mode;	/* 1 => do not write out changes */
+  int min_len;		/* minimum length */
+} polyA_params;
+
+/*
+ * Fills out 'p' with the defaults used by the polyA_clip program.
+ */
+void polyA_default_params(polyA_params *p);
+
+/*
+ * Looks for a polyA tail and polyT head in an already loaded sequence,
+ * setting *sr and *sl to the new SR and SL (or -1 if none was found) and
+ * *len to the length left. Nothing is written to disk and si itself is not
+ * altered.
+ *
+ * Returns 0 for success.
+ *        -1 if clipping the tail leaves less than p->min_len bases.
+ *        -2 if clipping the head leaves less than p->min_len bases.
+ */
+int polyA_clip_seq(SeqInfo *si, polyA_params *p, int *sl, int *sr, int *len);
+
+/*
+ * Runs polyA_clip_seq() over 'nseqs' sequences, filling out sl[i], sr[i]
+ * and status[i] (the polyA_clip_seq return value) for each.
+ *
+ * Returns the number of sequences that failed.
+ */
+int polyA_clip_batch(SeqInfo **si, int nseqs, polyA_params *p,
+		     int *sl, int *sr, int *status);
+
+/*
+ * PolyA clips file 'file', appending SL and SR records to it (or just
+ * printing them in test mode).
+ *
+ * Returns 0 for success.
+ *        -1 for failure.
+ */
+int polyA_clip_file(char *file, polyA_params *p);
+
+#endif /* _POLYA_CLIP_H_ */
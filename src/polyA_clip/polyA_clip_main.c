@@ -0,0 +1,82 @@
+#include <staden_config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include "polyA_clip.h"
+#include "dna_utils.h"
+
+/* johnt 1/6/99 must explicitly import globals from DLLs with Visual C++*/
+#ifdef _MSC_VER
+#  define DLL_IMPORT __declspec(dllimport)
+#else
+#  define DLL_IMPORT
+#endif
+ 
+extern DLL_IMPORT char *optarg;
+extern DLL_IMPORT int optind;
+
+static void usage(void) {
+fprintf(stderr,
+	"Usage:\n"
+	"polyA_clip [-vt] [-p percent cutoff(95)] [-x min_length(0)]\n"
+	"                  [-w window length(50)] file...\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int c, i, ret = 0;
+double perc;
+    polyA_params p;
+
+    /* Defaults */
+    polyA_default_params(&p);
+    perc = 95.0;
+    set_dna_lookup();
+    set_char_set(1);
+    while ((c = getopt(argc, argv, "w:x:p:vtx")) != -1) {
+	switch (c) {
+
+	case 'v':
+	    p.verbose = 1;
+	    break;
+
+	case 't':
+	    p.test_mode = 1;
+	    break;
+
+	case 'x':
+	    p.min_len = atoi(optarg);
+	    break;
+
+	case 'w':
+	    p.window_len = atoi(optarg);
+	    break;
+
+	case 'p':
+	    perc = atof(optarg);
+	    break;
+
+	default:
+	    usage();
+	}
+    }
+
+    if (optind == argc)
+	usage();
+
+    p.score = p.window_len * perc/100.0;
+
+    for (i = optind; i < argc; i++) {
+	int ret_val;
+
+	ret_val = polyA_clip_file(argv[i], &p);
+	if (p.verbose)
+	    printf("    polyA_clip() returned %d\n", ret_val);
+
+	ret |= ret_val;
+    }
+
+    return ret ? 1 : 0;
+}
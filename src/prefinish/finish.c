@@ -160,10 +160,10 @@ static finish_t *finish_new(void) {
     fin->nskip_tags = 0;
     fin->external_seq = NULL;
     fin->external_seq_rev = NULL;
-    fin->external_seq_h = NULL;
+    fin->external_seq_idx = NULL;
     fin->all_cons = NULL;
     fin->all_cons_len = 0;
-    fin->all_cons_h = NULL;
+    fin->all_cons_idx = NULL;
     fin->command_token = NULL;
     Tcl_DStringInit(&fin->tag_list);
     for (i = 0; i < 10; i++)
@@ -293,9 +293,9 @@ static void finish_del(finish_t *fin) {
 	xfree(fin->external_seq_rev);
     }
 
-    if (fin->external_seq_h) {
-	free_hash8n(fin->external_seq_h);
-	fin->external_seq_h = NULL;
+    if (fin->external_seq_idx) {
+	primer_index_destroy(fin->external_seq_idx);
+	fin->external_seq_idx = NULL;
     }
 
     if (fin->all_cons) {
@@ -303,9 +303,9 @@ static void finish_del(finish_t *fin) {
 	fin->all_cons = NULL;
     }
 
-    if (fin->all_cons_h) {
-	free_hash8n(fin->all_cons_h);
-	fin->all_cons_h = NULL;
+    if (fin->all_cons_idx) {
+	primer_index_destroy(fin->all_cons_idx);
+	fin->all_cons_idx = NULL;
     }
 
     xfree(fin);
@@ -726,6 +726,8 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 	        offsetof(finish_t, args.external_seq_file)},
 	{"-output_file",       ARG_STR,   1, NULL,
 	        offsetof(finish_t, args.output_file)},
+	{"-first_id",          ARG_INT,   1, NULL,
+	        offsetof(finish_t, args.first_id)},
 	{"-use_avg_insert",    ARG_INT,   1, NULL,
 	 	offsetof(finish_t, opts.use_avg_insert)},
 	{"-mandatory_ratio",   ARG_DBL, 1, NULL,
@@ -897,6 +899,15 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
     if (-1 == gap_parse_obj_config(conf, fin, objc, (Tcl_Obj **)objv)) {
 	return TCL_ERROR;
     }
+
+    /*
+     * Several prefinish processes working on separate contigs of the same
+     * database use distinct ranges so their experiment ids do not clash.
+     */
+    if (fin->args.first_id > 0) {
+	finish_next_expt_id(fin->args.first_id);
+	finish_next_group_id(fin->args.first_id);
+    }
     
     /* Contigs to check primers against - hash them */
     if (!fin->opts.no_consensus && fin->args.ccontigs && *fin->args.ccontigs) {
@@ -920,9 +931,9 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 	    fin->all_cons = NULL;
 	}
 	fin->all_cons_len = 0;
-	if (fin->all_cons_h) {
-	    free_hash8n(fin->all_cons_h);
-	    fin->all_cons_h = NULL;
+	if (fin->all_cons_idx) {
+	    primer_index_destroy(fin->all_cons_idx);
+	    fin->all_cons_idx = NULL;
 	}
 
 	/* Compute the entire consensus, used for chromosomal primer match */
@@ -941,23 +952,12 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 	depad_seq(fin->all_cons, &fin->all_cons_len, NULL);
 
 	/* hash it */
-	if (init_hash8n(fin->all_cons_len, FIN_MAXPRIMERLEN,
-			4 /* word_length */,
-			0 /* max_matches - unused */,
-			0 /* min_match - unused */,
-			1 /* job */,
-			&fin->all_cons_h)) {
+	if (NULL == (fin->all_cons_idx =
+		     primer_index_create(fin->all_cons, fin->all_cons_len))) {
 	    verror(ERR_WARN, "finish_init", "Failed to hash consenus");
-	    fin->all_cons_h = NULL;
 	    xfree(fin->all_cons);
 	    fin->all_cons = NULL;
 	}
-	
-	fin->all_cons_h->seq1 = fin->all_cons;
-	fin->all_cons_h->seq1_len = fin->all_cons_len;
-
-	hash_seqn(fin->all_cons_h, 1);
-	store_hashn(fin->all_cons_h);
 
 	if (check_contigs)
 	    xfree(check_contigs);
@@ -990,9 +990,9 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 	    fin->external_seq_rev = NULL;
 	}
 	fin->external_seq_len = 0;
-	if (fin->external_seq_h) {
-	    free_hash8n(fin->external_seq_h);
-	    fin->external_seq_h = NULL;
+	if (fin->external_seq_idx) {
+	    primer_index_destroy(fin->external_seq_idx);
+	    fin->external_seq_idx = NULL;
 	}
 
 	/* Copy and depad sequence */
@@ -1012,23 +1012,13 @@ static int tcl_finish_configure(finish_t *fin, Tcl_Interp *interp,
 #endif
 
 	/* Hash it */
-	if (init_hash8n(fin->external_seq_len, FIN_MAXPRIMERLEN,
-			4 /* word_length */,
-			0 /* max_matches - unused */,
-			0 /* min_match - unused */,
-			1 /* job */,
-			&fin->external_seq_h)) {
+	if (NULL == (fin->external_seq_idx =
+		     primer_index_create(fin->external_seq,
+					 fin->external_seq_len))) {
 	    verror(ERR_WARN, "finish_init", "Failed to hash external_seq");
-	    fin->external_seq_h = NULL;
 	    xfree(fin->external_seq);
 	    fin->external_seq = NULL;
 	}
-	
-	fin->external_seq_h->seq1 = fin->external_seq;
-	fin->external_seq_h->seq1_len = fin->external_seq_len;
-
-	hash_seqn(fin->external_seq_h, 1);
-	store_hashn(fin->external_seq_h);
     }
 
     if (eseq_alloced && eseq) {
@@ -116,6 +116,7 @@ typedef struct {
     char *pscores;
     char *mscores;
     char *output_file;
+    int   first_id;		/* Number experiments/groups from here */
 } finish_args_t;
 
 typedef struct {
@@ -159,11 +160,11 @@ typedef struct {
     int		       nskip_tags;	/* Number of elements in skip_tags */
     char	      *external_seq;	/* External sequence (eg vector) */
     int		       external_seq_len;/* Length of external_seq */
-    Hash	      *external_seq_h;	/* Hash of external_seq */
+    primer_index_t    *external_seq_idx;/* Hash of external_seq */
     char	      *external_seq_rev;/* Reverse complement of external_seq*/
     char	      *all_cons;	/* Complete consensus sequence (cat) */
     int	      	       all_cons_len;	/* Length of all_cons */
-    Hash	      *all_cons_h;	/* Hash of all_cons */
+    primer_index_t    *all_cons_idx;	/* Hash of all_cons */
 
     Tcl_Command	       command_token;	/* From Tcl_CreateObjCommand() */
 
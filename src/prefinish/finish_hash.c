@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include "finish_hash.h"
 #include "dna_utils.h"
@@ -143,32 +144,23 @@ static double false_priming(int end,
 extern int dna_hash8_lookup[256];
 
 /*
- * Compares a primer sequence 'prim' of length 'lprim' against a hashed
- * sequence stored in Hash. The primer is automatically checked in both
- * directions, but the primer must consist of upper case A,C,G,T characters
- * only.
+ * The body of hash_compare_primer(). The message describing the best match
+ * is left in best_msg_buf rather than printed.
  *
- * Arguments:
- *	h		Hashed sequence
- *	prim		Primer sequence (must be uppercase)
- *	lprim		Length of primer sequence
- *	max_match	Maximum score before we reject (due to 2ndary prim)
- *	skip_self	How many matches to skip past (on skip_strand only)
- *	skip_strand	Strand (0=top,1=bot) on which skip_self counts.
- *
- * Returns:
- *	-1	Error
- *	>= 0	Score (high means strong match, low means poor match)
+ * If 'seen' is non NULL it is used to avoid scoring the same alignment more
+ * than once when several primer words hit it. It must hold
+ * h->seq1_len + FIN_MAXPRIMERLEN elements, none of which exceed *gen.
  */
-double hash_compare_primer(Hash *h, char *prim, int lprim,
-			   double max_match, int skip_self, int skip_strand) {
+static double compare_hashed(Hash *h, int *seen, int *gen,
+			     char *prim, int lprim,
+			     int skip_self, int skip_strand,
+			     char *best_msg_buf) {
     int nrw, ncw, word, pw2, pw1, j;
     /* int maxmis = (1 - minmat) * lprim; */
     signed int last_pos = -1;
     int strand;
     char pcopy[FIN_MAXPRIMERLEN];
     double max_pscore = 0;
-    char msg_buf[1024], best_msg_buf[1024];
 
     *best_msg_buf = 0;
 
@@ -176,7 +168,7 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
     if(h->seq1_len < h->word_length)
 	return -1; 
 
-    if(lprim < h->word_length)
+    if(lprim < h->word_length || lprim > FIN_MAXPRIMERLEN)
 	return -1; 
     
     memcpy(pcopy, prim, lprim);
@@ -194,6 +186,11 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
 	    return -1;
 	}
 
+	if (seen && ++*gen == INT_MAX) {
+	    memset(seen, 0, (h->seq1_len + FIN_MAXPRIMERLEN) * sizeof(*seen));
+	    *gen = 1;
+	}
+
 	/* loop for all (nrw) complete words in values2 (primer) */
 	for (pw2=0;pw2<nrw;pw2++) {
 	    if ((word = h->values2[pw2]) == -1)
@@ -204,9 +201,6 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
 
 	    /* Check each matching word from seq1 for a 'real' match */
 	    for (j=0,pw1=h->last_word[word];j<ncw;j++) {
-#if 0
-		int nmismatch;
-#endif
 		double pscore;
 		int perfect;
 
@@ -215,46 +209,35 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
 		    continue;
 		}
 
+		/* Already scored via an earlier word of this primer? */
+		if (seen) {
+		    int *s = &seen[pw1 - pw2 + FIN_MAXPRIMERLEN];
+		    if (*s == *gen) {
+			pw1 = h->values1[pw1];
+			continue;
+		    }
+		    *s = *gen;
+		}
+
 		pscore = false_priming(strand ? 0 : 1,
 				       h->seq1, h->seq1_len, pw1,
 				       h->seq2, h->seq2_len, pw2,
 				       &perfect,
-				       msg_buf);
-
-		if (pw1-pw2 != last_pos) {
-		    if (self_count && perfect) {
-			self_count--;
-			last_pos = pw1 - pw2;
-		    } else {
-			/* Matches elsewhere */
-			if (pscore > max_pscore) {
-			    max_pscore = pscore;
-			    strcpy(best_msg_buf, msg_buf);
-			}
-		    }
+				       NULL);
+
+		if (self_count && perfect) {
+		    self_count--;
+		    last_pos = pw1 - pw2;
+		} else if (pscore > max_pscore) {
+		    /* Matches elsewhere */
+		    max_pscore = pscore;
+		    false_priming(strand ? 0 : 1,
+				  h->seq1, h->seq1_len, pw1,
+				  h->seq2, h->seq2_len, pw2,
+				  &perfect,
+				  best_msg_buf);
 		}
 
-
-#if 0
-		nmismatch = count_mismatches(maxmis,
-					     h->seq1, h->seq1_len, pw1,
-					     h->seq2, h->seq2_len, pw2);
-		if (nmismatch <= maxmis) {
-		    if (fin->opts.debug[FIN_DEBUG_VPWALK] > 1)
-			printf("Match strand=%d pos=%d, last_pos=%d, "
-			       "self_count=%d\n",
-			       strand, pw1-pw2, last_pos, self_count);
-		    if (pw1-pw2 != last_pos) {
-			if (self_count) {
-			    self_count--;
-			} else {
-			    return 1;
-			}
-			last_pos = pw1 - pw2;
-		    }
-		}
-#endif
-
 		pw1 = h->values1[pw1];
 	    }
 	}
@@ -263,6 +246,35 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
 	complement_seq(pcopy, lprim);
     }
 
+    return max_pscore;
+}
+
+/*
+ * Compares a primer sequence 'prim' of length 'lprim' against a hashed
+ * sequence stored in Hash. The primer is automatically checked in both
+ * directions, but the primer must consist of upper case A,C,G,T characters
+ * only.
+ *
+ * Arguments:
+ *	h		Hashed sequence
+ *	prim		Primer sequence (must be uppercase)
+ *	lprim		Length of primer sequence
+ *	max_match	Maximum score before we reject (due to 2ndary prim)
+ *	skip_self	How many matches to skip past (on skip_strand only)
+ *	skip_strand	Strand (0=top,1=bot) on which skip_self counts.
+ *
+ * Returns:
+ *	-1	Error
+ *	>= 0	Score (high means strong match, low means poor match)
+ */
+double hash_compare_primer(Hash *h, char *prim, int lprim,
+			   double max_match, int skip_self, int skip_strand) {
+    char best_msg_buf[1024];
+    double max_pscore;
+
+    max_pscore = compare_hashed(h, NULL, NULL, prim, lprim,
+				skip_self, skip_strand, best_msg_buf);
+
 #if 1
     if (max_pscore >= max_match && *best_msg_buf)
 	printf("%s", best_msg_buf);
@@ -271,6 +283,132 @@ double hash_compare_primer(Hash *h, char *prim, int lprim,
     return max_pscore;
 }
 
+/*
+ * Cached result of a primer_index_compare() call. The message is only kept
+ * when it was printed.
+ */
+typedef struct {
+    double score;
+    char *msg;
+} primer_score_t;
+
+/*
+ * Hashes 'seq' (which should already be depadded and unmasked) for use by
+ * primer_index_compare(). The sequence is not copied and must remain valid
+ * for the lifetime of the index.
+ *
+ * Returns the index on success
+ *         NULL on failure
+ */
+primer_index_t *primer_index_create(char *seq, int len) {
+    primer_index_t *pi;
+
+    if (NULL == (pi = (primer_index_t *)xcalloc(1, sizeof(*pi))))
+	return NULL;
+
+    if (init_hash8n(len, FIN_MAXPRIMERLEN,
+		    4 /* word_length */,
+		    0 /* max_matches - unused */,
+		    0 /* min_match - unused */,
+		    1 /* job */,
+		    &pi->h)) {
+	xfree(pi);
+	return NULL;
+    }
+
+    pi->h->seq1 = seq;
+    pi->h->seq1_len = len;
+    if (hash_seqn(pi->h, 1)) {
+	free_hash8n(pi->h);
+	xfree(pi);
+	return NULL;
+    }
+    store_hashn(pi->h);
+
+    if (NULL == (pi->seen = (int *)xcalloc(len + FIN_MAXPRIMERLEN,
+					   sizeof(*pi->seen)))) {
+	free_hash8n(pi->h);
+	xfree(pi);
+	return NULL;
+    }
+    pi->gen = 0;
+
+    Tcl_InitHashTable(&pi->cache, TCL_STRING_KEYS);
+
+    return pi;
+}
+
+void primer_index_destroy(primer_index_t *pi) {
+    Tcl_HashEntry *hent;
+    Tcl_HashSearch search;
+
+    if (!pi)
+	return;
+
+    for (hent = Tcl_FirstHashEntry(&pi->cache, &search);
+	 hent;
+	 hent = Tcl_NextHashEntry(&search)) {
+	primer_score_t *ps = (primer_score_t *)Tcl_GetHashValue(hent);
+	if (ps->msg)
+	    xfree(ps->msg);
+	xfree(ps);
+    }
+    Tcl_DeleteHashTable(&pi->cache);
+
+    free_hash8n(pi->h);
+    xfree(pi->seen);
+    xfree(pi);
+}
+
+/*
+ * As hash_compare_primer(), but against a primer_index_t. Each word hit is
+ * only scored once per strand, and the result for a given primer is
+ * remembered so that checking it again (as happens when the same candidate
+ * is considered for several problems) is a simple lookup.
+ *
+ * Returns:
+ *	-1	Error
+ *	>= 0	Score (high means strong match, low means poor match)
+ */
+double primer_index_compare(primer_index_t *pi, char *prim, int lprim,
+			    double max_match, int skip_self, int skip_strand) {
+    char key[FIN_MAXPRIMERLEN+100];
+    char best_msg_buf[1024];
+    Tcl_HashEntry *hent;
+    primer_score_t *ps;
+    int is_new;
+
+    if (lprim > FIN_MAXPRIMERLEN)
+	return -1;
+
+    pi->lookups++;
+    sprintf(key, "%d %d %g %.*s", skip_self, skip_strand, max_match,
+	    lprim, prim);
+    hent = Tcl_CreateHashEntry(&pi->cache, key, &is_new);
+    if (!is_new) {
+	pi->hits++;
+	ps = (primer_score_t *)Tcl_GetHashValue(hent);
+	if (ps->msg)
+	    printf("%s", ps->msg);
+	return ps->score;
+    }
+
+    if (NULL == (ps = (primer_score_t *)xmalloc(sizeof(*ps)))) {
+	Tcl_DeleteHashEntry(hent);
+	return -1;
+    }
+    ps->score = compare_hashed(pi->h, pi->seen, &pi->gen, prim, lprim,
+			       skip_self, skip_strand, best_msg_buf);
+    ps->msg = NULL;
+    if (ps->score >= max_match && *best_msg_buf) {
+	printf("%s", best_msg_buf);
+	ps->msg = strdup(best_msg_buf);
+    }
+    Tcl_SetHashValue(hent, (ClientData)ps);
+
+    return ps->score;
+}
+
 /*
  * This is a wrapper around hash_compare_primer for when we do not already
  * have a hashed sequence. Hashing a sequence and comparing the hashes is still
@@ -1,11 +1,34 @@
 #ifndef _FINISH_HASH_H_
 #define _FINISH_HASH_H_
 
+#include <tcl.h>
 #include "align_lib.h"
 #include "hash_lib.h"
 
 #define FIN_MAXPRIMERLEN 50
 
+/*
+ * A sequence that is hashed once and then checked against many primers
+ * (the whole database consensus and the external sequence). Scores of the
+ * primers already checked are remembered so that each distinct primer is
+ * only compared once.
+ */
+typedef struct {
+    Hash	      *h;		/* 4-mer hash of the sequence */
+    int		      *seen;		/* Offsets visited, by generation */
+    int		       gen;		/* Current seen[] generation */
+    Tcl_HashTable      cache;		/* Key => primer_score_t */
+    int		       lookups;		/* Number of primers checked */
+    int		       hits;		/* ... of which were in the cache */
+} primer_index_t;
+
+primer_index_t *primer_index_create(char *seq, int len);
+
+void primer_index_destroy(primer_index_t *pi);
+
+double primer_index_compare(primer_index_t *pi, char *prim, int lprim,
+			    double max_match, int skip_self, int skip_strand);
+
 double hash_compare_primer(Hash *h, char *prim, int lprim,
 			   double minmat, int skip_self, int skip_strand);
 
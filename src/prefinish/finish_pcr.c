@@ -20,7 +20,7 @@
 /*
  * Filters primers based on strong matches to secondary binding sites.
  * The data to screen against for repeats has already been setup in the
- * fin record. Ie fin->all_cons_h and fin->external_seq_h. For this to work
+ * fin record. Ie fin->all_cons_idx and fin->external_seq_idx. For this to work
  * we need to know which strand this primer was chosen for so the self-match
  * (at 100% obviously) can be ignored.
  *
@@ -246,11 +246,137 @@ proc usage {} {
                          for each primer in primer-walk experiments.
 
    --method method       \"method\" is one of walk or reseq. Specifies which
-                         experiment type to use."
+                         experiment type to use.
+
+   --jobs N              Splits the contigs between N prefinish processes run
+                         at once. Their output is merged back in contig order."
 
     exit 0
 }
 
+# -----------------------------------------------------------------------------
+# Running several prefinish processes at once.
+#
+# The contigs are split into 'njobs' consecutive runs of roughly equal total
+# length and each run is given to a copy of this script started with
+# "--worker N --contigs list". Workers open the database read-only and
+# write their experiments, tags and problem dumps to files suffixed by .N,
+# while their ids start at (N+1)*1000000 so they do not clash. Once all
+# have finished the files are merged in worker (and hence contig) order so
+# the output does not depend on which worker finished first.
+
+proc run_workers {njobs contigs dbarg worker_args} {
+    global io clen dbname dbvers add_tags dump_problems prob_file workers
+
+    # Partition
+    set total 0
+    foreach cnum $contigs {
+	incr total $clen($cnum)
+    }
+    set chunks {}
+    set chunk {}
+    set len 0
+    set left [llength $contigs]
+    foreach cnum $contigs {
+	lappend chunk "#[left_gel $io $cnum]"
+	incr len $clen($cnum)
+	incr left -1
+	set need [expr {$njobs - [llength $chunks] - 1}]
+	if {$need > 0 && ($left <= $need ||
+			  $len >= double($total) * ([llength $chunks]+1)/$njobs)} {
+	    lappend chunks $chunk
+	    set chunk {}
+	}
+    }
+    if {$chunk != ""} {
+	lappend chunks $chunk
+    }
+
+    puts "*** Running [llength $chunks] prefinish processes"
+    flush stdout
+
+    # Start them
+    set workers(running) 0
+    set n 0
+    foreach chunk $chunks {
+	set cmd [concat [list [info nameofexecutable] [info script]] \
+		     $worker_args \
+		     [list --worker $n --contigs $chunk]]
+	if {$dump_problems} {
+	    lappend cmd --dump_problems $prob_file.$n
+	}
+	lappend cmd $dbarg 2>@1
+
+	set workers(log,$n) [open $dbname.$dbvers.worker$n.log w]
+	set fd [open |$cmd r]
+	fconfigure $fd -blocking 0
+	fileevent $fd readable [list worker_output $fd $n]
+	incr workers(running)
+	incr n
+    }
+
+    while {$workers(running)} {
+	vwait workers(running)
+    }
+
+    # Merge the results in order
+    set exp_fd [open $dbname.$dbvers.experiments w]
+    set tag_fd [open tags a]
+    if {$dump_problems} {
+	set prob_fd [open $prob_file w]
+    }
+    for {set i 0} {$i < $n} {incr i} {
+	foreach {file out} [list \
+				$dbname.$dbvers.worker$i.log stdout \
+				$dbname.$dbvers.experiments.$i $exp_fd] {
+	    if {![catch {set fd [open $file]}]} {
+		puts -nonewline $out [read $fd]
+		close $fd
+	    }
+	    catch {file delete $file}
+	}
+
+	if {![catch {set fd [open tags.$i]}]} {
+	    set tags [read $fd]
+	    close $fd
+	    puts -nonewline $tag_fd $tags
+	    if {$add_tags != ""} {
+		add_tags -io $io -tags $tags
+	    }
+	}
+	catch {file delete tags.$i}
+
+	if {$dump_problems} {
+	    if {![catch {set fd [open $prob_file.$i]}]} {
+		puts -nonewline $prob_fd [read $fd]
+		close $fd
+	    }
+	    catch {file delete $prob_file.$i}
+	}
+    }
+    close $exp_fd
+    close $tag_fd
+    if {$dump_problems} {
+	close $prob_fd
+    }
+}
+
+proc worker_output {fd n} {
+    global workers
+
+    puts -nonewline $workers(log,$n) [read $fd]
+    if {![eof $fd]} {
+	return
+    }
+
+    fconfigure $fd -blocking 1
+    if {[catch {close $fd} err]} {
+	puts $workers(log,$n) "*** Prefinish process $n failed: $err"
+    }
+    close $workers(log,$n)
+    incr workers(running) -1
+}
+
 # -----------------------------------------------------------------------------
 # Main entry point
 
@@ -274,9 +400,28 @@ set tag_types {AMBG OLIG PRIM MASK CVEC}
 set pwalk_ntemplates 2
 set method 0x04; # primer-walking
 set min_contig_len 2000
+set jobs 1
+set worker -1
 
 puts "*** Prefinish args: $argv"
 
+# Arguments passed on to worker processes when using --jobs
+set worker_args {}
+set skip_args 0
+foreach arg [lrange $argv 0 end-1] {
+    if {$skip_args} {
+	set skip_args 0
+	continue
+    }
+    regsub {^--} $arg - opt
+    if {[lsearch -exact {-jobs -contig -contigs -min_contig_len
+			 -dump_problems} $opt] != -1} {
+	set skip_args 1
+	continue
+    }
+    lappend worker_args $arg
+}
+
 while {$argc > 0 && "[string index [lindex $argv 0] 0]" == "-"} {
     set arg [lindex $argv 0];
     set argv [lrange $argv 1 $argc]
@@ -331,7 +476,7 @@ while {$argc > 0 && "[string index [lindex $argv 0] 0]" == "-"} {
 
     } elseif {$arg == "-dump_problems"} {
 	set dump_problems 1
-	set prob_fd [open [lindex $argv 0] w]
+	set prob_file [lindex $argv 0]
 	set argv [lrange $argv 1 $argc]
 	incr argc -1
 
@@ -364,6 +509,16 @@ while {$argc > 0 && "[string index [lindex $argv 0] 0]" == "-"} {
 	set argv [lrange $argv 1 $argc]
 	incr argc -1;
 
+    } elseif {$arg == "-jobs"} {
+	set jobs [lindex $argv 0]
+	set argv [lrange $argv 1 $argc]
+	incr argc -1;
+
+    } elseif {$arg == "-worker"} {
+	set worker [lindex $argv 0]
+	set argv [lrange $argv 1 $argc]
+	incr argc -1;
+
     } else {
 	puts "Unknown option '$arg'"
 	usage
@@ -390,7 +545,7 @@ if {![catch {set fd [open vector]}]} {
 
 # Open database, choose contig, select consensus mode
 foreach {dbname dbvers} [split [lindex $argv 0] .] {}
-if {$add_tags != ""} {
+if {$add_tags != "" && $worker < 0} {
     set io [open_db -name $dbname -version $dbvers -access rw]
 } else {
     set io [open_db -name $dbname -version $dbvers -access r]
@@ -449,6 +604,54 @@ set num_contigs [keylget db num_contigs]
 set tcl [db_info t_contig_length $io]
 set maxseq [expr {round(($tcl + 20*$num_contigs)*1.1)}]
 
+# Produce a list of contigs to process. "contigs" is a list of contig numbers
+# The -min_contig_len option only applies when -contig(s) is not explicitly
+# used.
+set contigs ""
+if {$contig != ""} {
+    foreach c $contig {
+	set cnum [db_info get_contig_num $io $c]
+	if {$cnum == -1} {
+	    puts "Unknown contig $c"
+	    exit
+	}
+	lappend contigs $cnum
+    }
+} else {
+    for {set cnum 1} {$cnum <= $num_contigs} {incr cnum} {
+	set c [io_read_contig 1 $cnum]
+	if {[keylget c length] < $min_contig_len} {
+	    continue
+	}
+	lappend contigs $cnum
+    }
+}
+foreach cnum $contigs {
+    set c [io_read_contig 1 $cnum]
+    set clen($cnum) [keylget c length]
+}
+
+if {$jobs > 1 && $worker < 0 && [llength $contigs] > 1} {
+    run_workers $jobs $contigs [lindex $argv 0] $worker_args
+    close_db -io $io
+    exit
+}
+
+# Workers keep their output apart until it is merged
+if {$worker >= 0} {
+    set output_file $dbname.$dbvers.experiments.$worker
+    set tags_file tags.$worker
+    set first_id [expr {($worker+1)*1000000}]
+} else {
+    set output_file $dbname.$dbvers.experiments
+    set tags_file tags
+    set first_id 0
+}
+
+if {$dump_problems} {
+    set prob_fd [open $prob_file w]
+}
+
 # Allocate a 'finish' Tcl_Obj object. (Note that this can grow quite big.)
 # This contains consensus, confidence values, virtual sequences, etc.
 # It's the main data block passed between the various finishing functions.
@@ -508,7 +711,8 @@ finish .f \
     -primer_gc_clamp 1 \
     -primer_max_poly_x 4 \
     -primer_max_end_stability 9 \
-    -output_file $dbname.$dbvers.experiments \
+    -output_file $output_file \
+    -first_id $first_id \
     -regexp_templates 1 \
     -debug0 2 \
     -debug1 2 \
@@ -525,29 +729,6 @@ if {$add_tags != ""} {
     .f configure -pwalk_tag_type $add_tags
 }
 
-# Produce a list of contigs to process. "contigs" is a list of contig numbers
-# The -min_contig_len option only applies when -contig(s) is not explicitly
-# used.
-set contigs ""
-if {$contig != ""} {
-    foreach c $contig {
-	set cnum [db_info get_contig_num $io $c]
-	if {$cnum == -1} {
-	    puts "Unknown contig $c"
-	    exit
-	}
-	lappend contigs $cnum
-    }
-} else {
-    for {set cnum 1} {$cnum <= $num_contigs} {incr cnum} {
-	set c [io_read_contig 1 $cnum]
-	if {[keylget c length] < $min_contig_len} {
-	    continue
-	}
-	lappend contigs $cnum
-    }
-}
-
 # Loop through selected contigs
 foreach cnum $contigs {
     set c [io_read_contig 1 $cnum]
@@ -601,10 +782,10 @@ foreach cnum $contigs {
 	append tags [.f implement_solutions -tag_types $tag_types]
     }
 
-    if {$add_tags != ""} {
+    if {$add_tags != "" && $worker < 0} {
 	add_tags -io $io -tags $tags
     }
-    set fd [open tags a]
+    set fd [open $tags_file a]
     puts $fd $tags
     close $fd
     
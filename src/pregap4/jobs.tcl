@@ -0,0 +1,484 @@
+#
+# Copyright (c) Medical Research Council, Laboratory of Molecular Biology,
+# 1998. All rights reserved.
+#
+# This file is part of the Staden Package. See the Staden Package copyright
+# notice for information on the restrictions for usage and distribution, and
+# for a disclaimer of all warranties.
+#
+
+#-----------------------------------------------------------------------------
+# Running external programs in parallel.
+#
+# Modules that run a C program once per file may define a "job" function
+# in place of "run". It is called as "job $file" and returns the command
+# (as a list) to process that file, or "" if the file should be passed on
+# untouched. Once the command has finished "job_done $file $failed
+# $output" is called; it returns 1 to keep the file or 0 to drop it.
+#
+# run_modules hands consecutive enabled modules of this type to
+# run_pipeline, which streams the files through them: a file moves on to
+# the next module as soon as it is done with, and up to [get_max_jobs]
+# commands are running at any one time. The queue in front of each module
+# is bounded so that one slow stage does not let the earlier ones run
+# arbitrarily far ahead.
+#
+# Programs that take a file of file names instead (screen_seq,
+# vector_clip) can be split across several processes with run_fofn_jobs.
+#
+# When libpregap4 has been loaded the clipping modules (qclip, polyA_clip
+# and hetins) may instead be run in-process, see use_clip_reads. Such
+# modules also define "clip_stage", returning their stage description for
+# the clip_reads command, and "clip_done $file $changes" to report on a
+# clipped file. run_modules then hands consecutive modules of this type to
+# run_clip_reads.
+
+namespace eval pipeline {
+    variable job_num 0
+}
+
+# Returns the number of commands to run at once. This is the global
+# max_jobs (set by the -jobs command line option or the configuration
+# file), or PREGAP4_JOBS from the environment, or failing those the number
+# of processors.
+proc get_max_jobs {} {
+    global max_jobs env
+
+    if {[info exists max_jobs] && [string is integer -strict $max_jobs] &&
+	$max_jobs > 0} {
+	return $max_jobs
+    }
+
+    set max_jobs 1
+    if {[info exists env(PREGAP4_JOBS)] &&
+	[string is integer -strict $env(PREGAP4_JOBS)] &&
+	$env(PREGAP4_JOBS) > 0} {
+	set max_jobs $env(PREGAP4_JOBS)
+    } elseif {![catch {set fd [open /proc/cpuinfo r]}]} {
+	set n [regexp -all -line {^processor\s*:} [read $fd]]
+	close $fd
+	if {$n > 0} {
+	    set max_jobs $n
+	}
+    } elseif {[info exists env(NUMBER_OF_PROCESSORS)] &&
+	      [string is integer -strict $env(NUMBER_OF_PROCESSORS)]} {
+	set max_jobs $env(NUMBER_OF_PROCESSORS)
+    }
+
+    return $max_jobs
+}
+
+# Returns whether the clip_stage modules are to be run in-process by
+# run_clip_reads rather than as programs by run_pipeline. In-process runs
+# skip starting a program per file but use a single processor, so by
+# default they are only used when one job at a time is allowed. This is
+# overridden by the global clip_in_process (set by the -clip_in_process
+# command line option or the configuration file), or failing that by
+# PREGAP4_CLIP_IN_PROCESS from the environment.
+proc use_clip_reads {} {
+    global clip_in_process env
+
+    if {[info commands ::clip_reads] == ""} {
+	return 0
+    }
+    if {[info exists clip_in_process] &&
+	[string is boolean -strict $clip_in_process]} {
+	return [string is true $clip_in_process]
+    }
+    if {[info exists env(PREGAP4_CLIP_IN_PROCESS)] &&
+	[string is boolean -strict $env(PREGAP4_CLIP_IN_PROCESS)]} {
+	return [string is true $env(PREGAP4_CLIP_IN_PROCESS)]
+    }
+    return [expr {[get_max_jobs] == 1}]
+}
+
+# Starts 'cmd' in the background. Once it has exited 'done_script' is
+# called with three extra arguments: whether it failed, the errorCode
+# describing how, and its combined stdout and stderr. As with exec, a
+# command fails if it exits with a non zero status (errorCode CHILDSTATUS
+# etc) or writes to stderr (errorCode NONE).
+proc pipeline::start_job {cmd done_script} {
+    global fofn
+    variable job_num
+
+    set err_file $fofn.job[incr job_num].err
+    if {[catch {set fd [open |[concat $cmd [list 2> $err_file]] r]} err]} {
+	catch {file delete $err_file}
+	after idle [concat $done_script [list 1 $::errorCode $err]]
+	return
+    }
+    fconfigure $fd -blocking 0
+    fileevent $fd readable \
+	[list ::pipeline::job_readable $fd $err_file "" $done_script]
+}
+
+proc pipeline::job_readable {fd err_file output done_script} {
+    append output [read $fd]
+    if {![eof $fd]} {
+	fileevent $fd readable \
+	    [list ::pipeline::job_readable $fd $err_file $output $done_script]
+	return
+    }
+
+    fconfigure $fd -blocking 1
+    set code NONE
+    if {[set failed [catch {close $fd} err]]} {
+	set code $::errorCode
+	if {$output == ""} {
+	    set output $err
+	}
+    }
+    if {![catch {set efd [open $err_file r]}]} {
+	set errors [read $efd]
+	close $efd
+	if {$errors != ""} {
+	    set failed 1
+	    append output $errors
+	}
+    }
+    catch {file delete $err_file}
+
+    uplevel #0 [concat $done_script [list $failed $code $output]]
+}
+
+#-----------------------------------------------------------------------------
+# Streams 'files' through the list of job based modules 'mods', returning
+# the files that survive all of them in their original order. Per module
+# throughput and the deepest queue seen are reported once all are done.
+proc run_pipeline {mods files} {
+    upvar #0 ::pipeline::state s
+
+    catch {unset s}
+    set s(mods) $mods
+    set s(nstages) [llength $mods]
+    set s(max) [get_max_jobs]
+    set s(limit) [expr {2*$s(max)}]
+    set s(input) $files
+    set s(next_in) 0
+    set s(running) 0
+    set s(finished) 0
+    set s(output) {}
+    for {set i 0} {$i < $s(nstages)} {incr i} {
+	set mod [lindex $mods $i]
+	set ${mod}::report ""
+	set s(queue,$i) {}
+	set s(depth,$i) 0
+	set s(count,$i) 0
+	set s(busy,$i) 0
+	set s(start,$i) ""
+	set s(end,$i) ""
+    }
+
+    set names {}
+    foreach mod $mods {
+	lappend names [${mod}::name]
+    }
+    vmessage "- [join $names { / }] -"
+    vmessage "Running with up to $s(max) jobs at once"
+
+    set index 0
+    foreach f $files {
+	set s(order,$f) [incr index]
+    }
+
+    pipeline::dispatch
+    if {!$s(finished)} {
+	vwait ::pipeline::state(finished)
+    }
+    vmessage ""
+
+    # Report per module statistics
+    for {set i 0} {$i < $s(nstages)} {incr i} {
+	if {$s(start,$i) == "" || $s(end,$i) == ""} {
+	    set secs 0.0
+	} else {
+	    set secs [expr {($s(end,$i)-$s(start,$i))/1000.0}]
+	}
+	if {$secs > 0} {
+	    set rate [format %.1f [expr {$s(count,$i)/$secs}]]
+	} else {
+	    set rate -
+	}
+	set msg [format "%-25s %6d files %8.1fs %8s files/s  max queue %d" \
+		     [[lindex $mods $i]::name] $s(count,$i) $secs $rate \
+		     $s(depth,$i)]
+	vmessage $msg
+    }
+
+    # Return survivors in their input order
+    set out {}
+    foreach f $s(output) {
+	lappend out [list $s(order,$f) $f]
+    }
+    set files {}
+    foreach f [lsort -integer -index 0 $out] {
+	lappend files [lindex $f 1]
+    }
+    unset s
+
+    return $files
+}
+
+# Starts as many jobs as allowed. Later modules are served first so that
+# files drain out of the pipeline, and a module is not given more work
+# while the queue in front of the next one is full.
+proc pipeline::dispatch {} {
+    upvar #0 ::pipeline::state s
+
+    set progress 1
+    while {$progress && $s(running) < $s(max)} {
+	set progress 0
+	for {set i [expr {$s(nstages)-1}]} {$i >= 0} {incr i -1} {
+	    set next [expr {$i+1}]
+	    while {$s(running) < $s(max) && [llength $s(queue,$i)]} {
+		if {$next < $s(nstages) &&
+		    [llength $s(queue,$next)] >= $s(limit)} {
+		    break
+		}
+		set f [lindex $s(queue,$i) 0]
+		set s(queue,$i) [lrange $s(queue,$i) 1 end]
+		start_stage $i $f
+		set progress 1
+	    }
+	}
+
+	# Feed new files into the first module
+	while {$s(next_in) < [llength $s(input)] &&
+	       [llength $s(queue,0)] < $s(limit)} {
+	    enqueue 0 [lindex $s(input) $s(next_in)]
+	    incr s(next_in)
+	    set progress 1
+	}
+    }
+
+    if {$s(running) == 0 && $s(next_in) >= [llength $s(input)]} {
+	for {set i 0} {$i < $s(nstages)} {incr i} {
+	    if {[llength $s(queue,$i)]} {
+		return
+	    }
+	}
+	set s(finished) 1
+    }
+}
+
+proc pipeline::enqueue {i f} {
+    upvar #0 ::pipeline::state s
+
+    if {$i >= $s(nstages)} {
+	lappend s(output) $f
+	return
+    }
+    lappend s(queue,$i) $f
+    if {[llength $s(queue,$i)] > $s(depth,$i)} {
+	set s(depth,$i) [llength $s(queue,$i)]
+    }
+}
+
+proc pipeline::start_stage {i f} {
+    upvar #0 ::pipeline::state s
+    global file_error
+
+    set mod [lindex $s(mods) $i]
+    if {$s(start,$i) == ""} {
+	set s(start,$i) [clock clicks -milliseconds]
+    }
+
+    if {[catch {${mod}::job $f} cmd]} {
+	set file_error($f) "${mod}: [strip_nl $cmd]"
+	vmessage -nonewline !
+	stage_finished $i $f 0
+	return
+    }
+    if {$cmd == ""} {
+	stage_finished $i $f 1
+	return
+    }
+
+    incr s(running)
+    incr s(busy,$i)
+    start_job $cmd [list ::pipeline::job_finished $i $f]
+}
+
+proc pipeline::job_finished {i f failed code output} {
+    upvar #0 ::pipeline::state s
+
+    incr s(running) -1
+    incr s(busy,$i) -1
+
+    set mod [lindex $s(mods) $i]
+    if {[catch {${mod}::job_done $f $failed $output} keep]} {
+	verror ERR_WARN ${mod}::job_done $keep
+	set keep 0
+    }
+    stage_finished $i $f $keep
+    dispatch
+}
+
+proc pipeline::stage_finished {i f keep} {
+    upvar #0 ::pipeline::state s
+
+    incr s(count,$i)
+    set s(end,$i) [clock clicks -milliseconds]
+    if {$keep} {
+	enqueue [expr {$i+1}] $f
+    }
+}
+
+#-----------------------------------------------------------------------------
+# Runs a program that processes a file of file names as several processes
+# at once, each given a share of 'fofn'. 'cmd' is the command line with
+# %i, %p and %f standing for the input, passed and failed file of file
+# names; the output passed and failed files are then concatenated into
+# 'passed' and 'failed'. Returns a list of the failure status, errorCode
+# and combined output, as "catch {exec ...} var" would have given.
+proc run_fofn_jobs {cmd fofn passed failed} {
+    set fd [open $fofn r]
+    set names {}
+    while {[gets $fd line] != -1} {
+	lappend names $line
+    }
+    close $fd
+
+    # No more pieces than jobs, and none too small to be worth a process
+    set njobs [get_max_jobs]
+    if {$njobs > [llength $names] / 4} {
+	set njobs [expr {[llength $names] / 4}]
+    }
+    if {$njobs < 1} {
+	set njobs 1
+    }
+
+    upvar #0 ::pipeline::fofn_jobs j
+    catch {unset j}
+    set j(running) $njobs
+    set j(failed) 0
+    set j(code) NONE
+    set per_job [expr {([llength $names] + $njobs - 1) / $njobs}]
+    for {set n 0} {$n < $njobs} {incr n} {
+	set fd [open $fofn.$n w]
+	foreach name [lrange $names [expr {$n*$per_job}] \
+			  [expr {($n+1)*$per_job-1}]] {
+	    puts $fd $name
+	}
+	close $fd
+	set j(output,$n) ""
+	pipeline::start_job \
+	    [string map [list %i $fofn.$n %p $passed.$n %f $failed.$n] $cmd] \
+	    [list ::pipeline::fofn_job_finished $n]
+    }
+
+    while {$j(running)} {
+	vwait ::pipeline::fofn_jobs(running)
+    }
+
+    # Merge the results
+    set output ""
+    set pfd [open $passed w]
+    set ffd [open $failed w]
+    for {set n 0} {$n < $njobs} {incr n} {
+	append output $j(output,$n)
+	foreach {in out} [list $passed.$n $pfd $failed.$n $ffd] {
+	    if {![catch {set fd [open $in r]}]} {
+		puts -nonewline $out [read $fd]
+		close $fd
+	    }
+	    catch {file delete $in}
+	}
+	catch {file delete $fofn.$n}
+    }
+    close $pfd
+    close $ffd
+
+    set ret [list $j(failed) $j(code) [string trimright $output "\n"]]
+    unset j
+    return $ret
+}
+
+proc pipeline::fofn_job_finished {n failed code output} {
+    upvar #0 ::pipeline::fofn_jobs j
+
+    if {$failed} {
+	set j(failed) 1
+	if {$code != "NONE"} {
+	    set j(code) $code
+	}
+    }
+    set j(output,$n) $output
+    incr j(running) -1
+}
+
+#-----------------------------------------------------------------------------
+# Runs the clip_stage modules 'mods' in-process on 'files' using the
+# clip_reads command. Each Experiment File is loaded once and passed
+# through all of the stages; other file types are passed on untouched.
+# The throughput of the combined stages is reported as for run_pipeline.
+# Returns the files that survive.
+proc run_clip_reads {mods files} {
+    global file_type file_error
+
+    set stages {}
+    set names {}
+    foreach mod $mods {
+	set ${mod}::report ""
+	lappend stages [${mod}::clip_stage]
+	lappend names [${mod}::name]
+    }
+    vmessage "- [join $names { / }] -"
+    vmessage "Running in-process"
+
+    set new_files {}
+    set exp_files {}
+    foreach f $files {
+	if {$file_type($f) == "EXP"} {
+	    lappend exp_files $f
+	} else {
+	    lappend new_files $f
+	}
+    }
+
+    # Small batches keep the interface responsive
+    set start [clock clicks -milliseconds]
+    for {set i 0} {$i < [llength $exp_files]} {incr i 50} {
+	set batch [lrange $exp_files $i [expr {$i+49}]]
+	foreach res [clip_reads $batch $stages] {
+	    foreach {f err changes} $res break
+	    if {$err != ""} {
+		set file_error($f) $err
+		vmessage -nonewline !
+		continue
+	    }
+	    foreach mod $mods {
+		${mod}::clip_done $f $changes
+	    }
+	    lappend new_files $f
+	    vmessage -nonewline .
+	}
+	update idletasks
+    }
+    vmessage ""
+
+    set secs [expr {([clock clicks -milliseconds]-$start)/1000.0}]
+    if {$secs > 0} {
+	set rate [format %.1f [expr {[llength $exp_files]/$secs}]]
+    } else {
+	set rate -
+    }
+    vmessage [format "%-25s %6d files %8.1fs %8s files/s  in-process" \
+		  [join $names { / }] [llength $exp_files] $secs $rate]
+
+    # Keep the original file order
+    set order {}
+    set index 0
+    foreach f $files {
+	set pos($f) [incr index]
+    }
+    foreach f $new_files {
+	lappend order [list $pos($f) $f]
+    }
+    set new_files {}
+    foreach f [lsort -integer -index 0 $order] {
+	lappend new_files [lindex $f 1]
+    }
+
+    return $new_files
+}
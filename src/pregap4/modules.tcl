@@ -154,16 +154,46 @@ proc check_modules {input_files} {
 }
 
 # call run function
+#
+# Consecutive modules providing a job function (see jobs.tcl) are run
+# together as a pipeline with several files processed at once, or in-process
+# by run_clip_reads when they also provide clip_stage and use_clip_reads
+# allows it.
 proc run_modules {files} {
     global modules interactive
     vfuncheader "Running modules"
     if {!$interactive} {
 	puts "\n=== Running Modules ==="
     }
-    foreach mod $modules {
-	if {[set ${mod}::enabled] == 0} {
+    set group {}
+    set kind {}
+    foreach mod [concat $modules {{}}] {
+	if {$mod != "" && [set ${mod}::enabled] == 0} {
 	    continue
 	}
+	set this {}
+	if {$mod != ""} {
+	    if {[info commands ${mod}::clip_stage] != "" && [use_clip_reads]} {
+		set this run_clip_reads
+	    } elseif {[info commands ${mod}::job] != ""} {
+		set this run_pipeline
+	    }
+	}
+	if {$group != "" && $this != $kind} {
+	    update idletasks
+	    if {[catch {set files [$kind $group $files]} var]} {
+		verror ERR_WARN $kind $var
+	    }
+	    set group {}
+	}
+	if {$this != ""} {
+	    lappend group $mod
+	    set kind $this
+	    continue
+	}
+	if {$mod == ""} {
+	    break
+	}
 	if {[info commands ${mod}::run] != ""} {
 	    vmessage "- [${mod}::name] -"
 	    update idletasks
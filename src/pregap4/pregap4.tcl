@@ -61,6 +61,12 @@ while {[string match {-*} [lindex $argv 0]]} {
 	    set fofn_dir [file join [pwd] $fofn_dir]
 	}
 	set argv [lrange $argv 2 end]
+    } elseif {[lindex $argv 0] == "-jobs"} {
+	set max_jobs [lindex $argv 1]
+	set argv [lrange $argv 2 end]
+    } elseif {[lindex $argv 0] == "-clip_in_process"} {
+	set clip_in_process [lindex $argv 1]
+	set argv [lrange $argv 2 end]
     } elseif {[lindex $argv 0] == "-win_compact"} {
     	keylset pregap4_defs WINDOW_STYLE compact
 	set argv [lrange $argv 1 end]
@@ -0,0 +1,370 @@
+/*
+ * Tcl interface to the qclip, polyA_clip and hetins clipping code.
+ *
+ * The "clip_reads" command loads each Experiment File just once and passes
+ * it through a list of clipping stages in memory. New records are appended
+ * to the file as each stage completes, exactly as the stand alone programs
+ * would have written them, but without starting a process per stage per
+ * reading.
+ */
+
+#include <staden_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <tcl.h>
+
+#include <io_lib/Read.h>
+#include <io_lib/expFileIO.h>
+#include <io_lib/traceType.h>
+#include <io_lib/mFILE.h>
+
+#include "seqInfo.h"
+#include "qclip.h"
+#include "polyA_clip.h"
+#include "hetins.h"
+
+#define STAGE_QCLIP  0
+#define STAGE_POLYA  1
+#define STAGE_HETINS 2
+
+static char *stage_names[] = {"qclip", "polyA", "hetins", NULL};
+
+typedef struct {
+    int type;			/* STAGE_* */
+    qclip_params qclip;
+    polyA_params polyA;
+    double percent_match;	/* polyA: converted to polyA.score */
+    HETINS_PARAMS hetins;
+} clip_stage;
+
+/*
+ * Stage options. The names follow the variables used by the corresponding
+ * pregap4 modules.
+ */
+#define OPT_INT    1
+#define OPT_DOUBLE 2
+
+typedef struct {
+    char *name;
+    int stage;
+    int type;
+    int offset;
+} clip_opt;
+
+static clip_opt clip_opts[] = {
+    {"-use_conf",	    STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.use_conf)},
+    {"-min_extent",	    STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.min)},
+    {"-max_extent",	    STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.max)},
+    {"-min_length",	    STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.min_len)},
+    {"-conf_val",	    STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.qual_val)},
+    {"-window_length",	    STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.window_len)},
+    {"-offset",		    STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.start)},
+    {"-right_win_length",   STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.rwin1)},
+    {"-right_num_uncalled", STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.rcnt1)},
+    {"-left_win_length",    STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.lwin1)},
+    {"-left_num_uncalled",  STAGE_QCLIP, OPT_INT,
+     offsetof(clip_stage, qclip.lcnt1)},
+
+    {"-percent_match",	    STAGE_POLYA, OPT_DOUBLE,
+     offsetof(clip_stage, percent_match)},
+    {"-window_length",	    STAGE_POLYA, OPT_INT,
+     offsetof(clip_stage, polyA.window_len)},
+    {"-min_length",	    STAGE_POLYA, OPT_INT,
+     offsetof(clip_stage, polyA.min_len)},
+
+    {"-window_length",	    STAGE_HETINS, OPT_INT,
+     offsetof(clip_stage, hetins.window)},
+    {"-worst_envelope",	    STAGE_HETINS, OPT_DOUBLE,
+     offsetof(clip_stage, hetins.worst_envelope)},
+    {"-worst_half_signal",  STAGE_HETINS, OPT_DOUBLE,
+     offsetof(clip_stage, hetins.worst_half_signal)},
+    {"-signal_gradient",    STAGE_HETINS, OPT_DOUBLE,
+     offsetof(clip_stage, hetins.good_signal_grad_indel)},
+
+    {NULL, 0, 0, 0}
+};
+
+/*
+ * Parses a stage description, a list of the stage name followed by
+ * option/value pairs, into 's'.
+ */
+static int parse_stage(Tcl_Interp *interp, Tcl_Obj *desc, clip_stage *s) {
+    Tcl_Obj **objv;
+    int objc, i;
+
+    if (TCL_OK != Tcl_ListObjGetElements(interp, desc, &objc, &objv))
+	return TCL_ERROR;
+
+    if (objc < 1 || !(objc & 1)) {
+	Tcl_SetResult(interp, "stage should be \"name ?-option value ...?\"",
+		      TCL_STATIC);
+	return TCL_ERROR;
+    }
+
+    if (TCL_OK != Tcl_GetIndexFromObj(interp, objv[0], stage_names,
+				      "stage", 0, &s->type))
+	return TCL_ERROR;
+
+    qclip_default_params(&s->qclip);
+    polyA_default_params(&s->polyA);
+    s->percent_match = 95;
+    hetins_default_params(&s->hetins);
+
+    for (i = 1; i < objc; i += 2) {
+	char *name = Tcl_GetString(objv[i]);
+	clip_opt *o;
+
+	for (o = clip_opts; o->name; o++) {
+	    if (o->stage == s->type && 0 == strcmp(o->name, name))
+		break;
+	}
+	if (!o->name) {
+	    Tcl_AppendResult(interp, "unknown ", stage_names[s->type],
+			     " option \"", name, "\"", NULL);
+	    return TCL_ERROR;
+	}
+
+	if (o->type == OPT_INT) {
+	    if (TCL_OK != Tcl_GetIntFromObj(interp, objv[i+1],
+					    (int *)((char *)s + o->offset)))
+		return TCL_ERROR;
+	} else {
+	    if (TCL_OK != Tcl_GetDoubleFromObj(interp, objv[i+1],
+					       (double *)((char *)s+o->offset)))
+		return TCL_ERROR;
+	}
+    }
+
+    /* As in polyA_clip's main() */
+    s->polyA.score = s->polyA.window_len * s->percent_match / 100.0;
+
+    return TCL_OK;
+}
+
+/*
+ * Runs the hetins stage. The trace is found via the LN record.
+ *
+ * Returns 0 for success, or -1 with an error message in 'err'.
+ */
+static int clip_hetins(SeqInfo *si, HETINS_PARAMS params,
+		       Tcl_Obj *changes, char *err) {
+    Read *r;
+    char tag[HETINS_TAG_LEN];
+    int pos, qr;
+
+    if (exp_Nentries(si->e, EFLT_LN) < 1) {
+	sprintf(err, "hetins: Unable to read LN record from experiment file");
+	return -1;
+    }
+    if (NULL == (r = read_reading(exp_get_entry(si->e, EFLT_LN), TT_ANY))) {
+	sprintf(err, "hetins: Unable to read trace for experiment file");
+	return -1;
+    }
+
+    if ((pos = heterozygous_indels(r, params)) < 0) {
+	sprintf(err, "hetins: Failed to analyse trace");
+	read_deallocate(r);
+	return -1;
+    }
+
+    if (pos) {
+	qr = exp_Nentries(si->e, EFLT_QR)
+	    ? atoi(exp_get_entry(si->e, EFLT_QR)) : 0;
+
+	hetins_format_tag(tag, pos, r, params);
+	if (exp_put_str(si->e, EFLT_TG, tag, strlen(tag))) {
+	    sprintf(err, "hetins: Unable to write to experiment file");
+	    read_deallocate(r);
+	    return -1;
+	}
+
+	/* Only shift QR to the right, never to the left */
+	if (pos > qr) {
+	    qr = pos+1;
+	    if (exp_put_int(si->e, EFLT_QR, &qr)) {
+		sprintf(err, "hetins: Unable to write to experiment file");
+		read_deallocate(r);
+		return -1;
+	    }
+	    Tcl_ListObjAppendElement(NULL, changes, Tcl_NewStringObj("QR",-1));
+	    Tcl_ListObjAppendElement(NULL, changes, Tcl_NewIntObj(qr));
+	}
+    }
+    Tcl_ListObjAppendElement(NULL, changes, Tcl_NewStringObj("HETI", -1));
+    Tcl_ListObjAppendElement(NULL, changes, Tcl_NewIntObj(pos));
+
+    read_deallocate(r);
+    return 0;
+}
+
+/* Appends "rec val" to changes and to the experiment file */
+static int put_int(SeqInfo *si, int eflt, char *rec, int val,
+		   Tcl_Obj *changes) {
+    if (exp_put_int(si->e, eflt, &val))
+	return -1;
+
+    Tcl_ListObjAppendElement(NULL, changes, Tcl_NewStringObj(rec, -1));
+    Tcl_ListObjAppendElement(NULL, changes, Tcl_NewIntObj(val));
+    return 0;
+}
+
+/*
+ * Passes a single file through all the stages, returning a list of the
+ * file name, an error message (blank for success) and a list of record
+ * names and values that were added.
+ */
+static Tcl_Obj *clip_file(char *file, clip_stage *stages, int nstages) {
+    SeqInfo *si;
+    Tcl_Obj *res, *changes;
+    char err[1024];
+    int i, ret;
+
+    res = Tcl_NewListObj(0, NULL);
+    changes = Tcl_NewListObj(0, NULL);
+    Tcl_ListObjAppendElement(NULL, res, Tcl_NewStringObj(file, -1));
+    *err = 0;
+
+    if (NULL == (si = read_sequence_details(file, 0))) {
+	sprintf(err, "Failed to read file");
+	goto done;
+    }
+    if (NULL == (si->e->fp = mfopen(file, "a"))) {
+	sprintf(err, "Failed to write file");
+	goto done;
+    }
+
+    for (i = 0; i < nstages && !*err; i++) {
+	clip_stage *s = &stages[i];
+	int left, right, len;
+
+	switch (s->type) {
+	case STAGE_QCLIP:
+	    if (qclip_seq(si, &s->qclip, &left, &right) != 0) {
+		sprintf(err, "qclip: Sequence too short (length=%d)",
+			right - left);
+		break;
+	    }
+	    if (put_int(si, EFLT_QL, "QL", left, changes) ||
+		put_int(si, EFLT_QR, "QR", right, changes))
+		sprintf(err, "qclip: Failed to write file");
+	    break;
+
+	case STAGE_POLYA:
+	    ret = polyA_clip_seq(si, &s->polyA, &left, &right, &len);
+	    if (ret == -1) {
+		sprintf(err, "polyA_clip: Sequence too short (length=%d)", len);
+		break;
+	    }
+	    if (right > 0 && put_int(si, EFLT_SR, "SR", right, changes)) {
+		sprintf(err, "polyA_clip: Failed to write file");
+		break;
+	    }
+	    if (ret == -2) {
+		sprintf(err, "polyA_clip: Sequence too short (length=%d)", len);
+		break;
+	    }
+	    if (left > 0 && put_int(si, EFLT_SL, "SL", left, changes))
+		sprintf(err, "polyA_clip: Failed to write file");
+	    break;
+
+	case STAGE_HETINS:
+	    clip_hetins(si, s->hetins, changes, err);
+	    break;
+	}
+    }
+
+ done:
+    if (si) {
+	exp_close(si->e);
+	freeSeqInfo(si);
+    }
+
+    Tcl_ListObjAppendElement(NULL, res, Tcl_NewStringObj(err, -1));
+    Tcl_ListObjAppendElement(NULL, res, changes);
+    return res;
+}
+
+/*
+ * Usage: clip_reads files stages
+ *
+ * 'stages' is a list of stages to run on each file in turn, each being a
+ * list of "qclip", "polyA" or "hetins" followed by option/value pairs.
+ * Returns a list with one {file error changes} element per file.
+ */
+static int tcl_clip_reads(ClientData clientData,
+			  Tcl_Interp *interp,
+			  int objc,
+			  Tcl_Obj *CONST objv[]) {
+    Tcl_Obj **files, **descs, *res;
+    int nfiles, nstages, i;
+    clip_stage *stages;
+
+    if (objc != 3) {
+	Tcl_WrongNumArgs(interp, 1, objv, "files stages");
+	return TCL_ERROR;
+    }
+
+    if (TCL_OK != Tcl_ListObjGetElements(interp, objv[1], &nfiles, &files) ||
+	TCL_OK != Tcl_ListObjGetElements(interp, objv[2], &nstages, &descs))
+	return TCL_ERROR;
+
+    if (NULL == (stages = (clip_stage *)ckalloc((nstages ? nstages : 1) *
+						 sizeof(*stages))))
+	return TCL_ERROR;
+
+    for (i = 0; i < nstages; i++) {
+	if (TCL_OK != parse_stage(interp, descs[i], &stages[i])) {
+	    ckfree((char *)stages);
+	    return TCL_ERROR;
+	}
+    }
+
+    res = Tcl_NewListObj(0, NULL);
+    for (i = 0; i < nfiles; i++) {
+	Tcl_ListObjAppendElement(NULL, res,
+				 clip_file(Tcl_GetString(files[i]),
+					   stages, nstages));
+    }
+
+    ckfree((char *)stages);
+    Tcl_SetObjResult(interp, res);
+    return TCL_OK;
+}
+
+int Pregap4_Init(Tcl_Interp *interp) {
+    if (NULL == Tcl_CreateObjCommand(interp, "clip_reads", tcl_clip_reads,
+				     (ClientData)NULL,
+				     (Tcl_CmdDeleteProc *) NULL))
+	return TCL_ERROR;
+
+    return TCL_OK;
+}
+
+int Pregap4_SafeInit(Tcl_Interp *interp) {
+    return Pregap4_Init(interp);
+}
+
+int Pregap4_Unload(Tcl_Interp *interp, int flags) {
+    Tcl_SetResult(interp, "Pkg_Unload() function not implemented",
+		  TCL_STATIC);
+    return TCL_ERROR;
+}
+
+int Pregap4_SafeUnload(Tcl_Interp *interp, int flags) {
+    Tcl_SetResult(interp, "Pkg_SafeUnload() function not implemented",
+		  TCL_STATIC);
+    return TCL_ERROR;
+}
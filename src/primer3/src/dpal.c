@@ -47,13 +47,6 @@ static int _dpal_generic(const unsigned char *,
 			 const dpal_args *,
 			 dpal_results *);
 
-static void _dpal_long_nopath_maxgap1_local_end(const unsigned char *,
-						const unsigned char *,
-						const int,
-						const int,
-						const dpal_args *,
-						dpal_results *);
-
 static void _dpal_long_nopath_generic(const unsigned char *,
 			  const unsigned char *,
                           const int,
@@ -61,12 +54,12 @@ static void _dpal_long_nopath_generic(const unsigned char *,
                           const dpal_args *,
 			  dpal_results *);
 
-static void _dpal_long_nopath_maxgap1_local(const unsigned char *,
-					    const unsigned char *,
-					    const int,
-					    const int,
-					    const dpal_args *,
-					    dpal_results *);
+static int _dpal_long_nopath_maxgap1_local(const unsigned char *,
+					   const unsigned char *,
+					   const int,
+					   const int,
+					   const dpal_args *,
+					   dpal_results *);
 
 static void _dpal_long_nopath_maxgap1_global_end(const unsigned char *,
 						 const unsigned char *,
@@ -274,12 +267,11 @@ dpal(X, Y, in, out)
     } else if (1 == in->force_long_generic) {
 	_dpal_long_nopath_generic(X, Y, xlen, ylen, in, out);
     } else if (1 == in->max_gap ) {
-	if (DPAL_LOCAL == in->flag)
-	    _dpal_long_nopath_maxgap1_local(X, Y, xlen, ylen, in, out);
-        else if (DPAL_GLOBAL_END == in->flag)
+	if (DPAL_LOCAL == in->flag || DPAL_LOCAL_END == in->flag) {
+	    if (_dpal_long_nopath_maxgap1_local(X, Y, xlen, ylen, in, out))
+		return 1;
+	} else if (DPAL_GLOBAL_END == in->flag)
 	    _dpal_long_nopath_maxgap1_global_end(X, Y, xlen, ylen, in, out);
-	else if (DPAL_LOCAL_END == in->flag)
-	    _dpal_long_nopath_maxgap1_local_end(X, Y, xlen, ylen, in, out);
         else if (xlen <= DPAL_MAX_ALIGN && ylen <= DPAL_MAX_ALIGN) {
 	    if (_dpal_generic(X, Y, xlen, ylen, in, out))
 		goto FAIL;
@@ -712,88 +704,256 @@ _dpal_long_nopath_generic(X, Y, xlen, ylen, in, out)
     free(P);
 } /* _dpal_long_nopath_generic */
 
+/*
+ * Linear space, no path, max_gap 1 alignment for DPAL_LOCAL and
+ * DPAL_LOCAL_END. For DPAL_LOCAL_END only the last row of the matrix (the
+ * end of X) is considered for the maximum.
+ *
+ * 'work' must hold dpal_local_work(X, ylen) ints. It receives three rows of
+ * the score matrix followed by a "profile" row of in->ssm[c][Y[j]] scores
+ * for each distinct character c in X. With the profile the inner loop reads
+ * only contiguous memory and has no data dependent branches, so compilers
+ * are able to vectorise it.
+ */
 static void
-_dpal_long_nopath_maxgap1_local(X, Y, xlen, ylen, in, out)
+_dpal_long_nopath_maxgap1_local_work(X, Y, xlen, ylen, in, out, work)
     const unsigned char *X,*Y;
     const int xlen, ylen;
     const dpal_args *in;
     dpal_results *out;
+    int *work;
 {
-    /* The "score matrix" (matrix of best scores). */
-    int *S0, *S1, *S2; 
-    int *P0, *P1, *P2;
-    int *S;
-
-    register int i, j;
-    register int gap = in->gap;
-    register int smax;           /* The optimum score. */
-    register int score;          /* Current score. */
-    register int a;
+    int *S0, *S1, *S2, *S;
+    int *prof[UCHAR_MAX+1];
+    const int *pr, *sc;
+    int *row;
+    int i, j, score, rmax, a;
+    int gap = in->gap;
+    int local = (DPAL_LOCAL == in->flag);
+    int smax = 0; /* For local alignment score can never be less than 0. */
 
 #ifdef DPAL_PRINT_COVERAGE
-    fprintf(stderr, "_dpal_long_nopath_maxgap1_local called\n");
+    fprintf(stderr, "_dpal_long_nopath_maxgap1_local_work called\n");
 #endif
 
-    P0 = malloc(sizeof(int)*ylen);
-    P1 = malloc(sizeof(int)*ylen);
-    P2 = malloc(sizeof(int)*ylen);
+    S0 = work; S1 = S0 + ylen; S2 = S1 + ylen;
 
-    S0 = P0; S1 = P1; S2 = P2;
-
-    smax = 0; /* For local alignment score can never be less than 0. */
+    /* Build the profile rows */
+    for (i = 0; i < xlen; i++)
+	prof[X[i]] = NULL;
+    row = S2 + ylen;
+    for (i = 0; i < xlen; i++) {
+	if (prof[X[i]])
+	    continue;
+	prof[X[i]] = row;
+	sc = in->ssm[X[i]];
+	for (j = 0; j < ylen; j++)
+	    row[j] = sc[Y[j]];
+	row += ylen;
+    }
 
     /* Initialize the 0th row of the score matrix. */
-    for(j=0; j < ylen; j++) { 
-	score = in->ssm[X[0]][Y[j]]; 
+    pr = prof[X[0]];
+    rmax = 0;
+    for (j = 0; j < ylen; j++) {
+	score = pr[j];
 	if (score < 0) score = 0;
-	else if (score > smax) smax = score;
-	/*S[0][j] = score;*/
-	S0[j] = score;
-    }	
-
-    /* Set the 1st row of the score matrix. */
-    score = in->ssm[X[1]][Y[0]];
-    if(score < 0) score = 0;
-    else if (score > smax) smax = score;
-    S1[0] = score;
-    for(j=1; j < ylen; j++) {
-	score = S0[j-1];
-	if(j>1 && (a=S0[j-2] + gap) > score)score = a;
-	score += in->ssm[X[1]][Y[j]];
-	if (score < 0) score = 0;
-	else if(score > smax) smax = score;
+	if (score > rmax) rmax = score;
 	S1[j] = score;
     }
+    if (local || xlen == 1)
+	smax = rmax;
+
+    for (i = 1; i < xlen; i++) {
+	pr = prof[X[i]];
 
-    for(i=2; i < xlen; i++) {
-	score = in->ssm[X[i]][Y[0]];
+	/* The 0th and 1st columns */
+	score = pr[0];
 	if (score < 0) score = 0;
-	else if (score > smax) smax = score;
+	rmax = score;
 	S2[0] = score;
-	score = S1[0];
-	if((a=S0[0] + gap) > score) score = a;
-	score += in->ssm[X[i]][Y[1]];
-	if(score < 0) score = 0;
-	else if (score > smax) smax = score;
-	S2[1] = score;
-	for(j=2; j < ylen; j++) {
-	    score = S0[j-1];
-	    if((a=S1[j-2])>score) score = a;
-	    score +=gap;
-	    if((a=S1[j-1]) >score) score = a;
-
-	    score += in->ssm[X[i]][Y[j]];	
-	    if (score < 0 ) score = 0;
-	    else if (score > smax) smax = score;
-	    S2[j]=score;
+	if (ylen > 1) {
+	    score = S1[0];
+	    if (i > 1 && (a = S0[0] + gap) > score) score = a;
+	    score += pr[1];
+	    if (score < 0) score = 0;
+	    if (score > rmax) rmax = score;
+	    S2[1] = score;
+	}
+
+	if (1 == i) {
+	    for (j = 2; j < ylen; j++) {
+		score = S1[j-2] + gap;
+		if ((a = S1[j-1]) > score) score = a;
+		score += pr[j];
+		if (score < 0) score = 0;
+		if (score > rmax) rmax = score;
+		S2[j] = score;
+	    }
+	} else {
+	    for (j = 2; j < ylen; j++) {
+		score = S0[j-1];
+		if ((a = S1[j-2]) > score) score = a;
+		score += gap;
+		if ((a = S1[j-1]) > score) score = a;
+		score += pr[j];
+		if (score < 0) score = 0;
+		if (score > rmax) rmax = score;
+		S2[j] = score;
+	    }
 	}
+
+	if ((local || i == xlen-1) && rmax > smax)
+	    smax = rmax;
+
 	S = S0; S0 = S1; S1 = S2; S2 = S;
     }
+
     out->score = smax;
     out->path_length=0;
-    free(P0); free(P1); free(P2);
+} /* _dpal_long_nopath_maxgap1_local_work */
+
+/*
+ * The number of ints of working storage needed by
+ * _dpal_long_nopath_maxgap1_local_work.
+ */
+static size_t
+dpal_local_work(X, ylen)
+    const unsigned char *X;
+    const int ylen;
+{
+    char seen[UCHAR_MAX+1];
+    int ndistinct = 0;
+
+    memset(seen, 0, UCHAR_MAX+1);
+    for (; *X; X++) {
+	if (!seen[*X]) {
+	    seen[*X] = 1;
+	    ndistinct++;
+	}
+    }
+
+    return (size_t)(3 + ndistinct) * ylen;
+}
+
+#define DPAL_LOCAL_WORK 4096 /* ints of stack used before resorting to malloc */
+
+static int
+_dpal_long_nopath_maxgap1_local(X, Y, xlen, ylen, in, out)
+    const unsigned char *X,*Y;
+    const int xlen, ylen;
+    const dpal_args *in;
+    dpal_results *out;
+{
+    int stack_work[DPAL_LOCAL_WORK], *work = stack_work;
+    size_t sz = dpal_local_work(X, ylen);
+
+    if (sz > DPAL_LOCAL_WORK)
+	CHECK_ERROR(NULL == (work = malloc(sz * sizeof(int))), "Out of memory");
+
+    _dpal_long_nopath_maxgap1_local_work(X, Y, xlen, ylen, in, out, work);
+
+    if (work != stack_work)
+	free(work);
+    return 0;
+
+ FAIL:
+    if (in->fail_stop) {
+	fprintf(stderr, "\n%s\n", out->msg);
+	exit(-1);
+    }
+    return 1;
 } /* _dpal_long_nopath_maxgap1_local */
 
+int
+dpal_batch(X, Y, n, in, max_score, out, score)
+    const unsigned char *X;
+    const unsigned char *const *Y;
+    const int n;
+    const dpal_args *in;
+    const int max_score;
+    dpal_results *out;
+    int *score;
+{
+    int i, xlen, ylen;
+    int stack_work[DPAL_LOCAL_WORK], *work = stack_work;
+    size_t sz, work_sz = DPAL_LOCAL_WORK;
+    char msg[] = "Illegal character in input: ?";
+
+    /* Only the maxgap 1 local alignments share their working storage */
+    if (1 != in->max_gap
+	|| (DPAL_LOCAL != in->flag && DPAL_LOCAL_END != in->flag)
+	|| 1 == in->force_generic || 1 == in->force_long_generic
+	|| in->debug || !in->score_only) {
+	for (i = 0; i < n; i++) {
+	    if (dpal(X, Y[i], in, out))
+		return -1;
+	    score[i] = out->score;
+	    if (score[i] > max_score)
+		return i+1;
+	}
+	return n;
+    }
+
+    out->score = INT_MIN;
+    out->path_length = 0;
+    out->msg = NULL;
+    out->align_end_1 = -1;
+    out->align_end_2 = -1;
+
+    CHECK_ERROR(NULL == X, "NULL first sequence");
+    if (in->check_chars)
+	CHECK_ERROR(illegal_char(X, in->ssm, &msg[28]), msg);
+    if ('\0' == *X) {
+	out->msg = "Empty first sequence";
+	out->score = 0;
+	return -1;
+    }
+    xlen = ustrlen(X);
+
+    for (i = 0; i < n; i++) {
+	CHECK_ERROR(NULL == Y[i], "NULL second sequence");
+	if (in->check_chars)
+	    CHECK_ERROR(illegal_char(Y[i], in->ssm, &msg[28]), msg);
+	if ('\0' == *Y[i]) {
+	    out->msg = "Empty second sequence";
+	    out->score = 0;
+	    goto FAIL_NOSTOP;
+	}
+
+	ylen = ustrlen(Y[i]);
+	if ((sz = dpal_local_work(X, ylen)) > work_sz) {
+	    if (work != stack_work)
+		free(work);
+	    CHECK_ERROR(NULL == (work = malloc(sz * sizeof(int))),
+			"Out of memory");
+	    work_sz = sz;
+	}
+
+	_dpal_long_nopath_maxgap1_local_work(X, Y[i], xlen, ylen, in, out,
+					     work);
+	score[i] = out->score;
+	if (score[i] > max_score) {
+	    i++;
+	    break;
+	}
+    }
+
+    if (work != stack_work)
+	free(work);
+    return i;
+
+ FAIL:
+    if (in->fail_stop) {
+	fprintf(stderr, "\n%s\n", out->msg);
+	exit(-1);
+    }
+ FAIL_NOSTOP:
+    if (work && work != stack_work)
+	free(work);
+    return -1;
+}
+
 static void
 _dpal_long_nopath_maxgap1_global_end(X, Y, xlen, ylen, in, out)
     const unsigned char *X,*Y;
@@ -999,100 +1159,3 @@ illegal_char(X, ssm, out)
 	return 1;
     }
 }
-static void
-_dpal_long_nopath_maxgap1_local_end(X, Y, xlen, ylen, in, out)
-    const unsigned char *X,*Y;
-    const int xlen, ylen;
-    const dpal_args *in;
-    dpal_results *out;
-{
-    /* The "score matrix" (matrix of best scores). */
-    int *S0, *S1, *S2; 
-    int *P0, *P1, *P2;
-    int *S;
-
-    register int i, j;
-    register int gap = in->gap;
-    register int smax;           /* The optimum score. */
-    register int score;          /* Current score. */
-    register int a;
-
-#ifdef DPAL_PRINT_COVERAGE
-    fprintf(stderr, "_dpal_long_nopath_maxgap1_local_end called\n");
-#endif
-
-    P0 = malloc(sizeof(int)*ylen);
-    P1 = malloc(sizeof(int)*ylen);
-    P2 = malloc(sizeof(int)*ylen);
-
-    S0 = P0; S1 = P1; S2 = P2;
-
-    smax = 0; /* For local alignment score can never be less than 0. */
-
-    /* Initialize the 0th row of the score matrix. */
-    for(j=0; j < ylen; j++) { 
-	score = in->ssm[X[0]][Y[j]]; 
-	if (score < 0) score = 0;
-	/*S[0][j] = score;*/
-	S0[j] = score;
-    }	
-
-    /* Set the 1st row of the score matrix. */
-    score = in->ssm[X[1]][Y[0]];
-    if(score < 0) score = 0;
-    S1[0] = score;
-    for(j=1; j < ylen; j++) {
-	score = S0[j-1];
-	if(j>1 && (a=S0[j-2] + gap) > score)score = a;
-	score += in->ssm[X[1]][Y[j]];
-	if (score < 0) score = 0;
-	S1[j] = score;
-    }
-
-    for(i=2; i < xlen - 1; i++) {
-	score = in->ssm[X[i]][Y[0]];
-	if (score < 0) score = 0;
-	S2[0] = score;
-	score = S1[0];
-	if((a=S0[0] + gap) > score) score = a;
-	score += in->ssm[X[i]][Y[1]];
-	if(score < 0) score = 0;
-	S2[1] = score;
-	for(j=2; j < ylen; j++) {
-	    score = S0[j-1];
-	    if((a=S1[j-2])>score) score = a;
-	    score +=gap;
-	    if((a=S1[j-1]) >score) score = a;
-
-	    score += in->ssm[X[i]][Y[j]];	
-	    if (score < 0 ) score = 0;
-	    S2[j]=score;
-	}
-	S = S0; S0 = S1; S1 = S2; S2 = S;
-    }
-    /* Calculate scores for last row (i = xlen-1) and find smax */
-    i = xlen - 1;
-    score = in->ssm[X[i]][Y[0]];
-    if (score < 0) score = 0;
-    else if (score > smax) smax = score;
-    S2[0] = score;
-    score = S1[0];
-    if((a=S0[0] + gap) > score) score = a;
-    score += in->ssm[X[i]][Y[1]];
-    if(score < 0) score = 0;
-    else if (score > smax) smax = score;
-    S2[1] = score;
-    for(j=2; j < ylen; j++) {
-	score = S0[j-1];
-	if((a=S1[j-2])>score) score = a;
-	score +=gap;
-	if((a=S1[j-1]) >score) score = a;
-	score += in->ssm[X[i]][Y[j]];
-	if (score < 0 ) score = 0;
-	else if (score > smax) smax = score;
-	S2[j]=score;
-    }
-    out->score = smax;
-    out->path_length=0;
-    free(P0); free(P1); free(P2);
-} /* _dpal_long_nopath_maxgap1_local */
@@ -111,4 +111,19 @@ int dpal_set_ambiguity_code_matrix(dpal_args *);
  */
 int dpal(const unsigned char *, const unsigned char*,
 	 const dpal_args *, dpal_results *);
+
+/*
+ * Align the first argument against each of the n sequences in the second,
+ * storing the scores in score[0..n-1]. The results are the same as calling
+ * dpal() on each pair in turn, but for score_only DPAL_LOCAL and
+ * DPAL_LOCAL_END alignments with a max_gap of 1 the working storage is
+ * allocated once and shared between the alignments. The batch stops early
+ * after the first score greater than max_score (use INT_MAX to align
+ * against all n). Any error message is returned in out->msg.
+ *
+ * Returns the number of sequences aligned for success
+ *         -1 for failure
+ */
+int dpal_batch(const unsigned char *, const unsigned char *const *, int,
+	       const dpal_args *, int, dpal_results *, int *);
 #endif
@@ -6,6 +6,7 @@
 
 #include <limits.h>
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include "oligotm.h"
 #include "primer3_release.h"
@@ -272,16 +273,19 @@
  * Query - should AAAACTTTT be considered symmetric? If not then
  * it implies all odd length strings are not. (We treat this as symmetric.)
  *
- * Returns 1 if 's' is a self complement.
+ * Returns 1 if the 'len' bases starting at 's' are a self complement.
  *         0 if not.
  */
-static int is_sym(const char *s) {
-    const char *e = s + strlen(s)-1;
-    int comp[256];
-    comp['A'] = 'T';
-    comp['C'] = 'G';
-    comp['G'] = 'C';
-    comp['T'] = 'A';
+static int is_sym(const char *s, int len) {
+    const char *e = s + len-1;
+    static int comp[256];
+
+    if (!comp['A']) {
+	comp['A'] = 'T';
+	comp['C'] = 'G';
+	comp['G'] = 'C';
+	comp['T'] = 'A';
+    }
 
     while (s < e) {
 	if (comp[(const unsigned char)*s] != *e)
@@ -293,6 +297,75 @@ static int is_sym(const char *s) {
     return 1;
 }
 
+/*
+ * Converts the nearest-neighbour sums dh and ds (in the units of the tables
+ * above) for an oligo of length len into a melting temperature.
+ */
+static double nn_tm(int dh, int ds, int len, int symmetric,
+		    double DNA_nM, double K_mM, double Mg_mM, double dNTP_mM)
+{
+    double delta_H, delta_S;
+#ifdef SANTALUCIA_1998
+    double Ct, salt;
+#endif
+
+    delta_H = dh * -100.0;  /* 
+			     * Nearest-neighbor thermodynamic values for dh
+			     * are given in 100 cal/mol of interaction.
+			     */
+    delta_S = ds * -0.1;     /*
+			      * Nearest-neighbor thermodynamic values for ds
+			      * are in in .1 cal/K per mol of interaction.
+			      */
+
+#ifndef SANTALUCIA_1998
+    /* 
+     * See Rychlik, Spencer, Rhoads, Nucleic Acids Research, vol 18, no 21,
+     * page 6410, eqn (ii).
+     */
+    return delta_H / (delta_S + 1.987 * log(DNA_nM/4000000000.0))
+    	- 273.15 + 16.6 * log10(K_mM/1000.0);
+    
+#else
+    /* SantaLucia salt concentrations: see equation 8:
+     * dS(oligomer) = dS + 0.368 * N * ln(Na+)
+     * dG(oligomer) = dG - 0.114 * N * ln(Na+)
+     * N is number of NN pairs (ie length-1).
+     */
+
+    /* von Ahsen et al, "Oligonucleotide Melting Temperatures under
+     * PCR Conditions: Nearest-Neighbor Corrections for Mg2+,
+     * Deoxynucleotide Triphosphate, and Dimethyl Sulfoxide
+     * Concentrations with Comparison to Alternative Empirical Formulas"
+     * Clinical Chemistry 47: 1956-1961, 2001; 
+     *
+     * Suggests non-linear equiv of 120*sqrt(Mg_mM)
+     *
+     * eg (units correct?)
+     *
+     *   salt = K_mM + 120 * sqrt(Mg_mM - dNTP_mM);
+     *   delta_S += 0.368 * (len-1) * log(salt/1000.0); 
+     *
+     * Paper also mentions older work demonstrating that Mg_mM may
+     * have a 140 fold effect compared to K.ie:
+     *
+     *   delta_S += 0.368 * (len-1) * log(K_mM/1000.0 + 140*Mg_mM/1000.0);
+     */
+
+    if (Mg_mM - dNTP_mM >= 0)
+	salt = K_mM + 120 * sqrt(Mg_mM - dNTP_mM);
+        //salt = K_mM + 140 * Mg_mM;
+    else
+	salt = K_mM;
+
+    delta_S += 0.368 * (len-1) * log(salt/1000.0);
+
+    /* Equation 3 */
+    Ct = log(DNA_nM / (symmetric ? 1000000000. : 4000000000.));
+    return delta_H / (delta_S + 1.987 * Ct) - 273.15;
+#endif
+}
+
 double 
 oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
      const  char *s;
@@ -303,9 +376,8 @@ oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
 {
     register int dh = 0, ds = 0;
     register char c;
-    double delta_H, delta_S, Ct, salt;
     size_t len = strlen(s);
-    int symmetric;
+    int symmetric = 0;
 
     /* const char *orig=s; */
 
@@ -339,7 +411,7 @@ oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
     }
 
     /* Symmetry adjustment */
-    if ((symmetric = is_sym(s))) {
+    if ((symmetric = is_sym(s, len))) {
 	ds += S_SYM;
 	dh += H_SYM;
     }
@@ -360,64 +432,7 @@ oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
     STATE(N);
 
  DONE:  /* dh and ds are now computed for the given sequence. */
-    delta_H = dh * -100.0;  /* 
-			     * Nearest-neighbor thermodynamic values for dh
-			     * are given in 100 cal/mol of interaction.
-			     */
-    delta_S = ds * -0.1;     /*
-			      * Nearest-neighbor thermodynamic values for ds
-			      * are in in .1 cal/K per mol of interaction.
-			      */
-
-#ifndef SANTALUCIA_1998
-    /* 
-     * See Rychlik, Spencer, Rhoads, Nucleic Acids Research, vol 18, no 21,
-     * page 6410, eqn (ii).
-     */
-    return delta_H / (delta_S + 1.987 * log(DNA_nM/4000000000.0))
-    	- 273.15 + 16.6 * log10(K_mM/1000.0);
-    
-#else
-    /* SantaLucia salt concentrations: see equation 8:
-     * dS(oligomer) = dS + 0.368 * N * ln(Na+)
-     * dG(oligomer) = dG - 0.114 * N * ln(Na+)
-     * N is number of NN pairs (ie length-1).
-     */
-
-    /* von Ahsen et al, "Oligonucleotide Melting Temperatures under
-     * PCR Conditions: Nearest-Neighbor Corrections for Mg2+,
-     * Deoxynucleotide Triphosphate, and Dimethyl Sulfoxide
-     * Concentrations with Comparison to Alternative Empirical Formulas"
-     * Clinical Chemistry 47: 1956-1961, 2001; 
-     *
-     * Suggests non-linear equiv of 120*sqrt(Mg_mM)
-     *
-     * eg (units correct?)
-     *
-     *   salt = K_mM + 120 * sqrt(Mg_mM - dNTP_mM);
-     *   delta_S += 0.368 * (len-1) * log(salt/1000.0); 
-     *
-     * Paper also mentions older work demonstrating that Mg_mM may
-     * have a 140 fold effect compared to K.ie:
-     *
-     *   delta_S += 0.368 * (len-1) * log(K_mM/1000.0 + 140*Mg_mM/1000.0);
-     */
-
-    if (Mg_mM - dNTP_mM >= 0)
-	salt = K_mM + 120 * sqrt(Mg_mM - dNTP_mM);
-        //salt = K_mM + 140 * Mg_mM;
-    else
-	salt = K_mM;
-
-    delta_S += 0.368 * (len-1) * log(salt/1000.0);
-
-    /* Equation 3 */
-    Ct = log(DNA_nM / (symmetric ? 1000000000. : 4000000000.));
-    /* printf("%s dh=%f ds=%f tm=%f\n", orig, delta_H, delta_S,
-     *        delta_H / (delta_S + 1.987 * Ct) - 273.15);
-     */
-    return delta_H / (delta_S + 1.987 * Ct) - 273.15;
-#endif
+    return nn_tm(dh, ds, len, symmetric, DNA_nM, K_mM, Mg_mM, dNTP_mM);
 
  ERROR:  /* 
 	  * length of s was less than 2 or there was an illegal character in
@@ -427,6 +442,133 @@ oligotm(s, DNA_nM, K_mM, Mg_mM, dNTP_mM)
 }
 #undef DO_PAIR
 
+/*
+ * Nearest-neighbour tables indexed by base (see nn_idx below), for the
+ * incremental oligotm_range() code.
+ */
+#define NN_ROW(TAB,LAST) \
+    {CATID5(TAB,_,LAST,_,A), CATID5(TAB,_,LAST,_,C), \
+     CATID5(TAB,_,LAST,_,G), CATID5(TAB,_,LAST,_,T), \
+     CATID5(TAB,_,LAST,_,N)}
+static const int nn_dh[5][5] = {
+    NN_ROW(H,A), NN_ROW(H,C), NN_ROW(H,G), NN_ROW(H,T), NN_ROW(H,N)
+};
+static const int nn_ds[5][5] = {
+    NN_ROW(S,A), NN_ROW(S,C), NN_ROW(S,G), NN_ROW(S,T), NN_ROW(S,N)
+};
+#undef NN_ROW
+
+/* Maps A, C, G, T and N to 0-4 and anything else to -1 */
+static int nn_idx(char c) {
+    switch (c) {
+    case 'A': return 0;
+    case 'C': return 1;
+    case 'G': return 2;
+    case 'T': return 3;
+    case 'N': return 4;
+    }
+    return -1;
+}
+
+int oligotm_prefix_init(oligotm_prefix_t *p, const char *seq) {
+    int i, len = strlen(seq), last, this;
+
+    p->seq = seq;
+    p->len = 0;
+    p->dh  = (int *)malloc(3 * (len+1) * sizeof(int));
+    if (!p->dh)
+	return -1;
+    p->ds  = p->dh + len+1;
+    p->bad = p->ds + len+1;
+
+    p->dh[0] = p->ds[0] = p->bad[0] = 0;
+    last = -1;
+    for (i = 0; i < len; i++) {
+	this = nn_idx(seq[i]);
+	p->bad[i+1] = p->bad[i] + (this < 0);
+	p->dh[i+1] = p->dh[i];
+	p->ds[i+1] = p->ds[i];
+	if (last >= 0 && this >= 0) {
+	    p->dh[i+1] += nn_dh[last][this];
+	    p->ds[i+1] += nn_ds[last][this];
+	}
+	last = this;
+    }
+    p->len = len;
+
+    return 0;
+}
+
+void oligotm_prefix_free(oligotm_prefix_t *p) {
+    if (p->dh)
+	free(p->dh);
+    p->dh = p->ds = p->bad = NULL;
+    p->len = 0;
+}
+
+double
+oligotm_range(p, start, len, DNA_nM, K_mM, Mg_mM, dNTP_mM)
+     const oligotm_prefix_t *p;
+     int start;
+     int len;
+     double DNA_nM;
+     double K_mM;
+     double Mg_mM;
+     double dNTP_mM;
+{
+    int end = start + len - 1;
+    int dh, ds, symmetric = 0;
+#ifdef SANTALUCIA_1998
+    const char *s = p->seq + start;
+    char c;
+#endif
+
+    if (len <= 0 || start < 0 || end >= p->len)
+	return OLIGOTM_ERROR;
+    if (p->bad[end+1] - p->bad[start])
+	return OLIGOTM_ERROR;
+
+    /* The pairs lie entirely within the window, so only the ends differ */
+    dh = p->dh[end+1] - p->dh[start+1];
+    ds = p->ds[end+1] - p->ds[start+1];
+
+#ifndef SANTALUCIA_1998
+    ds += 108;
+#else
+    c = s[0];
+    if (c == 'A' || c == 'T') {
+	ds += S_TERM_AT;
+	dh += H_TERM_AT;
+    } else if (c == 'G' || c == 'C') {
+	ds += S_TERM_GC;
+	dh += H_TERM_GC;
+    } else {
+	ds += S_TERM_N;
+	dh += H_TERM_N;
+    }
+
+    c = s[len-1];
+    if (c == 'A' || c == 'T') {
+	ds += S_TERM_AT;
+	dh += H_TERM_AT;
+    } else if (c == 'G' || c == 'C') {
+	ds += S_TERM_GC;
+	dh += H_TERM_GC;
+    } else {
+	ds += S_TERM_N;
+	dh += H_TERM_N;
+    }
+
+    if ((symmetric = is_sym(s, len))) {
+	ds += S_SYM;
+	dh += H_SYM;
+    }
+#endif /* SANTALUCIA_1998 */
+
+    return nn_tm(dh, ds, len, symmetric, DNA_nM, K_mM, Mg_mM, dNTP_mM);
+}
+
+
 #define DO_PAIR(LAST,THIS)          \
   if (CATID2(THIS,_CHAR) == c) {    \
      dg += CATID5(G,_,LAST,_,THIS); \
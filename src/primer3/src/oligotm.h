@@ -43,6 +43,34 @@ double oligotm(const  char *seq, /* The sequence. */
 	       double dNTP_conc  /* dNTP concentration (millimolar). */
 	       );
 
+/*
+ * Incremental melting temperatures for windows of a longer sequence, as
+ * used when scanning candidate oligos over a template.
+ * oligotm_prefix_init() accumulates the nearest-neighbour sums over seq
+ * once (seq must remain valid while p is in use) after which
+ * oligotm_range() returns the same value as oligotm() does on the
+ * substring of length len starting at start, without rescanning it.
+ */
+typedef struct {
+    const char *seq;
+    int len;
+    int *dh, *ds;	/* Cumulative NN sums up to each base */
+    int *bad;		/* Cumulative count of illegal characters */
+} oligotm_prefix_t;
+
+/* Returns 0 for success, -1 for failure (out of memory). */
+int oligotm_prefix_init(oligotm_prefix_t *p, const char *seq);
+void oligotm_prefix_free(oligotm_prefix_t *p);
+
+double oligotm_range(const oligotm_prefix_t *p,
+		     int start,
+		     int len,
+		     double dna_conc,  /* DNA concentration (nanomolar). */
+		     double salt_conc, /* Salt concentration (millimolar). */
+		     double Mg_conc,   /* Magnesium concentration (millimolar). */
+		     double dNTP_conc  /* dNTP concentration (millimolar). */
+		     );
+
 /* Return the delta G of disruption of oligo using the nearest neighbor model;
    seq should be relatively short, given the characteristics of the nearest
    neighbor model. */
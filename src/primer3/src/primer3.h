@@ -7,6 +7,7 @@
 #include <string.h>
 #include <setjmp.h>
 #include "dpal.h"
+#include "oligotm.h"
 
 #define PR_INFINITE_POSITION_PENALTY -1.0
 #define PR_DEFAULT_OUTSIDE_PENALTY    0.0
@@ -227,6 +228,9 @@ typedef struct primer_state {
     int f_len, r_len, mid_len;	/* and their lengths */
     pair_array_t best_pairs;	/* The best primer pairs */
 
+    /* Melting temperature sums over the current trimmed sequence */
+    oligotm_prefix_t tm_prefix;
+
     primer_error err;		/* Error handling */
 } primer_state;
 
@@ -81,6 +81,8 @@ static double obj_fn(const primer_args *, primer_pair *);
 static int    oligo_overlaps_interval(const int, const int,
 				      interval_array_t, const int);
 static int    oligo_pair_seen(const primer_pair *, const pair_array_t *);
+static double oligo_tm(primer_state *, const char *, int, int,
+			double, double, double, double);
 static void   oligo_param(const primer_args *pa,
 			  primer_rec *, oligo_type,
 			  primer_state *, seq_args *, oligo_stats *);
@@ -102,6 +104,7 @@ static void   oligo_compl(primer_rec *, const primer_args *, seq_args *,
 static void   oligo_mispriming(primer_rec *, const primer_args *, seq_args *,
 			       oligo_type, primer_state *);
 static int    pair_repeat_sim(primer_pair *, const primer_args *);
+static int    lib_stop_score(const seq_lib *, short);
 static char   *strstr_nocase(primer_error *, char *, char *);
 static void free_repeat_sim_score(primer_state *);
 static void   set_dpal_args(dpal_args *);
@@ -690,6 +693,8 @@ primer3_create(void)
     state->best_pairs.pairs = NULL;
     state->best_pairs.num_pairs = 0;
 
+    memset(&state->tm_prefix, 0, sizeof(state->tm_prefix));
+
     state->err.system_errno = 0;
     state->err.local_errno = PR_ERR_NONE;
     state->err.error_msg = NULL;
@@ -721,6 +726,7 @@ primer3_destroy(primer_state *state)
 	return;
 
     free_repeat_sim_score(state);
+    oligotm_prefix_free(&state->tm_prefix);
 
     if (state->f)
 	free(state->f);
@@ -771,6 +777,13 @@ primer3_choose(primer_state *state,
 
     if (data_control(state, pa, sa) !=0 ) return 1;
 
+    /*
+     * Candidate oligos overlap heavily, so accumulate the nearest-neighbour
+     * sums once. On failure we fall back to computing each Tm in full.
+     */
+    oligotm_prefix_free(&state->tm_prefix);
+    oligotm_prefix_init(&state->tm_prefix, sa->trimmed_seq);
+
     if (NULL == state->f) {
 	state->f = pr_jump_malloc(&state->err, sizeof(*state->f) * INITIAL_LIST_LEN);
 	state->r = pr_jump_malloc(&state->err, sizeof(*state->r) * INITIAL_LIST_LEN);
@@ -1192,6 +1205,26 @@ substr(const char *seq, int n, int m, char *s)
 	s[m]='\0';
 }
 
+/*
+ * Returns the melting temperature of 's', which is the 'len' bases at
+ * 'start' in the trimmed sequence. This is seqtm() on 's', but uses the
+ * precomputed nearest-neighbour sums where possible.
+ */
+static double
+oligo_tm(state, s, start, len, dna_conc, salt_conc, mg_conc, dntp_conc)
+    primer_state *state;
+    const char *s;
+    int start, len;
+    double dna_conc, salt_conc, mg_conc, dntp_conc;
+{
+    if (len <= MAX_NN_TM_LENGTH && state->tm_prefix.len)
+	return oligotm_range(&state->tm_prefix, start, len,
+			     dna_conc, salt_conc, mg_conc, dntp_conc);
+
+    return seqtm(s, dna_conc, salt_conc, mg_conc, dntp_conc,
+		 MAX_NN_TM_LENGTH);
+}
+
 /*
  * Compute various characteristics of the oligo, and determine
  * if it is acceptable.
@@ -1359,13 +1392,13 @@ oligo_param(pa, h, l, state, sa, stats)
 
     substr(seq,j,k-j+1,s1);
     if(OT_LEFT == l || OT_RIGHT == l) 
-      h->temp = seqtm(s1, pa->dna_conc, pa->salt_conc, 
-		      pa->mg_conc, pa->dntp_conc,
-		      MAX_NN_TM_LENGTH);
+      h->temp = oligo_tm(state, s1, j, k-j+1,
+			 pa->dna_conc, pa->salt_conc, 
+			 pa->mg_conc, pa->dntp_conc);
     else
-      h->temp = seqtm(s1, pa->io_dna_conc, pa->io_salt_conc,
-		      pa->io_mg_conc, pa->io_dntp_conc,
-		      MAX_NN_TM_LENGTH);
+      h->temp = oligo_tm(state, s1, j, k-j+1,
+			 pa->io_dna_conc, pa->io_salt_conc,
+			 pa->io_mg_conc, pa->io_dntp_conc);
     if (((l == OT_LEFT || l == OT_RIGHT) && h->temp < pa->min_tm)
 	|| (l==OT_INTL && h->temp<pa->io_min_tm)) {
 	h->ok = OV_TM_LOW;
@@ -2764,6 +2797,29 @@ oligo_compl(h, ha, sa, l, state)
     }
 }
 
+/*
+ * Returns a score above which an alignment against some member of 'lib'
+ * may exceed 'lib_compl' once weighted, for use as a dpal_batch() stopping
+ * point. It only needs to be a lower bound.
+ */
+static int
+lib_stop_score(lib, lib_compl)
+   const seq_lib *lib;
+   short lib_compl;
+{
+  double wmax = 0;
+  int i;
+
+  for (i = 0; i < lib->seq_num; i++)
+    if (lib->weight[i] > wmax)
+      wmax = lib->weight[i];
+
+  if (wmax <= 0 || lib_compl / wmax >= INT_MAX)
+    return INT_MAX;
+
+  return lib_compl > 0 ? (int)(lib_compl / wmax) - 1 : 0;
+}
+
 static void 
 oligo_mispriming(h, ha, sa, l, state)
    primer_rec *h;
@@ -2775,7 +2831,11 @@ oligo_mispriming(h, ha, sa, l, state)
   char s[MAX_PRIMER_LENGTH+1], s1[MAX_PRIMER_LENGTH+1];
   double w;
   const seq_lib *lib;
-  int i, j, min, max;
+  int i, j, min, max, n, stop, nscores, *scores;
+  const char *x;
+  const unsigned char *const *y;
+  const dpal_args *args;
+  dpal_results r;
   short  lib_compl;
 
   if (OT_INTL == l) {
@@ -2801,17 +2861,37 @@ oligo_mispriming(h, ha, sa, l, state)
     h->repeat_sim.max = h->repeat_sim.min = 0;
     max = min = 0;
     h->repeat_sim.name = lib->names[0];
+
+    /*
+     * Align against the library in batches. Unless the oligo must be used
+     * we stop each batch at the first score which may exceed lib_compl,
+     * just as we stop scanning the library below.
+     */
+    if (OT_RIGHT == l) {
+      x = s;
+      y = (const unsigned char *const *)lib->rev_compl_seqs;
+    } else {
+      x = s1;
+      y = (const unsigned char *const *)lib->seqs;
+    }
+    args = (OT_INTL == l)
+      ? &state->local_args_ambig : &state->local_end_args_ambig;
+    stop = h->must_use ? INT_MAX : lib_stop_score(lib, lib_compl);
+    scores = pr_jump_malloc(&state->err, lib->seq_num * sizeof(int));
+    nscores = 0;
+
     for(i = 0; i < lib->seq_num; i++){
-      if (OT_LEFT == l)
-	  w = lib->weight[i] *
-	      align(state, s1, lib->seqs[i], &state->local_end_args_ambig);
-      else if (OT_INTL == l)
-	  w = lib->weight[i] *
-	      align(state, s1, lib->seqs[i], &state->local_args_ambig);
-      else
-	  w = lib->weight[i] *
-	      align(state, s, lib->rev_compl_seqs[i],
-		    &state->local_end_args_ambig);
+      if (i == nscores) {
+	n = dpal_batch((const unsigned char *)x, y + i, lib->seq_num - i,
+		       args, stop, &r, scores + i);
+	if (n <= 0) {
+	  free(scores);
+	  jump_error(&state->err, PR_ERR_ALIGNMENT_FAILED);
+	}
+	nscores += n;
+      }
+      PR_ASSERT(scores[i] <= SHRT_MAX);
+      w = lib->weight[i] * (scores[i] < 0 ? 0 : scores[i]);
 
       h->repeat_sim.score[i] = w;
       if(w > max){
@@ -2837,9 +2917,10 @@ oligo_mispriming(h, ha, sa, l, state)
 	  sa->intl_expl.repeat++;
 	  sa->intl_expl.ok--;
 	}
-	if (!h->must_use) return;
+	if (!h->must_use) break;
       }
     }
+    free(scores);
   } 
 }
 
@@ -6,45 +6,38 @@
 
 #include "seqInfo.h"
 #include "consen.h"
+#include "qclip.h"
 #include "xalloc.h"
 
-/* johnt 1/6/99 must explicitly import globals from DLLs with Visual C++*/
-#ifdef _MSC_VER
-#  define DLL_IMPORT __declspec(dllimport)
-#else
-#  define DLL_IMPORT
-#endif
- 
-extern DLL_IMPORT char *optarg;
-extern DLL_IMPORT int optind;
-
-typedef struct {
-    /* For both clipping methods */
-    int min;		/* minimum 5' clip point */
-    int max;		/* maximum 3' clip point */
-    int verbose;
-    int use_conf;	/* which method to use, 1 => confidence */
-    int test_mode;	/* 1 => do not write out changes */
-    int min_len;	/* minimum length */
-
-    /* For N-count clipping */
-    int start;		/* Start point for scanning left/right. */
-    int lwin1, lcnt1;	/* 1st left clip window length and number of N's */
-    int lwin2, lcnt2;	/* 2nd left clip window length and number of N's */
-    int rwin1, rcnt1;	/* 1st right clip window length and number of N's */
-    int rwin2, rcnt2;	/* 2nd right clip window length and number of N's */
-
-    /* For confidence value clipping */
-    int qual_val;	/* average quality value */
-    int window_len;	/* over this window length */
-} params;
+/*
+ * Fills out 'p' with the defaults used by the qclip program.
+ */
+void qclip_default_params(qclip_params *p) {
+    p->min = 0;
+    p->max = 10000000;
+    p->min_len = 0;
+    p->verbose = 0;
+    p->use_conf = 1;
+    p->start = 70;
+    p->lwin1 = 20;
+    p->lcnt1 = 3;
+    p->lwin2 = 0;
+    p->lcnt2 = 0;
+    p->rwin1 = 100;
+    p->rcnt1 = 5;
+    p->rwin2 = 0;
+    p->rcnt2 = 0;
+    p->qual_val = 10;
+    p->window_len = 30;
+    p->test_mode = 0;
+}
 
 
 /*
  * Scans through a quality buffer finding the highest average block of length
  * window_len.
  */
-static int find_highest_conf(params p, int1 *conf, int len) {
+static int find_highest_conf(qclip_params p, int1 *conf, int len) {
     int i, total, best_total, best_pos;
 
     if (p.window_len >= len)
@@ -80,7 +73,7 @@ static int find_highest_conf(params p, int1 *conf, int len) {
  * Having found this window, the procedure repeats with successively smaller
  * windows until the exact base is identified.
  */
-int scan_left(params p, int1 *conf, int start_pos) {
+static int scan_left(qclip_params p, int1 *conf, int start_pos) {
     int i, total, lclip;
     int lowest_total;
     int win_len = p.window_len;
@@ -117,7 +110,7 @@ int scan_left(params p, int1 *conf, int start_pos) {
  * Having found this window, the procedure repeats with successively smaller
  * windows until the exact base is identified.
  */
-int scan_right(params p, int1 *conf, int start_pos, int len) {
+static int scan_right(qclip_params p, int1 *conf, int start_pos, int len) {
     int i, total, rclip;
     int lowest_total;
     int win_len = p.window_len;
@@ -147,24 +140,14 @@ int scan_right(params p, int1 *conf, int start_pos, int len) {
 
 
 /*
- * Quality clips file 'file', updating the QL and QR records in the process.
+ * Computes the quality clip points of an already loaded sequence.
  *
  * Returns 0 for success.
- *        -1 for failure.
+ *        -1 if the clipped sequence is shorter than p->min_len.
  */
-static int qclip(char *file, params p) {
-    SeqInfo *si = NULL;
+int qclip_seq(SeqInfo *si, qclip_params *pp, int *left, int *right) {
+    qclip_params p = *pp;
     int start_pos, right_pos, left_pos;
-    FILE *fp;
-
-    if (p.verbose)
-	printf("Clipping file %s\n", file);
-
-    /* Read the sequence and confidence */
-    if (NULL == (si = read_sequence_details(file, 0))) {
-	fprintf(stderr, "Failed to read file '%s'\n", file);
-	return -1;
-    }
 
     if (p.use_conf) {
 	int i;
@@ -213,7 +196,48 @@ static int qclip(char *file, params p) {
     if (left_pos >= right_pos)
 	left_pos = right_pos-1;
 
-    if (right_pos - left_pos < p.min_len) {
+    *left = left_pos;
+    *right = right_pos;
+
+    return right_pos - left_pos < p.min_len ? -1 : 0;
+}
+
+/*
+ * Clips 'nseqs' loaded sequences. Returns the number that failed.
+ */
+int qclip_batch(SeqInfo **si, int nseqs, qclip_params *p,
+		int *left, int *right, int *status) {
+    int i, nfailed = 0;
+
+    for (i = 0; i < nseqs; i++) {
+	if ((status[i] = qclip_seq(si[i], p, &left[i], &right[i])) != 0)
+	    nfailed++;
+    }
+
+    return nfailed;
+}
+
+/*
+ * Quality clips file 'file', updating the QL and QR records in the process.
+ *
+ * Returns 0 for success.
+ *        -1 for failure.
+ */
+int qclip_file(char *file, qclip_params *p) {
+    SeqInfo *si = NULL;
+    int right_pos, left_pos;
+    FILE *fp;
+
+    if (p->verbose)
+	printf("Clipping file %s\n", file);
+
+    /* Read the sequence and confidence */
+    if (NULL == (si = read_sequence_details(file, 0))) {
+	fprintf(stderr, "Failed to read file '%s'\n", file);
+	return -1;
+    }
+
+    if (qclip_seq(si, p, &left_pos, &right_pos) != 0) {
 	fprintf(stderr, "Sequence too short (length=%d)\n",
 		right_pos - left_pos);
 	freeSeqInfo(si);
@@ -221,7 +245,7 @@ static int qclip(char *file, params p) {
     }
 
     /* Append details onto the end of the Exp File */
-    if (!p.test_mode) {
+    if (!p->test_mode) {
 	if (NULL == (fp = fopen(file, "a"))) {
 	    fprintf(stderr, "Failed to write file '%s'\n", file);
 	    freeSeqInfo(si);
@@ -238,121 +262,3 @@ static int qclip(char *file, params p) {
     return 0;
 }
 
-static void usage(void) {
-    fprintf(stderr,
-	"Usage for using confidence codes (default mode):\n"
-	"       qclip [-c] [-vt] [-m min 5' cutoff] [-M max 3' cutoff] [-x min_length]\n"
-	"                  [-w window_len(30)] [-q average_quality (10)] file ...\n\n"
-	"Usage for using sequence only:\n"
-	"       qclip -n   [-vt] [-m min 5' cutoff] [-M max 3' cutoff] [-x min_length]\n"
-	"                  [-s start_offset(70)]\n"
-	"                  [-L left_window_len(20)] [-l left_N_count(3)]\n"
-	"                  [-R right_window_len(100)] [-r right_N_count(5)] file ...\n"
-	    );
-    exit(1);
-}
-
-int main(int argc, char **argv) {
-    int c, i, ret = 0;
-    params p;
-
-    /* Defaults */
-    p.min = 0;
-    p.max = 10000000;
-    p.min_len = 0;
-    p.verbose = 0;
-    p.use_conf = 1;
-    p.start = 70;
-    p.lwin1 = 20;
-    p.lcnt1 = 3;
-    p.lwin2 = 0;
-    p.lcnt2 = 0;
-    p.rwin1 = 100;
-    p.rcnt1 = 5;
-    p.rwin2 = 0;
-    p.rcnt2 = 0;
-    p.qual_val = 10;
-    p.window_len = 30;
-    p.test_mode = 0;
-
-    while ((c = getopt(argc, argv, "q:w:vtncm:M:R:r:L:l:s:x:")) != -1) {
-	switch (c) {
-	    /* Both methods */
-	case 'v':
-	    p.verbose = 1;
-	    break;
-
-	case 't':
-	    p.test_mode = 1;
-	    break;
-
-	case 'm':
-	    p.min = atoi(optarg);
-	    break;
-
-	case 'M':
-	    p.max = atoi(optarg);
-	    break;
-
-	case 'x':
-	    p.min_len = atoi(optarg);
-	    break;
-
-	case 'n':
-	    p.use_conf = 0;
-	    break;
-
-	case 'c':
-	    p.use_conf = 1;
-	    break;
-
-	    /* New method */
-	case 'q':	    
-	    p.qual_val = atoi(optarg);
-	    break;
-
-	case 'w':
-	    p.window_len = atoi(optarg);
-	    break;
-
-	    /* Old method */
-	case 'R':
-	    p.rwin1 = atoi(optarg);
-	    break;
-
-	case 'r':
-	    p.rcnt1 = atoi(optarg);
-	    break;
-
-	case 'L':
-	    p.lwin1 = atoi(optarg);
-	    break;
-
-	case 'l':
-	    p.lcnt1 = atoi(optarg);
-	    break;
-
-	case 's':
-	    p.start = atoi(optarg);
-	    break;
-
-	default:
-	    usage();
-	}
-    }
-
-    if (optind == argc)
-	usage();
-
-    for (i = optind; i < argc; i++) {
-	int ret_val;
-
-	ret_val = qclip(argv[i], p);
-	if (p.verbose)
-	    printf("    qclip() returned %d\n", ret_val);
-
-	ret |= ret_val;
-    }
-
-    return ret ? 1 : 0;
-}
@@ -0,0 +1,60 @@
+#ifndef _QCLIP_H_
+#define _QCLIP_H_
+
+#include "seqInfo.h"
+
+typedef struct {
+    /* For both clipping methods */
+    int min;		/* minimum 5' clip point */
+    int max;		/* maximum 3' clip point */
+    int verbose;
+    int use_conf;	/* which method to use, 1 => confidence */
+    int test_mode;	/* 1 => do not write out changes */
+    int min_len;	/* minimum length */
+
+    /* For N-count clipping */
+    int start;		/* Start point for scanning left/right. */
+    int lwin1, lcnt1;	/* 1st left clip window length and number of N's */
+    int lwin2, lcnt2;	/* 2nd left clip window length and number of N's */
+    int rwin1, rcnt1;	/* 1st right clip window length and number of N's */
+    int rwin2, rcnt2;	/* 2nd right clip window length and number of N's */
+
+    /* For confidence value clipping */
+    int qual_val;	/* average quality value */
+    int window_len;	/* over this window length */
+} qclip_params;
+
+/*
+ * Fills out 'p' with the defaults used by the qclip program.
+ */
+void qclip_default_params(qclip_params *p);
+
+/*
+ * Computes the quality clip points of an already loaded sequence, storing
+ * them in *left and *right (QL and QR). Nothing is written to disk and
+ * si itself is not altered.
+ *
+ * Returns 0 for success.
+ *        -1 if the clipped sequence is shorter than p->min_len.
+ */
+int qclip_seq(SeqInfo *si, qclip_params *p, int *left, int *right);
+
+/*
+ * Runs qclip_seq() over 'nseqs' sequences, filling out left[i], right[i]
+ * and status[i] (the qclip_seq return value) for each.
+ *
+ * Returns the number of sequences that failed.
+ */
+int qclip_batch(SeqInfo **si, int nseqs, qclip_params *p,
+		int *left, int *right, int *status);
+
+/*
+ * Quality clips file 'file', appending QL and QR records to it (or just
+ * printing them in test mode).
+ *
+ * Returns 0 for success.
+ *        -1 for failure.
+ */
+int qclip_file(char *file, qclip_params *p);
+
+#endif /* _QCLIP_H_ */
@@ -0,0 +1,120 @@
+#include <staden_config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include "qclip.h"
+
+/* johnt 1/6/99 must explicitly import globals from DLLs with Visual C++*/
+#ifdef _MSC_VER
+#  define DLL_IMPORT __declspec(dllimport)
+#else
+#  define DLL_IMPORT
+#endif
+ 
+extern DLL_IMPORT char *optarg;
+extern DLL_IMPORT int optind;
+
+static void usage(void) {
+    fprintf(stderr,
+	"Usage for using confidence codes (default mode):\n"
+	"       qclip [-c] [-vt] [-m min 5' cutoff] [-M max 3' cutoff] [-x min_length]\n"
+	"                  [-w window_len(30)] [-q average_quality (10)] file ...\n\n"
+	"Usage for using sequence only:\n"
+	"       qclip -n   [-vt] [-m min 5' cutoff] [-M max 3' cutoff] [-x min_length]\n"
+	"                  [-s start_offset(70)]\n"
+	"                  [-L left_window_len(20)] [-l left_N_count(3)]\n"
+	"                  [-R right_window_len(100)] [-r right_N_count(5)] file ...\n"
+	    );
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    int c, i, ret = 0;
+    qclip_params p;
+
+    /* Defaults */
+    qclip_default_params(&p);
+
+    while ((c = getopt(argc, argv, "q:w:vtncm:M:R:r:L:l:s:x:")) != -1) {
+	switch (c) {
+	    /* Both methods */
+	case 'v':
+	    p.verbose = 1;
+	    break;
+
+	case 't':
+	    p.test_mode = 1;
+	    break;
+
+	case 'm':
+	    p.min = atoi(optarg);
+	    break;
+
+	case 'M':
+	    p.max = atoi(optarg);
+	    break;
+
+	case 'x':
+	    p.min_len = atoi(optarg);
+	    break;
+
+	case 'n':
+	    p.use_conf = 0;
+	    break;
+
+	case 'c':
+	    p.use_conf = 1;
+	    break;
+
+	    /* New method */
+	case 'q':	    
+	    p.qual_val = atoi(optarg);
+	    break;
+
+	case 'w':
+	    p.window_len = atoi(optarg);
+	    break;
+
+	    /* Old method */
+	case 'R':
+	    p.rwin1 = atoi(optarg);
+	    break;
+
+	case 'r':
+	    p.rcnt1 = atoi(optarg);
+	    break;
+
+	case 'L':
+	    p.lwin1 = atoi(optarg);
+	    break;
+
+	case 'l':
+	    p.lcnt1 = atoi(optarg);
+	    break;
+
+	case 's':
+	    p.start = atoi(optarg);
+	    break;
+
+	default:
+	    usage();
+	}
+    }
+
+    if (optind == argc)
+	usage();
+
+    for (i = optind; i < argc; i++) {
+	int ret_val;
+
+	ret_val = qclip_file(argv[i], &p);
+	if (p.verbose)
+	    printf("    qclip() returned %d\n", ret_val);
+
+	ret |= ret_val;
+    }
+
+    return ret ? 1 : 0;
+}
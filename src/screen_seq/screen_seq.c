@@ -3,7 +3,9 @@
    possible contaminant are given a comment line to indicate this and their names
    are not written to the pass file, but go to the fail file.
    The files to screen against are obtained from a file of file names or can be
-   a single file.
+   a single file. They are combined into one index, which can be saved with -w
+   and reused with -r, so that each reading needs only one search however many
+   sequences are screened against.
    It is a very quick screen: the best match is found (say >25) and then all other 8 base
    matches within window/2 either side are added up and the percentage overlap found is
    used as a test.
@@ -193,73 +195,6 @@ int get_vfilenames_old ( FILE *fp, char *fofn_name ) {
   return num_read;
 }
 
-/************************************************************/
-
-void store_hash ( 
-	         int *hash_values, 	/* the hash values for each position in a seq */
-		 int seq_len, 		/* size of the seq and hash array */
-		 int *last_word, 	/* last occurrence of this hash value */
-		 int *word_count, 	/* frequency of each hash value or word */
-		 int word_length,       /* word length */
-		 int size_wc ) {	/* number of elements in word_count and first_word */
-
-
-/* 	store the hash values in hash_values: put number of occurrences of
-	each hash value in word_count; put the array position of the last 
-	occurrence of each hash value in last_word, and previous
-	occurrences in hash_values[last_word]. 
-	Note that words containing unknown characters (like '-') are given
-	hash value -1. So we skip them here, and they are ignored.
-*/
-
-
-    int nw;
-    register int i,j,n;
-
-/* 	zero the word counts */
-
-    for ( i=0;i<size_wc;i++ ) {
-	word_count[i] = 0;
-	last_word[i] = 0;
-    }
-
-/*	loop for all entries in hash_values	*/
-
-    j = seq_len - word_length + 1;
-
-    for ( i = 0; i < j; i++ ) {
-
-	n = hash_values[i];
-
-/*	is it a good value ? */
-
-	if ( -1 != n ) {
-
-	    nw = word_count[n];
-
-/* 		already an entry for this word ? */
-
-	    if ( 0 == nw ) {
-
-/*		no, so put in last_word */
-
-		last_word[n] = i;
-		word_count[n] += 1;
-	    }
-
-/*		yes, so put previous last occurrence in hash_values*/
-
-	    else {
-
-		word_count[n] += 1;
-		hash_values[i] = last_word[n];
-		last_word[n] = i;
-	    }
-	}
-    }
-}
-
-
 int dna_hash8_lookup[256];
 
 void set_hash8_lookup(void) {
@@ -283,59 +218,6 @@ void set_hash8_lookup(void) {
 
 }
 
-int init_hash8 ( int seq1_len, int seq2_len,
-	        int **hash_values1, int **last_word,
-	        int **word_count, int **hash_values2,
-	        int **diag, int **line ) {
-    int size_hash, word_length;
-
-    word_length = 8;
-
-    set_hash8_lookup ();
-
-    size_hash = 65536;
-
-
-    if ( NULL == (*hash_values1 = (int *) xmalloc ( sizeof(int)*(seq1_len) ))) {
-	return -2;
-    }
-
-    if ( ! (*last_word = (int *) xmalloc ( sizeof(int)*size_hash ))) {
-	return -2;
-    }
-
-    if ( ! (*word_count = (int *) xmalloc ( sizeof(int)*size_hash ))) {
-	return -2;
-    }
-
-
-    if ( ! (*hash_values2 = (int *) xmalloc ( sizeof(int)*(seq2_len) ))) {
-	return -2;
-    }
-
-    if ( ! (*line = (int *) xmalloc ( sizeof(int)*(seq2_len) ))) {
-	return -2;
-    }
-
-    if ( ! (*diag = (int *) xmalloc ( sizeof(int)*(seq2_len + seq1_len) ))) {
-	return -2;
-    }
-
-    return 0;
-}
-
-void free_hash8 ( int *hash_values1, int *last_word,
-	        int *word_count, int *hash_values2,
-	        int *diag) {
-
-    if ( hash_values1 ) xfree ( hash_values1 );
-    if ( hash_values2 ) xfree ( hash_values2 );
-    if ( word_count )   xfree ( word_count );
-    if ( last_word )    xfree ( last_word );
-    if ( diag )         xfree ( diag );
-
-}
-
 int hash_word8 ( char *seq, int *start_base, int seq_len,
 	      unsigned short *uword) {
 
@@ -433,199 +315,436 @@ int hash_seq8 ( char *seq, int *hash_values, int seq_len) {
     return 0;
 }
 
-int do_hash_con (   int seq1_len, int seq2_len,
-	        int *hash_values1, int *last_word,
-	        int *word_count, int *hash_values2,
-		int *diag, int *line,
-	        char *seq1, char *seq2, int new_seq1, 
-	        int min_match, int half_window, int *x, int *y, int *score ) {
-
-    int nrw, word, pw1, pw2, i, ncw, j, match_length, word_length = 8;
-    int size_hash = 65536;
-    int diag_pos;
-    int top_score, min_line, max_line, line_pos, i1, i2, j1, j2, k;
-    int top_score_pos, new_score, xx, yy;
-    double n_score;
-
-    /* seq2 is the reading which changes each entry, but seq1 is
-       the vector which may be the same for consecutive
-       entries, so we use new_seq1 to tell if we need to hash seq1
-    */
+/************************************************************/
 
-	
-    *score = 0;
-    if ( seq1_len < min_match ) return -4; 
-    if ( seq2_len < min_match ) return -4; 
+/*
+ * The screening library is held as a single index: every sequence is
+ * appended to one buffer, separated by a '-' so that no word spans two
+ * sequences, and the positions of each 8 base word are kept in one array
+ * sorted by word. A reading is then screened against the whole library
+ * with a single pass over its words rather than once per library
+ * sequence. The index can be written to disk and reloaded, so that a
+ * large library need only be hashed once.
+ */
+
+#define CONT_WORD_LENGTH 8
+#define CONT_SIZE_HASH 65536
+#define CONT_INDEX_MAGIC 0x53534958 /* "SSIX" */
+#define CONT_INDEX_VERSION 2
+
+typedef struct {
+    int nseqs;		/* number of library sequences */
+    char **names;	/* their file names */
+    int *start;		/* offset of each sequence in seq */
+    int *length;	/* and its length */
+    int seqs_alloc;
+    char *seq;		/* all the sequences, '-' separated */
+    int seq_len;
+    int seq_alloc;
+    int *word_start;	/* word_pos index of the first hit for each word */
+    int *word_pos;	/* positions in seq, descending for each word */
+    int nwords;
+} Cont_index;
+
+typedef struct {
+    int *hash_values;	/* the hashed reading */
+    int read_alloc;
+    int *diag_end;	/* end of the last match tried on each diagonal */
+    int *diag_seq;	/* library sequence that match was against */
+    int *diag_serial;	/* and the search it belongs to */
+    int diag_alloc;
+    int serial;
+} Cont_scratch;
+
+Cont_index *cont_index_create(void) {
+    return (Cont_index *) xcalloc ( 1, sizeof(Cont_index) );
+}
 
+void cont_index_destroy(Cont_index *ci) {
+    int i;
 
-    if ( new_seq1 ) {
+    if ( !ci ) return;
 
-	if ( hash_seq8 ( seq1, hash_values1, seq1_len )  != 0 ) {
-	    return -1;
-	}
+    if ( ci->names ) {
+	for ( i = 0; i < ci->nseqs; i++ )
+	    if ( ci->names[i] ) xfree ( ci->names[i] );
+	xfree ( ci->names );
+    }
+    if ( ci->start )      xfree ( ci->start );
+    if ( ci->length )     xfree ( ci->length );
+    if ( ci->seq )        xfree ( ci->seq );
+    if ( ci->word_start ) xfree ( ci->word_start );
+    if ( ci->word_pos )   xfree ( ci->word_pos );
+    xfree ( ci );
+}
 
-	(void) store_hash ( hash_values1, seq1_len, last_word, word_count,
-			    word_length, size_hash);
+int cont_index_add(Cont_index *ci, char *name, char *seq, int seq_len) {
+
+/*	append a sequence to the library. cont_index_build() must be
+	called once all have been added */
+
+    if ( ci->nseqs == ci->seqs_alloc ) {
+	ci->seqs_alloc = ci->seqs_alloc ? ci->seqs_alloc * 2 : 16;
+	if ( ! (ci->names = (char **) xrealloc ( ci->names,
+				   sizeof(char *)*ci->seqs_alloc )))
+	    return -2;
+	if ( ! (ci->start = (int *) xrealloc ( ci->start,
+				   sizeof(int)*ci->seqs_alloc )))
+	    return -2;
+	if ( ! (ci->length = (int *) xrealloc ( ci->length,
+				   sizeof(int)*ci->seqs_alloc )))
+	    return -2;
     }
 
-    if ( hash_seq8 ( seq2, hash_values2, seq2_len )  != 0 ) {
-	return -1;
+    if ( ci->seq_len + seq_len + 1 > ci->seq_alloc ) {
+	ci->seq_alloc = MAX ( ci->seq_alloc * 2, ci->seq_len + seq_len + 1 );
+	if ( ! (ci->seq = (char *) xrealloc ( ci->seq, ci->seq_alloc )))
+	    return -2;
     }
 
-    j = seq1_len + seq2_len;
-    for (i=0;i<j;i++) diag[i] = -word_length;
+    if ( ! (ci->names[ci->nseqs] = (char *) xmalloc ( strlen(name)+1 )))
+	return -2;
+    strcpy ( ci->names[ci->nseqs], name );
+    ci->start[ci->nseqs] = ci->seq_len;
+    ci->length[ci->nseqs] = seq_len;
+    ci->nseqs++;
 
-    nrw = seq2_len - word_length + 1;
+    memcpy ( &ci->seq[ci->seq_len], seq, seq_len );
+    ci->seq_len += seq_len;
+    ci->seq[ci->seq_len++] = '-';
 
-/* 	loop for all (nrw) complete words in hash_values2 */
+    return 0;
+}
 
+int cont_index_build(Cont_index *ci) {
 
-    for (pw2=0;pw2<nrw;pw2++) {
+/*	hash every library sequence and bucket the word positions by
+	hash value, highest position first */
 
- 	word = hash_values2[pw2];
+    int *hash_values, *next;
+    int i, n;
 
-	if ( -1 != word ) {
+    if ( NULL == (hash_values = (int *) xmalloc ( sizeof(int)*(ci->seq_len+1) )))
+	return -2;
+    for ( i = 0; i < ci->seq_len; i++ ) hash_values[i] = -1;
 
-	    if ( 0 != (ncw = word_count[word]) ) {
+    for ( i = 0; i < ci->nseqs; i++ ) {
+	if ( hash_seq8 ( &ci->seq[ci->start[i]], &hash_values[ci->start[i]],
+			 ci->length[i] ) != 0 ) {
+	    fprintf(stderr, "Error: could not hash sequence file %s\n",
+		    ci->names[i]);
+	}
+    }
 
-		for (j=0,pw1=last_word[word];j<ncw;j++) {
+    if ( ci->word_start ) xfree ( ci->word_start );
+    if ( ci->word_pos )   xfree ( ci->word_pos );
+    ci->word_pos = NULL;
 
-		    diag_pos = seq1_len - pw1 + pw2 - 1;
+    if ( NULL == (ci->word_start = (int *) xcalloc ( CONT_SIZE_HASH+1,
+						     sizeof(int) ))) {
+	xfree ( hash_values );
+	return -2;
+    }
+    for ( i = 0; i < ci->seq_len; i++ )
+	if ( -1 != hash_values[i] ) ci->word_start[hash_values[i]+1]++;
+    for ( i = 0; i < CONT_SIZE_HASH; i++ )
+	ci->word_start[i+1] += ci->word_start[i];
+    ci->nwords = ci->word_start[CONT_SIZE_HASH];
+
+    if ( NULL == (next = (int *) xmalloc ( sizeof(int)*CONT_SIZE_HASH ))) {
+	xfree ( hash_values );
+	return -2;
+    }
+    if ( NULL == (ci->word_pos = (int *) xmalloc ( sizeof(int)*(ci->nwords+1) ))) {
+	xfree ( next );
+	xfree ( hash_values );
+	return -2;
+    }
+    memcpy ( next, ci->word_start, sizeof(int)*CONT_SIZE_HASH );
 
-		    if ( diag[diag_pos] < pw2 ) {
+    for ( i = ci->seq_len - 1; i >= 0; i-- ) {
+	if ( -1 != (n = hash_values[i]) )
+	    ci->word_pos[next[n]++] = i;
+    }
 
-			if ((match_length = match_len ( 
-						  seq1, pw1, seq1_len,
-						  seq2, pw2, seq2_len))
-			    >= min_match ) {
+    xfree ( next );
+    xfree ( hash_values );
+    return 0;
+}
 
-			  *score = match_length;
-			  *x = pw1+1;
-			  *y = pw2+1;
-			  return 1;
-			}
-			diag[diag_pos] = pw2 + match_length;
-		    }
-		    pw1 = hash_values1[pw1];
-		}
-	    }
-	}
+static int write_int4s ( FILE *fp, int *values, int n ) {
+    int i;
+    int4 v;
+
+    for ( i = 0; i < n; i++ ) {
+	v = be_int4 ( values[i] );
+	if ( 1 != fwrite ( &v, sizeof(v), 1, fp )) return -1;
+    }
+    return 0;
+}
+
+static int read_int4s ( FILE *fp, int *values, int n ) {
+    int i;
+    int4 v;
+
+    for ( i = 0; i < n; i++ ) {
+	if ( 1 != fread ( &v, sizeof(v), 1, fp )) return -1;
+	values[i] = be_int4 ( v );
     }
+    return 0;
+}
 
-    if ( *score < min_match ) return 0;
+int cont_index_write(Cont_index *ci, char *file_name) {
 
-    /* NONE OF THIS USED */
+/*	save the index in a byte order independent form */
 
+    FILE *fp;
+    int header[6], i, err = 0;
 
-    /* check out this region by adding up the matches
-       in all the loca hits to see how much of the
-       reading they cover */
+    if ( NULL == (fp = fopen ( file_name, "wb" ))) return -1;
 
-    top_score_pos = 0; /* to keep marks compiler happy */
-    if ( top_score_pos < seq1_len ) {
-	yy = seq1_len - top_score_pos - 1;
-	xx = 0;
+    header[0] = CONT_INDEX_MAGIC;
+    header[1] = CONT_INDEX_VERSION;
+    header[2] = CONT_WORD_LENGTH;
+    header[3] = ci->nseqs;
+    header[4] = ci->seq_len;
+    header[5] = ci->nwords;
+    err |= write_int4s ( fp, header, 6 );
+
+    for ( i = 0; i < ci->nseqs && !err; i++ ) {
+	int n = strlen ( ci->names[i] );
+
+	err |= write_int4s ( fp, &ci->start[i], 1 );
+	err |= write_int4s ( fp, &ci->length[i], 1 );
+	err |= write_int4s ( fp, &n, 1 );
+	if ( n && 1 != fwrite ( ci->names[i], n, 1, fp )) err = 1;
     }
-    else {
-	xx = top_score_pos - seq1_len + 1;
-	yy = 0;
+
+    if ( !err && ci->seq_len && 1 != fwrite ( ci->seq, ci->seq_len, 1, fp ))
+	err = 1;
+    if ( !err ) err |= write_int4s ( fp, ci->word_start, CONT_SIZE_HASH+1 );
+    if ( !err ) err |= write_int4s ( fp, ci->word_pos, ci->nwords );
+
+    if ( fclose ( fp )) err = 1;
+    return err ? -1 : 0;
+}
+
+Cont_index *cont_index_read(char *file_name) {
+
+/*	load an index saved by cont_index_write() */
+
+    FILE *fp;
+    Cont_index *ci;
+    int header[6], i, n;
+
+    if ( NULL == (fp = fopen ( file_name, "rb" ))) return NULL;
+
+    if ( read_int4s ( fp, header, 6 ) ||
+	 header[0] != CONT_INDEX_MAGIC ||
+	 header[1] != CONT_INDEX_VERSION ||
+	 header[2] != CONT_WORD_LENGTH ||
+	 header[3] < 0 || header[4] < 0 || header[5] < 0 ) {
+	fclose ( fp );
+	return NULL;
     }
 
-    top_score = *score;
+    if ( NULL == (ci = cont_index_create ()))
+	goto error;
+
+    ci->seqs_alloc = MAX ( header[3], 1 );
+    ci->seq_len = ci->seq_alloc = header[4];
+    ci->nwords = header[5];
+
+    if ( ! (ci->names = (char **) xcalloc ( ci->seqs_alloc, sizeof(char *) )) ||
+	 ! (ci->start = (int *) xmalloc ( sizeof(int)*ci->seqs_alloc )) ||
+	 ! (ci->length = (int *) xmalloc ( sizeof(int)*ci->seqs_alloc )) ||
+	 ! (ci->seq = (char *) xmalloc ( ci->seq_len+1 )) ||
+	 ! (ci->word_start = (int *) xmalloc ( sizeof(int)*(CONT_SIZE_HASH+1) )) ||
+	 ! (ci->word_pos = (int *) xmalloc ( sizeof(int)*(ci->nwords+1) )))
+	goto error;
+
+    for ( i = 0; i < header[3]; i++ ) {
+	if ( read_int4s ( fp, &ci->start[i], 1 ) ||
+	     read_int4s ( fp, &ci->length[i], 1 ) ||
+	     read_int4s ( fp, &n, 1 ) || n < 0 || n > FILENAME_MAX )
+	    goto error;
+	if ( ! (ci->names[i] = (char *) xmalloc ( n+1 )))
+	    goto error;
+	ci->nseqs++;
+	if ( n && 1 != fread ( ci->names[i], n, 1, fp ))
+	    goto error;
+	ci->names[i][n] = '\0';
+	if ( ci->start[i] < 0 || ci->length[i] < 0 ||
+	     ci->start[i] + ci->length[i] >= ci->seq_len )
+	    goto error;
+    }
 
-    min_line = yy;
-    max_line = MIN(seq1_len-yy,seq2_len-xx) - (word_length-1);
+    if ( ci->seq_len && 1 != fread ( ci->seq, ci->seq_len, 1, fp ))
+	goto error;
+    if ( read_int4s ( fp, ci->word_start, CONT_SIZE_HASH+1 ) ||
+	 read_int4s ( fp, ci->word_pos, ci->nwords ) ||
+	 ci->word_start[0] != 0 ||
+	 ci->word_start[CONT_SIZE_HASH] != ci->nwords )
+	goto error;
+    for ( i = 0; i < CONT_SIZE_HASH; i++ )
+	if ( ci->word_start[i] > ci->word_start[i+1] ) goto error;
+    for ( i = 0; i < ci->nwords; i++ )
+	if ( ci->word_pos[i] < 0 || ci->word_pos[i] >= ci->seq_len ) goto error;
+
+    fclose ( fp );
+    return ci;
+
+ error:
+    fclose ( fp );
+    cont_index_destroy ( ci );
+    return NULL;
+}
 
-    for ( i=0;i<max_line;i++) line[i] = 0;
-    i1 = MAX(0,xx-half_window);
-    i2 = MIN(i1+max_line+half_window,seq2_len-word_length);
+static int cont_index_seq ( Cont_index *ci, int pos ) {
 
-    j1 = top_score_pos-half_window;
-    j2 = top_score_pos+half_window;
+/*	which library sequence holds position pos ? */
 
-    for (i=i1;i<i2;i++) {
-	word = hash_values2[i];
-	if ( -1 != word ) {
-	    if ( 0 != (ncw = word_count[word]) ) {
-		pw1 = last_word[word];
-		for (j=0;j<ncw;j++) {
-		    k = i - pw1 + seq1_len - 1;
-		    if((k>j1)&&(k<j2)) {
-			line_pos = pw1 - min_line;
+    int lo = 0, hi = ci->nseqs - 1, mid;
 
-			if ( (line_pos > 0) && (line_pos < max_line) ) line[line_pos]=1;
-		    }
-		    pw1 = hash_values1[pw1];
-		}
-	    }
-	}
+    while ( lo < hi ) {
+	mid = (lo + hi + 1) / 2;
+	if ( ci->start[mid] <= pos )
+	    lo = mid;
+	else
+	    hi = mid - 1;
     }
-    for (i=0,new_score=0;i<max_line;i++) new_score += line[i];
-    n_score = 100.0 * (double)new_score/(double)(max_line-1);
-    *score = (int) (n_score + 0.5);
-    return 1;
+    return lo;
 }
 
-int do_it_con ( char *vector_seq, int max_vector,
-	       FILE *fp_s, FILE *fp_i, FILE *fp_p, FILE *fp_f,
-	       int word_length, int min_match, int percent_cut,
-	       int window_size, int tmode, int mode_v, char *fofn_s,
-	       int mode_i) {
+static int cont_scratch_size ( Cont_scratch *cs, Cont_index *ci, int read_len ) {
 
-    char *seq, *expt_file_name;
+/*	make sure the work arrays are large enough for this reading */
 
-    Exp_info *e;
-    int ql,qr,seq_length,i;
+    int n;
 
-/* for this algorithm */
+    if ( read_len > cs->read_alloc ) {
+	if ( ! (cs->hash_values = (int *) xrealloc ( cs->hash_values,
+					   sizeof(int)*read_len )))
+	    return -2;
+	cs->read_alloc = read_len;
+    }
 
-    int *hash_values1, *hash_values2, *last_word, *word_count;
-    int *diag, *line;
-    int vector_length, x, y, ret, eret;
-    char *vfile_name;
-    int num_files, file_num, num_vfiles, vfile_num;
-    FILE *vf;
-    int sl, sr; /* sequencing vector left and right */
-    int new_vector = 0;
-    int score, score_f, score_r;
-    int lg, rg, xf, xr, yf, yr;
-    int match_found, half_window;
-    int size_hash = 65536;
+    n = ci->seq_len + read_len;
+    if ( n > cs->diag_alloc ) {
+	if ( ! (cs->diag_end = (int *) xrealloc ( cs->diag_end, sizeof(int)*n )) ||
+	     ! (cs->diag_seq = (int *) xrealloc ( cs->diag_seq, sizeof(int)*n )) ||
+	     ! (cs->diag_serial = (int *) xrealloc ( cs->diag_serial, sizeof(int)*n )))
+	    return -2;
+	memset ( cs->diag_serial, 0, sizeof(int)*n );
+	cs->diag_alloc = n;
+	cs->serial = 0;
+    }
+    return 0;
+}
 
-    half_window = MAX(1,window_size/2);
-    if ( min_match < 8 ) min_match = 8;
+static void cont_scratch_free ( Cont_scratch *cs ) {
+    if ( cs->hash_values ) xfree ( cs->hash_values );
+    if ( cs->diag_end )    xfree ( cs->diag_end );
+    if ( cs->diag_seq )    xfree ( cs->diag_seq );
+    if ( cs->diag_serial ) xfree ( cs->diag_serial );
+}
+
+int cont_index_screen ( Cont_index *ci, Cont_scratch *cs,
+		        char *seq2, int seq2_len, int min_match,
+		        int limit, int first_only,
+		        int *x, int *y, int *score ) {
+
+    /* Find matches of at least min_match between seq2 (the reading) and
+       library sequences 0..limit-1 in one pass over the reading's words.
+       For each library sequence the first such match is returned in
+       x, y and score (score is 0 if there was none), exactly as a
+       search against that sequence alone would have found it. If
+       first_only is set only the lowest numbered matching sequence is
+       needed, so hits on higher numbered ones are ignored once it is
+       known. Returns the lowest numbered matching sequence, limit if
+       there are none, or -1 if the reading could not be hashed.
+    */
 
-    if ( init_hash8 ( max_vector, MAX_READ,
-		     &hash_values1, &last_word, &word_count,
-		     &hash_values2, &diag, &line ))
+    int nrw, word, pw1, pw2, i, k, s, diag_pos, match_length;
+    int best;
+
+    if ( cont_scratch_size ( cs, ci, seq2_len ))
 	return -1;
 
-    if ( mode_i ) {
-	if (( num_files = get_filenames ( fp_i )) < 1 )
-	    return -1;
+    if ( hash_seq8 ( seq2, cs->hash_values, seq2_len )  != 0 ) {
+	return -1;
     }
-    else {
-	num_files = 1;
+
+    for ( i = 0; i < limit; i++ ) score[i] = 0;
+    best = limit;
+    cs->serial++;
+
+    nrw = seq2_len - CONT_WORD_LENGTH + 1;
+
+    for ( pw2 = 0; pw2 < nrw && !(first_only && 0 == best); pw2++ ) {
+
+	if ( -1 == (word = cs->hash_values[pw2]) ) continue;
+
+	for ( k = ci->word_start[word]; k < ci->word_start[word+1]; k++ ) {
+
+	    i = ci->word_pos[k];
+	    s = cont_index_seq ( ci, i );
+	    if ( s >= (first_only ? best : limit) || score[s] ) continue;
+
+	    /* diagonals are numbered across the whole library, so an entry
+	       is only valid for the sequence and search that set it */
+
+	    diag_pos = i - pw2 + seq2_len - 1;
+	    if ( cs->diag_serial[diag_pos] == cs->serial &&
+		 cs->diag_seq[diag_pos] == s &&
+		 cs->diag_end[diag_pos] >= pw2 ) continue;
+
+	    pw1 = i - ci->start[s];
+	    if ((match_length = match_len ( 
+				   &ci->seq[ci->start[s]], pw1, ci->length[s],
+				   seq2, pw2, seq2_len))
+		>= min_match ) {
+
+		score[s] = match_length;
+		x[s] = pw1+1;
+		y[s] = pw2+1;
+		if ( s < best ) best = s;
+		continue;
+	    }
+	    cs->diag_serial[diag_pos] = cs->serial;
+	    cs->diag_seq[diag_pos] = s;
+	    cs->diag_end[diag_pos] = pw2 + match_length;
+	}
     }
 
+    return best;
+}
+
+Cont_index *cont_index_from_files ( char *vector_seq, int max_vector,
+				    FILE *fp_s, char *fofn_s, int mode_v ) {
+
+/*	read all the sequences to screen against and index them */
+
+    Cont_index *ci;
+    char *vfile_name;
+    int num_vfiles, vfile_num, vector_length, ret;
+    FILE *vf;
+
     if ( mode_v ) {
 	if (( num_vfiles = get_vfilenames ( fp_s, fofn_s )) < 1 )
-	    return -1;
+	    return NULL;
     }
     else {
 	num_vfiles = 1;
     }
 
-    /* for each vector sequence */
+    if ( NULL == (ci = cont_index_create ()))
+	return NULL;
 
     for ( vfile_num = 0; (vfile_num < num_vfiles) && 
 	 (vfile_name=vfile_names[vfile_num]); vfile_num++ ) {
 
-      if ( tmode ) {
-	printf(">>>>>>>>>>>>>>>>>>>>>>>>>>> %s\n", vfile_names[vfile_num]);
-      }
-
-      if ( !(vf = fopen(vfile_names[vfile_num], "r"))) {
+      if ( !(vf = fopen(vfile_name, "r"))) {
 	fprintf(stderr, "Error: could not open sequence file %s\n", vfile_name);
 	continue;
       }
@@ -636,16 +755,65 @@ int do_it_con ( char *vector_seq, int max_vector,
 	continue;
       }
 
-      if ( hash_seq8 ( vector_seq, hash_values1, vector_length ) != 0 ) {
-	fprintf(stderr, "Error: could not hash sequence file %s\n", vfile_name);
-	continue;
+      if ( cont_index_add ( ci, vfile_name, vector_seq, vector_length )) {
+	cont_index_destroy ( ci );
+	return NULL;
       }
-      (void) store_hash ( hash_values1, vector_length, last_word, word_count,
-			   word_length, size_hash );
+    }
 
-      /* for all the readings that are left */
+    if ( cont_index_build ( ci )) {
+	cont_index_destroy ( ci );
+	return NULL;
+    }
+
+    return ci;
+}
 
-      for ( file_num = 0; file_num < num_files; file_num++ ) {
+int do_it_con ( Cont_index *ci,
+	       FILE *fp_i, FILE *fp_p, FILE *fp_f,
+	       int min_match, int percent_cut,
+	       int tmode, int mode_i) {
+
+    char *seq, *expt_file_name;
+
+    Exp_info *e;
+    int ql,qr,seq_length,i;
+
+/* for this algorithm */
+
+    Cont_scratch cs;
+    int *xf, *yf, *score_f, *xr, *yr, *score_r;
+    int best_f, best_r, eret;
+    int num_files, file_num;
+    int sl, sr; /* sequencing vector left and right */
+    int lg, rg, s;
+    int match_found;
+
+    if ( min_match < 8 ) min_match = 8;
+
+    memset ( &cs, 0, sizeof(cs) );
+    i = MAX ( ci->nseqs, 1 );
+    if ( ! (xf = (int *) xmalloc ( sizeof(int)*6*i )))
+	return -1;
+    yf = xf + i;
+    score_f = yf + i;
+    xr = score_f + i;
+    yr = xr + i;
+    score_r = yr + i;
+
+    if ( mode_i ) {
+	if (( num_files = get_filenames ( fp_i )) < 1 ) {
+	    xfree ( xf );
+	    return -1;
+	}
+    }
+    else {
+	num_files = 1;
+    }
+
+    /* each reading is screened against the whole library in one go */
+
+    for ( file_num = 0; file_num < num_files; file_num++ ) {
 
 	if ( expt_file_name=file_names[file_num]) {
 
@@ -697,13 +865,15 @@ int do_it_con ( char *vector_seq, int max_vector,
 		sr = atoi ( expline );
 	      }
 
-	      /* we have to search both strands so we call do_hash
-		 with the read in its original sense, then its
-		 complement.
+	      /* we have to search both strands so we screen the
+		 read in its original sense, then its complement.
+		 The library sequences are tried in order and a
+		 forward match beats a reverse one against the same
+		 sequence, so the complement is only searched for
+		 sequences before the first forward hit.
 	      */
 
 	      match_found = 0;
-	      score_f = score_r = 0;
 	      lg = MAX ( ql, sl ) - 1;
 	      lg = MAX ( lg, 0 );
 	      rg = MIN ( qr, sr ) - 1;
@@ -716,96 +886,82 @@ int do_it_con ( char *vector_seq, int max_vector,
 		file_names[file_num] = NULL;
 		continue;
 	      }
-	      ret = do_hash_con ( vector_length, rg-lg+1,
-				 hash_values1, last_word,
-				 word_count, hash_values2, diag, line,
-				 vector_seq, &seq[lg], new_vector,
-				 min_match, half_window,
-				 &x, &y, &score);
-	      if ( ret < 0 ) {
+	      best_f = cont_index_screen ( ci, &cs, &seq[lg], rg-lg+1,
+					   min_match, ci->nseqs, !tmode,
+					   xf, yf, score_f );
+	      if ( best_f < 0 ) {
 		eret =  vep_error ( fp_f, expt_file_name, 5 );
 		exp_destroy_info ( e );
 		file_names[file_num] = NULL;
 		continue;
 	      }
 
-	      if ( ret ) {
-		if ( score >= percent_cut ) {
-		  xf = x;
-		  yf = y + lg;
-		  score_f = score;
-		  match_found = 1;
-		  /* printf("forward score %d at %d %d\n",score_f,xf,yf); */
-		  if ( !tmode ) {
-		    char mess[2048]; /* twice vfile_name ! */
-
-		    if (exp_put_str(e, EFLT_PS, "contaminated", 
-					  strlen("contaminated"))) {
-		      eret =  vep_error ( fp_f, expt_file_name, 4 );
-		      exp_destroy_info ( e );
-		      file_names[file_num] = NULL;
-		      continue;
-		    }
-		    sprintf(mess, "CONT = %d..%d\n%d %d %s",
-			    yf,yf+score-1,xf,score,vfile_name);
-		    exp_put_str(e, EFLT_TG, mess, strlen(mess));
-
-		    if ( fp_f ) fprintf ( fp_f, "%s\n",expt_file_name);
-		    file_names[file_num] = NULL;
-		  }
-		  else {
-		    printf("match %d at %d  %d\n",score,xf,yf);
-		  }
-		}
-	      }
-
-	      if ( !match_found ) {
+	      best_r = ci->nseqs;
+	      if ( tmode || best_f > 0 ) {
 
 		complement_seq ( &seq[lg], rg-lg+1);
 
-		ret = do_hash_con ( vector_length, rg-lg+1,
-				hash_values1, last_word,
-			        word_count, hash_values2, diag, line,
-			        vector_seq, &seq[lg], new_vector,
-			        min_match, half_window,
-			        &x, &y, &score);
-		if ( ret < 0 ) {
+		best_r = cont_index_screen ( ci, &cs, &seq[lg], rg-lg+1,
+					     min_match, tmode ? ci->nseqs : best_f,
+					     !tmode, xr, yr, score_r );
+		if ( best_r < 0 ) {
 		  eret =  vep_error ( fp_f, expt_file_name, 5 );
 		  exp_destroy_info ( e );
 		  file_names[file_num] = NULL;
 		  continue;
 		}
-		if ( ret ) {
-		  if ( score >= percent_cut ) {
-		    xr = x;
-		    yr = rg - lg - y + lg - score + 3;
-		    score_r = score;
+	      }
+
+	      if ( tmode ) {
+		for ( s = 0; s < ci->nseqs; s++ ) {
+		  if ( score_f[s] && score_f[s] >= percent_cut ) {
+		    printf("match %d at %d  %d  %s\n",
+			   score_f[s], xf[s], yf[s] + lg, ci->names[s]);
 		    match_found = 1;
-		    /*  printf("reverse score %d at %d %d\n",score,xr,yr); */
-
-		    if ( !tmode ) {
-		    char mess[2048]; /* twice vfile_name ! */
-
-		      if (exp_put_str(e, EFLT_PS, "contaminated", 
-				      strlen("contaminated"))) {
-			eret =  vep_error ( fp_f, expt_file_name, 4 );
-			exp_destroy_info ( e );
-			file_names[file_num] = NULL;
-			continue;
-		      }
-		      sprintf(mess, "CONT = %d..%d\n%d %d %s",
-			      yr,yr+score-1,xr,score,vfile_name);
-		      exp_put_str(e, EFLT_TG, mess, strlen(mess));
-
-		      if ( fp_f ) fprintf ( fp_f, "%s\n",expt_file_name);
-		      file_names[file_num] = NULL;
-		    }
-		    else {
-		      printf("---match %d at %d  %d\n",score,xr,yr);
-		    }
 		  }
+		  else if ( score_r[s] && score_r[s] >= percent_cut ) {
+		    printf("---match %d at %d  %d  %s\n",
+			   score_r[s], xr[s],
+			   rg - lg - yr[s] + lg - score_r[s] + 3,
+			   ci->names[s]);
+		    match_found = 1;
+		  }
+		}
+	      }
+	      else {
+		char mess[2048]; /* twice vfile_name ! */
+		int x = 0, y = 0, score = 0;
+
+		if ( best_r < best_f && score_r[best_r] >= percent_cut ) {
+		  s = best_r;
+		  x = xr[s];
+		  y = rg - lg - yr[s] + lg - score_r[s] + 3;
+		  score = score_r[s];
 		  match_found = 1;
 		}
+		else if ( best_f < ci->nseqs && score_f[best_f] >= percent_cut ) {
+		  s = best_f;
+		  x = xf[s];
+		  y = yf[s] + lg;
+		  score = score_f[s];
+		  match_found = 1;
+		}
+
+		if ( match_found ) {
+		  if (exp_put_str(e, EFLT_PS, "contaminated", 
+				  strlen("contaminated"))) {
+		    eret =  vep_error ( fp_f, expt_file_name, 4 );
+		    exp_destroy_info ( e );
+		    file_names[file_num] = NULL;
+		    continue;
+		  }
+		  sprintf(mess, "CONT = %d..%d\n%d %d %.1024s",
+			  y,y+score-1,x,score,ci->names[s]);
+		  exp_put_str(e, EFLT_TG, mess, strlen(mess));
+
+		  if ( fp_f ) fprintf ( fp_f, "%s\n",expt_file_name);
+		  file_names[file_num] = NULL;
+		}
 	      }
 	      if ( tmode && !match_found ) printf("no match\n");
 	    }
@@ -813,9 +969,7 @@ int do_it_con ( char *vector_seq, int max_vector,
 	  exp_destroy_info ( e );
 	  if (!(tmode)) (void) write_dot();
 	}
-      }
     }
-      /*fprintf ( fp_p, "%s\n",expt_file_name); */
 
       /* screening finished so write out those that have not failed */
 
@@ -825,9 +979,8 @@ int do_it_con ( char *vector_seq, int max_vector,
       }
     }
 
-    free_hash8 ( hash_values1, last_word,
-	         word_count, hash_values2,
-	         diag );
+    cont_scratch_free ( &cs );
+    xfree ( xf );
     return 0;
 }
 
@@ -885,6 +1038,7 @@ void usage(int min_match ) {
 	    "    [-l minimum match (%d)]           [-m Max sequence length (%d)]\n"
 	    "    [-i readings to screen fofn]      [-I reading to screen]\n"
 	    "    [-s seqs to screen against fofn]  [-S seq to screen against]\n"
+	    "    [-r read index of seqs]           [-w write index of seqs]\n"
 	    "    [-t test only]\n"
 	    "    [-p passed fofn]                  [-f failed fofn]\n",
 	     min_match, MAX_VECTOR_D);
@@ -897,9 +1051,10 @@ int main(int argc, char **argv) {
     int c;
     int min_match, max_vector, min_match_d, percent_cut;
     int mode_v, mode_i,i,tmode,mr_s,mr_fofn, mv_s,mv_fofn;
-    int window_size;
     char *fofn_p, *fofn_f, *fofn_i, *fofn_s = NULL, *vector_seq;
+    char *index_r = NULL, *index_w = NULL;
     FILE *fp_p, *fp_f, *fp_i, *fp_s = NULL;
+    Cont_index *ci;
 
     fofn_p = fofn_f = fofn_i = NULL;
     fp_p = fp_f = fp_i = NULL;
@@ -908,12 +1063,11 @@ int main(int argc, char **argv) {
     min_match_d = 25;
     min_match = -1;
     percent_cut = -1;
-    window_size = -1;
     mode_v = mode_i = -1;
     tmode = 0;
     mr_s = mr_fofn = mv_s = mv_fofn = 0;
 
-    while ((c = getopt(argc, argv, "l:m:i:I:p:f:s:S:t")) != -1) {
+    while ((c = getopt(argc, argv, "l:m:i:I:p:f:s:S:tr:w:")) != -1) {
 	switch (c) {
 	case 'l':
 	    min_match = atoi(optarg);
@@ -946,6 +1100,12 @@ int main(int argc, char **argv) {
 	case 'f':	/* fails file fofn */
 	    fofn_f = optarg;
 	    break;
+	case 'r':	/* index of sequences to screen against */
+	    index_r = optarg;
+	    break;
+	case 'w':	/* save index of sequences to screen against */
+	    index_w = optarg;
+	    break;
 	default:
 	    usage( min_match_d);
 	}
@@ -954,6 +1114,7 @@ int main(int argc, char **argv) {
     if ( optind < 2 ) usage( min_match_d );
     if ( mr_s && mr_fofn ) usage( min_match_d );
     if ( mv_s && mv_fofn ) usage( min_match_d);
+    if ( index_r && (mv_s || mv_fofn) ) usage( min_match_d);
     if ( min_match < 0 ) min_match = min_match_d;
     if ( max_vector < MIN_VECTOR ) max_vector = MIN_VECTOR;
 
@@ -1010,19 +1171,46 @@ int main(int argc, char **argv) {
 	}
     }
     set_dna_lookup();
+    set_hash8_lookup();
     set_char_set(1); /* FIXME DNA*/
 
-    if ( ! (vector_seq = (char *) xmalloc ( sizeof(char)*max_vector ))) return -1;
+    if ( index_r ) {
+	if ( NULL == (ci = cont_index_read ( index_r ))) {
+	    fprintf(stderr, "Failed to read index %s\n", index_r);
+	    return -1;
+	}
+    }
+    else {
+	if ( mode_v == -1 ) usage( min_match_d );
+	if ( ! (vector_seq = (char *) xmalloc ( sizeof(char)*max_vector ))) return -1;
+	ci = cont_index_from_files ( vector_seq, max_vector, fp_s, fofn_s, mode_v );
+	xfree ( vector_seq );
+	if ( NULL == ci ) {
+	    fprintf(stderr, "Failed to index sequences to screen against\n");
+	    return -1;
+	}
+    }
+
+    if ( index_w ) {
+	if ( cont_index_write ( ci, index_w )) {
+	    fprintf(stderr, "Failed to write index %s\n", index_w);
+	    return -1;
+	}
+	/* building the index may be all that was asked for */
+	if ( mode_i == -1 ) {
+	    cont_index_destroy ( ci );
+	    exit(0);
+	}
+    }
 
-    if ( (mode_v == -1) || (mode_i == -1) ) usage( min_match_d );
+    if ( mode_i == -1 ) usage( min_match_d );
 
     percent_cut = min_match;
-    window_size = 7; 
 
-    i = do_it_con ( vector_seq, max_vector, fp_s, fp_i, fp_p, fp_f, 8, min_match,
-		   percent_cut, window_size, tmode, mode_v, fofn_s, mode_i );
+    i = do_it_con ( ci, fp_i, fp_p, fp_f, min_match,
+		   percent_cut, tmode, mode_i );
 
     fprintf(stdout,"\n");
-    xfree ( vector_seq );
+    cont_index_destroy ( ci );
     exit(0);
 }
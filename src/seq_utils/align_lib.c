@@ -140,8 +140,11 @@ void init_W128(int **matrix,
 extern int W128[128][128];
 #endif
 
-void destroy_malign_counts(int **matrix, int length, int depth,
-			   int *orig_matrix, int orig_length);
+/* Largest column depth for which the reciprocal in scale_malign_scores
+ * is exact: 128*t*t < 2^32 */
+#define MALIGN_RECIP_MAX_DEPTH 5792
+
+void destroy_malign_counts(int **matrix);
 void scale_malign_scores(MALIGN *malign, int start, int end);
 
 /*
@@ -318,6 +321,9 @@ MALIGN *create_malign(void) {
     malign->orig_pos = NULL;
     malign->counts = NULL;
     malign->scores = NULL;
+    malign->counts_block = NULL;
+    malign->scores_block = NULL;
+    malign->alloc_length = 0;
     malign->matrix = NULL;
     malign->charset_size = 6; /*  a,c,g,t,*,n */
     malign->region = NULL;
@@ -327,20 +333,9 @@ MALIGN *create_malign(void) {
 
 void free_malign (MALIGN *malign) {
   if ( malign ) {
-    if ( malign->counts ) destroy_malign_counts( malign->counts,
-						 malign->length,
-						 malign->charset_size,
-						 malign->orig_counts,
-						 malign->orig_length);
-    if ( malign->scores ) destroy_malign_counts( malign->scores,
-						 malign->length,
-						 malign->charset_size,
-						 malign->orig_scores,
-						 malign->orig_length);
-    if ( malign->matrix ) destroy_malign_counts( malign->matrix,
-						 malign->charset_size,
-						 malign->charset_size,
-						 NULL, 0);
+    if ( malign->counts ) destroy_malign_counts( malign->counts );
+    if ( malign->scores ) destroy_malign_counts( malign->scores );
+    if ( malign->matrix ) destroy_malign_counts( malign->matrix );
     if (malign->consensus) xfree(malign->consensus);
     if (malign->orig_pos) xfree(malign->orig_pos);
     if (malign->charset) xfree(malign->charset);
@@ -350,6 +345,9 @@ void free_malign (MALIGN *malign) {
   malign->orig_pos = NULL;
   malign->counts = NULL;
   malign->scores = NULL;
+  malign->counts_block = NULL;
+  malign->scores_block = NULL;
+  malign->alloc_length = 0;
 }
 
 void destroy_malign (MALIGN *malign, int contig_links_too) {
@@ -413,39 +411,17 @@ void malign_add_region(MALIGN *malign, int start, int end) {
 }
 
 /*
- * WARNING: This is deeply horrid code and also technically illegal C due
- * to pointer arithmetic outside of the bounds of an array of single allocated
- * object. However practically speaking it'll work OK.
- *
- * The original malign->scores and malign->counts matrices are allocated as
- * an array of rows (int **) and a single array of int * to which all columns
- * are addresses within. This reduces malloc overhead dramatically and probably
- * increases cache hit rates.
- *
- * However for speed we then subsequently insert additional rows and allocate
- * their own private blocks of memory (see malign_insert_scores).
- * Consequently when deallocating some matrix[i]'s will be to malloced
- * blocks but most will be just pointers into various locations within
- * the original single large block. We use orig/orig_length to point to the
- * original single block (incase matrix[0] was inserted to).
+ * The malign->counts and malign->scores matrices are an array of rows
+ * (int **), one per consensus column, all of which point into a single
+ * contiguous block of charset_size ints per column. Row i is always at
+ * block + i*charset_size, so matrix[0] is the block itself.
  *
- * The nasties come from how to distinguish one type of matrix[i] from another.
- * My cheat here is simply to see if it is in the range of the original block.
- * If not then it's obviously been allocated later, so free it.
+ * Keeping the block contiguous (rather than allocating inserted columns
+ * separately) keeps the alignment inner loops, which walk along the
+ * columns, streaming through memory.
  */
-void destroy_malign_counts(int **matrix, int length, int depth,
-			   int *orig, int orig_length) {
-    int i;
-    if (orig) {
-	for (i = 0; i < length; i++) {
-	    if (matrix[i] < orig ||
-		matrix[i] > &orig[orig_length * depth])
-		free(matrix[i]);
-	}
-	free(orig);
-    } else {
-	free(matrix[0]);
-    }
+void destroy_malign_counts(int **matrix) {
+    free(matrix[0]);
     free(matrix);
 }
 
@@ -454,20 +430,49 @@ int **create_malign_counts(int length, int depth) {
   int **counts;
   int i;
 
-  counts = (int **)calloc(length,sizeof(int *));
-  counts[0] = (int *)calloc(depth * length, sizeof(int));
+  counts = (int **)calloc(length ? length : 1,sizeof(int *));
+  counts[0] = (int *)calloc(depth * (length ? length : 1), sizeof(int));
   for(i=1;i<length;i++) {
       counts[i] = counts[0] + depth*i;
   }
   return counts;
 }
 
+/*
+ * Inserts 'size' zeroed columns at 'pos' in a matrix created by
+ * create_malign_counts(). 'length' is the current number of columns and
+ * 'alloc' the number allocated, which is grown to 'new_alloc' if larger.
+ *
+ * Returns the (possibly moved) matrix.
+ */
+static int **malign_counts_insert(int **matrix, int length, int alloc,
+				  int new_alloc, int depth,
+				  int pos, int size) {
+    int *block = matrix[0];
+    int i;
+
+    if (new_alloc > alloc) {
+	block  = (int *)realloc(block,
+				(size_t)new_alloc * depth * sizeof(int));
+	matrix = (int **)realloc(matrix, (size_t)new_alloc * sizeof(int *));
+    }
+
+    memmove(&block[(pos+size)*depth], &block[pos*depth],
+	    (size_t)(length - pos) * depth * sizeof(int));
+    memset(&block[pos*depth], 0, (size_t)size * depth * sizeof(int));
+
+    for (i = 0; i < length + size; i++)
+	matrix[i] = block + i*depth;
+
+    return matrix;
+}
+
 /*
  * Inserts size columns into the malign->score array at position pos.
  * The columns are initialised to zeros.
  */
 void malign_insert_scores(MALIGN *malign, int pos, int size) {
-    int i;
+    int i, alloc;
 
     /* -ve size indicates a deletion. Can it ever occur? */
 
@@ -478,31 +483,30 @@ void malign_insert_scores(MALIGN *malign, int pos, int size) {
 	pos = malign->length-1;
     }
 
-    /* Shuffle along counts */
-    malign->counts = (int **)realloc(malign->counts,
-				     (malign->length+size) * sizeof(int *));
-    memmove(&malign->counts[pos+size], &malign->counts[pos],
-	    sizeof(malign->counts[0]) * (malign->length - pos));
-    for (i = pos; i < pos + size; i++) {
-	malign->counts[i] = (int *)calloc(malign->charset_size, sizeof(int));
-    }
+    /* Grow geometrically so repeated single column inserts amortise */
+    alloc = malign->alloc_length;
+    if (malign->length + size > alloc) {
+	alloc = MAX(malign->length + size, alloc + alloc/2);
 
-    /* Shuffle along scores */
-    malign->scores = (int **)realloc(malign->scores,
-				     (malign->length+size) * sizeof(int *));
-    memmove(&malign->scores[pos+size], &malign->scores[pos],
-	    sizeof(malign->scores[0]) * (malign->length - pos));
-    for (i = pos; i < pos + size; i++) {
-	malign->scores[i] = (int *)calloc(malign->charset_size, sizeof(int));
+	malign->consensus = (char *)realloc(malign->consensus, alloc);
+	malign->orig_pos = (int *)realloc(malign->orig_pos,
+					  sizeof(int) * alloc);
     }
 
+    /* Shuffle along counts and scores */
+    malign->counts = malign_counts_insert(malign->counts, malign->length,
+					  malign->alloc_length, alloc,
+					  malign->charset_size, pos, size);
+    malign->scores = malign_counts_insert(malign->scores, malign->length,
+					  malign->alloc_length, alloc,
+					  malign->charset_size, pos, size);
+    malign->counts_block = malign->counts[0];
+    malign->scores_block = malign->scores[0];
+    malign->alloc_length = alloc;
+
     /* Shuffle along consensus */
-    malign->consensus = (char *)realloc(malign->consensus,
-					malign->length+size);
     memmove(&malign->consensus[pos+size], &malign->consensus[pos],
 	    malign->length - pos);
-    malign->orig_pos = (int *)realloc(malign->orig_pos,
-				      sizeof(int) * (malign->length+size));
     memmove(&malign->orig_pos[pos+size], &malign->orig_pos[pos],
 	    sizeof(int) * (malign->length - pos));
     for (i = pos; i < pos + size; i++) {
@@ -513,6 +517,26 @@ void malign_insert_scores(MALIGN *malign, int pos, int size) {
     malign->length += size;
 }
 
+/*
+ * Fills out columns pos..pos+size-1, as freshly created by
+ * malign_insert_scores(), for the case where 'depth' sequences span them
+ * and have all had pads inserted at this point.
+ * This is a cheap delta update, avoiding a call to malign_recalc_scores()
+ * with its walk of the contigl list.
+ */
+void malign_set_pad_columns(MALIGN *malign, int pos, int size, int depth) {
+    int i, pad = malign_lookup['*'];
+
+    if (size <= 0)
+	return;
+
+    for (i = pos; i < pos + size; i++)
+	malign->counts[i][pad] = depth;
+
+    get_malign_consensus(malign, pos, pos+size-1);
+    scale_malign_scores(malign, pos, pos+size-1);
+}
+
 /*
  * Removes 'del' from the contigl list. The previous contigl will be previous
  * or NULL if del is the first. (Knowing this info speeds up this function
@@ -723,25 +747,38 @@ void scale_malign_scores(MALIGN *malign, int start, int end) {
       }
   }
 #else
+  /*
+   * score = 128 - 128*count/depth.
+   *
+   * The per-element division is replaced by a multiply with a fixed
+   * point reciprocal of the column depth, computed once per column. With
+   * m = 2^32/t + 1 this gives exactly (x*m)>>32 == x/t for all x <= 128*t
+   * provided 128*t*t < 2^32, and leaves a loop the compiler can
+   * vectorise. Deeper columns fall back to plain division.
+   */
   for(i=start;i<=end;i++) {
-      int t = 0, max = 0, s;
+      int *c = malign->counts[i], *sc = malign->scores[i];
+      int cs = malign->charset_size, t = 0;
 
-      for (j = 0; j < malign->charset_size; j++) {
-	  t += malign->counts[i][j];
-	  if (max < malign->counts[i][j])
-	      max = malign->counts[i][j];
-      }
-      if (t) {
-	  for(j=0;j<malign->charset_size;j++) {
-	      malign->scores[i][j] = 128 - (malign->counts[i][j]<<7)/t;
-	  }
+      for (j = 0; j < cs; j++)
+	  t += c[j];
+
+      if (t && t <= MALIGN_RECIP_MAX_DEPTH) {
+	  uint64_t m = (UINT64_C(1) << 32) / t + 1;
+	  for (j = 0; j < cs; j++)
+	      sc[j] = 128 - (int)(((uint64_t)(c[j] << 7) * m) >> 32);
+
+	  /* Penalty for gaps is marginally higher */
+	  sc[5]++;
+      } else if (t) {
+	  for (j = 0; j < cs; j++)
+	      sc[j] = 128 - (c[j] << 7) / t;
 
 	  /* Penalty for gaps is marginally higher */
-	  malign->scores[i][5]++;
+	  sc[5]++;
       } else {
-	  for(j=0;j<malign->charset_size;j++) {
-	      malign->scores[i][j] = 0;
-	  }
+	  for (j = 0; j < cs; j++)
+	      sc[j] = 0;
       }
   }
 #endif
@@ -829,9 +866,9 @@ MALIGN *contigl_to_malign(CONTIGL *contigl_in, int gap_open, int gap_extend) {
 
   malign->counts = create_malign_counts(malign->length,malign->charset_size);
   malign->scores = create_malign_counts(malign->length,malign->charset_size);
-  malign->orig_counts = malign->counts[0];
-  malign->orig_scores = malign->scores[0];
-  malign->orig_length = malign->length;
+  malign->counts_block = malign->counts[0];
+  malign->scores_block = malign->scores[0];
+  malign->alloc_length = malign->length;
   get_malign_counts(malign, 0, malign->length-1);
   //print_malign_counts(malign);
 
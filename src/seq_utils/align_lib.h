@@ -44,11 +44,11 @@ typedef struct Malign {
     int nregion;
     char *consensus;
     int *orig_pos;
-    int **counts;
-    int **scores;
-    int *orig_counts;
-    int *orig_scores;
-    int orig_length;
+    int **counts;	/* counts[column][base], rows within counts_block */
+    int **scores;	/* scores[column][base], rows within scores_block */
+    int *counts_block;
+    int *scores_block;
+    int alloc_length;	/* columns allocated in counts/scores_block */
     int gap_open;
     int gap_extend;
 } MALIGN;
@@ -89,6 +89,8 @@ void set_malign_lookup (int charset_size);
 
 void malign_insert_scores(MALIGN *malign, int pos, int size);
 
+void malign_set_pad_columns(MALIGN *malign, int pos, int size, int depth);
+
 void malign_remove_contigl(MALIGN *malign, CONTIGL *previous, CONTIGL *del);
 
 void malign_add_contigl(MALIGN *malign, CONTIGL *previous, CONTIGL *add);
@@ -1,4 +1,6 @@
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include "search_utils.h"
 
 /*
@@ -63,7 +65,7 @@ char *pstrnstr(char *text, size_t text_len, char *query, size_t query_len) {
  *	A pointer to the first match in text when found.
  *	NULL when a match is not found.
  */
-char *pstrnstr_inexact(char *text, size_t text_len,
+static char *pstrnstr_inexact_simple(char *text, size_t text_len,
 		       char *query, size_t query_len,
 		       int mismatches, int *n_mis) {
     unsigned int t_ind = 0, q_ind;
@@ -120,7 +122,7 @@ char *pstrnstr_inexact(char *text, size_t text_len,
  *	A pointer to the first match in text when found.
  *	NULL when a match is not found.
  */
-char *prstrnstr_inexact(char *text, size_t text_len,
+static char *prstrnstr_inexact_simple(char *text, size_t text_len,
 			char *query, size_t query_len,
 			int mismatches, int *n_mis) {
     unsigned int t_ind = 0, q_ind;
@@ -212,7 +214,7 @@ char *pstrstr(char *text, char *pattern) {
  * will not introduce gaps to get a better match.
  * KFB: 22/11/01 added n_mis to return the number of mismatches found
  */
-char *pstrstr_inexact(char *text, char *pattern, int mismatches, int *n_mis) {
+static char *pstrstr_inexact_simple(char *text, char *pattern, int mismatches, int *n_mis) {
     char *text_p, *patt_p;
     int m;
 
@@ -268,7 +270,7 @@ char *pstrstr_inexact(char *text, char *pattern, int mismatches, int *n_mis) {
  * This searches from the end of the string rather than the start, so it
  * will return the last copy of pattern in text.
  */
-char *prstrstr_inexact(char *text, char *pattern, int mismatches, int *n_mis) {
+static char *prstrstr_inexact_simple(char *text, char *pattern, int mismatches, int *n_mis) {
     char *text_p, *patt_p;
     int m;
     char *match = NULL;
@@ -315,3 +317,556 @@ char *prstrstr_inexact(char *text, char *pattern, int mismatches, int *n_mis) {
     return match;
 }
 
+
+/* ---------------------------------------------------------------------
+ * Bit-parallel matching.
+ */
+
+/* The bases (A=1, C=2, G=4, T=8) represented by an IUB code, or 0 */
+static int iub_bases(int c) {
+    switch (toupper(c)) {
+    case 'A': return 1;
+    case 'C': return 2;
+    case 'G': return 4;
+    case 'T': case 'U': return 8;
+    case 'R': return 1|4;
+    case 'Y': return 2|8;
+    case 'M': return 1|2;
+    case 'K': return 4|8;
+    case 'S': return 2|4;
+    case 'W': return 1|8;
+    case 'B': return 2|4|8;
+    case 'D': return 1|4|8;
+    case 'H': return 1|2|8;
+    case 'V': return 1|2|4;
+    case 'N': return 1|2|4|8;
+    }
+    return 0;
+}
+
+/* Does text char 'tc' match query char 'qc'? */
+static int search_char_match(int flags, int qc, int tc) {
+    int tb;
+
+    if (qc == tc)
+	return 1;
+    if (!(flags & SEARCH_IUB))
+	return 0;
+    if (toupper(qc) == toupper(tc))
+	return 1;
+
+    /* Only a definite text base can match an ambiguity code */
+    tb = iub_bases(tc);
+    return (tb == 1 || tb == 2 || tb == 4 || tb == 8) && (iub_bases(qc) & tb);
+}
+
+void search_query_init(search_query *q, char *query, size_t len, int flags) {
+    size_t i;
+    int c;
+
+    q->query = query;
+    q->len = len;
+    q->flags = flags;
+    memset(q->mask, 0, 256 * sizeof(*q->mask));
+
+    if (len > SEARCH_WORD_LEN)
+	return;
+
+    for (i = 0; i < len; i++) {
+	if (flags & SEARCH_IUB) {
+	    for (c = 0; c < 256; c++)
+		if (search_char_match(flags, (unsigned char)query[i], c))
+		    q->mask[c] |= (uint64_t)1 << i;
+	} else {
+	    q->mask[(unsigned char)query[i]] |= (uint64_t)1 << i;
+	}
+    }
+
+    /* A pad in the query never matches */
+    q->mask['*'] = 0;
+}
+
+search_query *search_query_create(char *query, size_t len, int flags) {
+    search_query *q;
+
+    if (NULL == (q = (search_query *)malloc(sizeof(*q))))
+	return NULL;
+
+    search_query_init(q, query, len, flags);
+    return q;
+}
+
+void search_query_destroy(search_query *q) {
+    if (q)
+	free(q);
+}
+
+/*
+ * The running state of one query over a text. Characters are fed in one at
+ * a time by search_scan_step, which reports whether a match ends there.
+ */
+typedef struct {
+    search_query *q;
+    int k;			/* maximum errors */
+    uint64_t high;		/* bit of the final query char */
+    uint64_t R[SEARCH_WORD_LEN+1]; /* shift-and state per error level */
+    uint64_t Pv, Mv;		/* Myers vertical deltas */
+    int score;			/* Myers edit distance at the query end */
+    int *col;			/* DP column for long queries */
+    char *ring;			/* last query-length chars, long Hamming */
+    size_t nseen;		/* non pad chars seen */
+} search_scan;
+
+static int search_scan_init(search_scan *s, search_query *q, int max_err) {
+    size_t i;
+
+    s->q = q;
+    s->k = max_err < 0 ? 0 : max_err;
+    if ((size_t)s->k > q->len)
+	s->k = q->len;
+    s->col = NULL;
+    s->ring = NULL;
+    s->nseen = 0;
+
+    if (q->len <= SEARCH_WORD_LEN) {
+	s->high = q->len ? (uint64_t)1 << (q->len-1) : 0;
+	memset(s->R, 0, (s->k+1) * sizeof(*s->R));
+	s->Pv = ~(uint64_t)0;
+	s->Mv = 0;
+	s->score = q->len;
+	return 0;
+    }
+
+    if (q->flags & SEARCH_EDIT) {
+	if (NULL == (s->col = (int *)malloc((q->len+1) * sizeof(int))))
+	    return -1;
+	for (i = 0; i <= q->len; i++)
+	    s->col[i] = i;
+    } else {
+	if (NULL == (s->ring = (char *)malloc(q->len)))
+	    return -1;
+    }
+
+    return 0;
+}
+
+static void search_scan_free(search_scan *s) {
+    if (s->col)
+	free(s->col);
+    if (s->ring)
+	free(s->ring);
+}
+
+/*
+ * Feeds one non pad text character into the scan.
+ * Returns the number of errors of the best match ending here, or -1 if
+ * there is no match within s->k errors.
+ */
+static int search_scan_step(search_scan *s, unsigned char c) {
+    search_query *q = s->q;
+
+    s->nseen++;
+
+    if (q->len <= SEARCH_WORD_LEN) {
+	uint64_t B = q->mask[c];
+
+	if (q->flags & SEARCH_EDIT) {
+	    /* Myers 1999 */
+	    uint64_t Xv, Xh, Ph, Mh;
+
+	    Xv = B | s->Mv;
+	    Xh = (((B & s->Pv) + s->Pv) ^ s->Pv) | B;
+	    Ph = s->Mv | ~(Xh | s->Pv);
+	    Mh = s->Pv & Xh;
+	    if (Ph & s->high)
+		s->score++;
+	    else if (Mh & s->high)
+		s->score--;
+	    Ph <<= 1;
+	    Mh <<= 1;
+	    s->Pv = Mh | ~(Xv | Ph);
+	    s->Mv = Ph & Xv;
+
+	    return s->score <= s->k ? s->score : -1;
+	} else {
+	    /* Wu-Manber shift-and with substitutions only */
+	    uint64_t old = s->R[0], tmp, *R = s->R;
+	    int d;
+
+	    R[0] = ((old << 1) | 1) & B;
+	    for (d = 1; d <= s->k; d++) {
+		tmp = R[d];
+		R[d] = (((tmp << 1) | 1) & B) | ((old << 1) | 1);
+		old = tmp;
+	    }
+
+	    if (!(R[s->k] & s->high))
+		return -1;
+	    for (d = 0; !(R[d] & s->high); d++)
+		;
+	    return d;
+	}
+    }
+
+    if (q->flags & SEARCH_EDIT) {
+	int diag = 0, up = 0, i, v;
+	int *col = s->col;
+
+	for (i = 1; i <= (int)q->len; i++) {
+	    v = diag + !search_char_match(q->flags,
+					 (unsigned char)q->query[i-1], c);
+	    if (v > col[i] + 1)
+		v = col[i] + 1;
+	    if (v > up + 1)
+		v = up + 1;
+	    diag = col[i];
+	    col[i] = up = v;
+	}
+
+	return col[q->len] <= s->k ? col[q->len] : -1;
+    } else {
+	size_t i, len = q->len, p = s->nseen % len;
+	int m = 0;
+
+	s->ring[(s->nseen-1) % len] = c;
+	if (s->nseen < len)
+	    return -1;
+
+	/* ring[p] holds the oldest char, aligned to query[0] */
+	for (i = 0; i < len; i++) {
+	    if (!search_char_match(q->flags, (unsigned char)q->query[i],
+				   (unsigned char)s->ring[(p+i) % len]))
+		if (++m > s->k)
+		    return -1;
+	}
+
+	return m;
+    }
+}
+
+/*
+ * Given a match of q ending at text[end] with n_err errors, returns the
+ * offset of its first matched char. For mismatches this is just query
+ * length non pad chars back; with edit distance we run the alignment
+ * backwards and pick the shortest span achieving n_err.
+ */
+static size_t search_match_start(search_query *q, char *text, size_t end,
+				 int n_err) {
+    size_t i, n;
+
+    if (!(q->flags & SEARCH_EDIT)) {
+	for (n = 1, i = end; n < q->len; n++) {
+	    do
+		i--;
+	    while (text[i] == '*');
+	}
+	return i;
+    } else {
+	/*
+	 * col[j] is the edit distance between the last j query chars and the
+	 * text from i to end (excluding pads).
+	 */
+	int *col, j, diag, left, v, best = -1;
+	size_t best_i = end, len = q->len;
+
+	if (NULL == (col = (int *)malloc((len+1) * sizeof(int))))
+	    return end;
+	for (j = 0; j <= (int)len; j++)
+	    col[j] = j;
+
+	for (i = end + 1, n = 0; i-- > 0 && n < len + n_err;) {
+	    if (text[i] == '*')
+		continue;
+	    n++;
+	    diag = col[0];
+	    col[0] = left = n;
+	    for (j = 1; j <= (int)len; j++) {
+		v = diag + !search_char_match(q->flags,
+					     (unsigned char)q->query[len-j],
+					     (unsigned char)text[i]);
+		if (v > col[j] + 1)
+		    v = col[j] + 1;
+		if (v > left + 1)
+		    v = left + 1;
+		diag = col[j];
+		col[j] = left = v;
+	    }
+	    if (col[len] <= n_err) {
+		best = col[len];
+		best_i = i;
+		break;
+	    }
+	}
+
+	free(col);
+	return best >= 0 ? best_i : end;
+    }
+}
+
+/*
+ * Scans text for q, calling found() for every match end. Stops early when
+ * found() returns non zero. A text_len of SEARCH_NUL_TERM scans up to the
+ * first nul instead, saving a strlen on repeated searches of a long text.
+ */
+#define SEARCH_NUL_TERM ((size_t)-1)
+
+static int search_query_scan(search_query *q, char *text, size_t text_len,
+			     int max_err,
+			     int (*found)(void *cd, size_t end, int n_err),
+			     void *cd) {
+    search_scan s;
+    size_t i;
+    int e;
+
+    if (-1 == search_scan_init(&s, q, max_err))
+	return -1;
+
+    for (i = 0; i < text_len; i++) {
+	if (text[i] == '*')
+	    continue;
+	if (text_len == SEARCH_NUL_TERM && text[i] == 0)
+	    break;
+	if ((e = search_scan_step(&s, (unsigned char)text[i])) >= 0) {
+	    if (found(cd, i, e))
+		break;
+	}
+    }
+
+    search_scan_free(&s);
+    return 0;
+}
+
+typedef struct {
+    search_query *q;
+    char *text;
+    size_t start, end;
+    int n_err;
+    int found;
+    int last;		/* 1 => keep going to find the last match */
+} search_find_cd;
+
+static int search_find_cb(void *cd, size_t end, int n_err) {
+    search_find_cd *f = (search_find_cd *)cd;
+    size_t start = search_match_start(f->q, f->text, end, n_err);
+
+    if (!f->found || (f->last ? start >= f->start : start < f->start)) {
+	f->start = start;
+	f->end = end;
+	f->n_err = n_err;
+	f->found = 1;
+    }
+
+    /*
+     * Mismatch-only matches start in the same order as they end, so the
+     * first hit is the first match. With edit distance a later end may
+     * still start earlier, so we keep going.
+     */
+    return !f->last && !(f->q->flags & SEARCH_EDIT);
+}
+
+static char *search_query_find2(search_query *q, char *text, size_t text_len,
+				int max_err, int *n_err, char **end,
+				int last) {
+    search_find_cd f;
+
+    f.q = q;
+    f.text = text;
+    f.found = 0;
+    f.last = last;
+    f.start = f.end = 0;
+    f.n_err = 0;
+
+    if (-1 == search_query_scan(q, text, text_len, max_err,
+				search_find_cb, &f) || !f.found)
+	return NULL;
+
+    if (n_err)
+	*n_err = f.n_err;
+    if (end)
+	*end = &text[f.end];
+
+    return &text[f.start];
+}
+
+char *search_query_find(search_query *q, char *text, size_t text_len,
+			int max_err, int *n_err, char **end) {
+    return search_query_find2(q, text, text_len, max_err, n_err, end, 0);
+}
+
+char *search_query_rfind(search_query *q, char *text, size_t text_len,
+			 int max_err, int *n_err, char **end) {
+    return search_query_find2(q, text, text_len, max_err, n_err, end, 1);
+}
+
+int search_query_multi(search_query **q, int nq, char *text, size_t text_len,
+		       int *max_err, search_hit **hits) {
+    search_scan *s;
+    search_hit *h = NULL;
+    int nh = 0, ah = 0, i, e, err = 0;
+    size_t t;
+
+    *hits = NULL;
+    if (nq <= 0)
+	return 0;
+
+    if (NULL == (s = (search_scan *)malloc(nq * sizeof(*s))))
+	return -1;
+    for (i = 0; i < nq; i++) {
+	if (-1 == search_scan_init(&s[i], q[i], max_err[i])) {
+	    while (--i >= 0)
+		search_scan_free(&s[i]);
+	    free(s);
+	    return -1;
+	}
+    }
+
+    /* All queries advance together, so hits come out in end order */
+    for (t = 0; t < text_len && !err; t++) {
+	if (text[t] == '*')
+	    continue;
+	for (i = 0; i < nq; i++) {
+	    if ((e = search_scan_step(&s[i], (unsigned char)text[t])) < 0)
+		continue;
+
+	    if (nh >= ah) {
+		search_hit *tmp;
+		ah = ah ? ah * 2 : 16;
+		if (NULL == (tmp = (search_hit *)realloc(h, ah * sizeof(*h)))) {
+		    err = 1;
+		    break;
+		}
+		h = tmp;
+	    }
+	    h[nh].query = i;
+	    h[nh].start = search_match_start(q[i], text, t, e);
+	    h[nh].end = t;
+	    h[nh].n_err = e;
+	    nh++;
+	}
+    }
+
+    for (i = 0; i < nq; i++)
+	search_scan_free(&s[i]);
+    free(s);
+
+    if (err) {
+	if (h)
+	    free(h);
+	return -1;
+    }
+
+    *hits = h;
+    return nh;
+}
+
+
+/* ---------------------------------------------------------------------
+ * The pad-skipping inexact searches, on top of the bit-parallel matcher.
+ * Empty and over-long queries use the simple scans above, which also pin
+ * down the exact semantics for those edge cases.
+ */
+
+char *pstrnstr_inexact(char *text, size_t text_len,
+		       char *query, size_t query_len,
+		       int mismatches, int *n_mis) {
+    search_query q;
+    char *p;
+    int m;
+
+    if (query_len == 0 || query_len > SEARCH_WORD_LEN)
+	return pstrnstr_inexact_simple(text, text_len, query, query_len,
+				       mismatches, n_mis);
+
+    if (n_mis)
+	*n_mis = 0;
+
+    search_query_init(&q, query, query_len, 0);
+    if (NULL == (p = search_query_find(&q, text, text_len,
+				       mismatches < 0 ? 0 : mismatches,
+				       &m, NULL)))
+	return NULL;
+
+    if (n_mis)
+	*n_mis = m;
+
+    /* Any pads before the match also lead to it, and come first */
+    while (p > text && p[-1] == '*')
+	p--;
+
+    return p;
+}
+
+char *prstrnstr_inexact(char *text, size_t text_len,
+			char *query, size_t query_len,
+			int mismatches, int *n_mis) {
+    search_query q;
+    char *p;
+    int m;
+
+    if (query_len == 0 || query_len > SEARCH_WORD_LEN)
+	return prstrnstr_inexact_simple(text, text_len, query, query_len,
+					mismatches, n_mis);
+
+    if (n_mis)
+	*n_mis = 0;
+
+    search_query_init(&q, query, query_len, 0);
+    if (NULL == (p = search_query_rfind(&q, text, text_len,
+					mismatches < 0 ? 0 : mismatches,
+					&m, NULL)))
+	return NULL;
+
+    if (n_mis)
+	*n_mis = m;
+
+    return p;
+}
+
+/* A negative mismatch count means there is no limit */
+char *pstrstr_inexact(char *text, char *pattern, int mismatches, int *n_mis) {
+    search_query q;
+    size_t len = strlen(pattern);
+    char *p;
+    int m;
+
+    if (len == 0 || len > SEARCH_WORD_LEN)
+	return pstrstr_inexact_simple(text, pattern, mismatches, n_mis);
+
+    if (n_mis)
+	*n_mis = 0;
+
+    search_query_init(&q, pattern, len, 0);
+    if (NULL == (p = search_query_find(&q, text, SEARCH_NUL_TERM,
+				       mismatches < 0 ? (int)len : mismatches,
+				       &m, NULL)))
+	return NULL;
+
+    if (n_mis)
+	*n_mis = m;
+
+    return p;
+}
+
+char *prstrstr_inexact(char *text, char *pattern, int mismatches, int *n_mis) {
+    search_query q;
+    size_t len = strlen(pattern);
+    char *p;
+    int m;
+
+    if (len == 0 || len > SEARCH_WORD_LEN)
+	return prstrstr_inexact_simple(text, pattern, mismatches, n_mis);
+
+    if (n_mis)
+	*n_mis = 0;
+
+    search_query_init(&q, pattern, len, 0);
+    if (NULL == (p = search_query_rfind(&q, text, SEARCH_NUL_TERM,
+					mismatches < 0 ? (int)len : mismatches,
+					&m, NULL)))
+	return NULL;
+
+    if (n_mis)
+	*n_mis = m;
+
+    return p;
+}
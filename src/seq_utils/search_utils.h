@@ -1,6 +1,9 @@
 #ifndef _SEARCH_UTILS_H_
 #define _SEARCH_UTILS_H_
 
+#include <stddef.h>
+#include <inttypes.h>
+
 /*
  * An implementation of strstr that skips pads ('*'). Pads are only ignored;
  * they will not be introduced to get a better match (as this is not an
@@ -77,4 +80,80 @@ char *pstrstr_inexact(char *text, char *pattern, int mismatches, int *n_mis);
 /* As pstrstr_inexact, but finding the last occurance of pattern */
 char *prstrstr_inexact(char *text, char *pattern, int mismatches, int *n_mis);
 
+
+/*
+ * Compiled queries for the bit-parallel matcher.
+ *
+ * Queries of up to SEARCH_WORD_LEN characters are matched using one machine
+ * word per error level (Wu-Manber shift-and for mismatches, Myers' algorithm
+ * for edit distance), so a scan costs O(text_len * (k+1)) or O(text_len)
+ * respectively regardless of the query length. Longer queries fall back to
+ * a plain dynamic programming scan. Pads ('*') in the text are skipped in
+ * all modes.
+ *
+ * Flags:
+ *	SEARCH_IUB	IUB ambiguity codes in the query match any base they
+ *			represent, and case is ignored. Without this only
+ *			identical characters match.
+ *	SEARCH_EDIT	Count errors as edit distance (insertions and
+ *			deletions as well as substitutions) instead of
+ *			mismatches.
+ */
+#define SEARCH_IUB	1
+#define SEARCH_EDIT	2
+
+#define SEARCH_WORD_LEN	64
+
+typedef struct {
+    char *query;	/* NOT copied; must stay valid while in use */
+    size_t len;		/* query length */
+    int flags;		/* SEARCH_* bits */
+    uint64_t mask[256];	/* bit i set if the char matches query[i] */
+} search_query;
+
+typedef struct {
+    int query;		/* index into the query array */
+    size_t start;	/* offset of the first (non pad) matched char */
+    size_t end;		/* offset of the last matched char */
+    int n_err;		/* number of mismatches or edits */
+} search_hit;
+
+/*
+ * Initialises and compiles 'q' for searching for 'query'. 'q' may be on the
+ * stack; nothing is allocated.
+ */
+void search_query_init(search_query *q, char *query, size_t len, int flags);
+
+/* As search_query_init, but returns a malloced query (NULL on failure) */
+search_query *search_query_create(char *query, size_t len, int flags);
+void search_query_destroy(search_query *q);
+
+/*
+ * Finds the first (search_query_find) or last (search_query_rfind) match of
+ * q in text with at most max_err errors. "First" and "last" are in terms of
+ * the match start. With SEARCH_EDIT a match ending at a given point takes
+ * the fewest errors possible there, and then the shortest span.
+ *
+ * Returns a pointer to the first matched (non pad) char, filling out *n_err
+ * and *end (the last matched char) when non NULL.
+ *	   NULL when no match is found.
+ */
+char *search_query_find(search_query *q, char *text, size_t text_len,
+			int max_err, int *n_err, char **end);
+char *search_query_rfind(search_query *q, char *text, size_t text_len,
+			 int max_err, int *n_err, char **end);
+
+/*
+ * Searches text for all of the nq queries in a single pass, allowing at
+ * most max_err[i] errors for query i. One hit is reported for every
+ * position at which a query match ends, with the fewest errors for that
+ * end point. Hits are ordered by end position.
+ *
+ * Returns the number of hits, with *hits set to a malloced array (to be
+ * freed by the caller).
+ *	   -1 on failure.
+ */
+int search_query_multi(search_query **q, int nq, char *text, size_t text_len,
+		       int *max_err, search_hit **hits);
+
 #endif /* _SEARCH_UTILS_H_ */
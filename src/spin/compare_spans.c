@@ -18,6 +18,98 @@ void make_reverse ( int **seq2_match, int window_length,
 
 #define complement_base(base) (complementary_base[base])
 
+/*
+ * Where the compiler supports it we use its generic vector extension to
+ * handle SPAN_VEC scores at a time. This maps onto SSE2/NEON registers
+ * without needing any particular instruction set flags.
+ */
+#ifdef __GNUC__
+typedef int span_vec __attribute__ ((vector_size (16), aligned (4)));
+#  define SPAN_VEC 4
+#endif
+
+/*
+ * Computes one row of window scores:
+ *     next[c] = prev[c-1] - prof_t[c] + prof_l[c]
+ * for c in 0 to ncols-1. Returns 1 if any score is above min_scorem1.
+ */
+static int span_row(int *next, int *prev, int *prof_t, int *prof_l,
+		    int ncols, int min_scorem1) {
+    int c = 0, hit = 0;
+
+#ifdef SPAN_VEC
+    span_vec vthresh = {min_scorem1, min_scorem1, min_scorem1, min_scorem1};
+    span_vec vhit = {0, 0, 0, 0};
+
+    for (; c + SPAN_VEC <= ncols; c += SPAN_VEC) {
+	span_vec v = *(span_vec *)&prev[c-1]
+	    - *(span_vec *)&prof_t[c]
+	    + *(span_vec *)&prof_l[c];
+	*(span_vec *)&next[c] = v;
+	vhit |= v > vthresh;
+    }
+    hit = vhit[0] | vhit[1] | vhit[2] | vhit[3];
+#endif
+
+    for (; c < ncols; c++) {
+	next[c] = prev[c-1] - prof_t[c] + prof_l[c];
+	hit |= next[c] > min_scorem1;
+    }
+
+    return hit != 0;
+}
+
+/*
+ * Returns the highest column below 'c' whose score is above min_scorem1,
+ * or -1 if there is none.
+ */
+static int span_prev_hit(int *score, int c, int min_scorem1) {
+#ifdef SPAN_VEC
+    span_vec vthresh = {min_scorem1, min_scorem1, min_scorem1, min_scorem1};
+
+    /* Skip blocks with no hits */
+    while (c >= SPAN_VEC) {
+	span_vec m = *(span_vec *)&score[c-SPAN_VEC] > vthresh;
+	if (m[0] | m[1] | m[2] | m[3])
+	    break;
+	c -= SPAN_VEC;
+    }
+#endif
+
+    while (--c >= 0) {
+	if (score[c] > min_scorem1)
+	    return c;
+    }
+
+    return -1;
+}
+
+/*
+ * Grows the match arrays, doubling them each time so that very large
+ * numbers of matches cost linear rather than quadratic time to store.
+ */
+static int realloc_span_matches(int **seq1_match,
+				int **seq2_match,
+				int **match_score,
+				int *max_matches)
+{
+    int new_max = *max_matches > 500 ? *max_matches * 2 : 1000;
+    int *tmp;
+
+    if (NULL == (tmp = (int *)xrealloc(*seq1_match, new_max * sizeof(int))))
+	return -1;
+    *seq1_match = tmp;
+    if (NULL == (tmp = (int *)xrealloc(*seq2_match, new_max * sizeof(int))))
+	return -1;
+    *seq2_match = tmp;
+    if (NULL == (tmp = (int *)xrealloc(*match_score, new_max * sizeof(int))))
+	return -1;
+    *match_score = tmp;
+
+    *max_matches = new_max;
+    return 0;
+}
+
 int compare_spans (
 		    char *seq1in,	/* the vertical sequence */
 		    int seq1_len,	/* length seq1 */
@@ -95,14 +187,24 @@ int compare_spans (
 	over subsections of the two sequences. How?
 
 	Well its been done so the documentation above is now out of date.
+
+	The scores for a row only depend on the previous row, so each row is
+	now computed into a second buffer (score and next_score are swapped
+	after every row) rather than in place from right to left. Instead of
+	indexing score_matrix by seq2 for every cell we precompute a profile
+	of seq2 against each character: profile[c][column] =
+	score_matrix[c][seq2[column]]. The inner loop is then a plain
+	add/subtract over contiguous arrays which the compiler can vectorise,
+	and matches are picked out by a separate scan of the finished row.
 */
 
-    int column, trailing_column, leading_column;
+    int column;
     int row, trailing_row, leading_row;
     int i, *score, *long_score, min_scorem1;
-    int trailing_row_index, leading_row_index, *matrix_lrow, *matrix_trow;
+    int *next_score = NULL, *long_next_score, *swap;
+    int **profile = NULL, *long_profile = NULL, *prof_t, *prof_l;
+    int ncols, hit;
     int match_number = 0;
-    int temp_score;
     int **row_vectors, *left_edge, *long_left_edge;
     char *tmp_seq1,*seq1;
     char *tmp_seq2,*seq2;
@@ -110,7 +212,7 @@ int compare_spans (
     int tmp_seq2_len;
     int j,pseq1,pseq2,window,half_window;
 
-    long_score = long_left_edge = NULL;
+    long_score = long_left_edge = long_next_score = NULL;
     tmp_seq1 = tmp_seq2 = NULL;
     row_vectors = NULL;
 
@@ -141,6 +243,14 @@ int compare_spans (
     if ( ! ( long_score = (int *) xmalloc ( sizeof(int) * tmp_seq2_len))) {
 	goto bail_out;
     }
+    if ( ! ( long_next_score = (int *) xmalloc ( sizeof(int) * tmp_seq2_len))) {
+	goto bail_out;
+    }
+    if (NULL == (profile = (int **)xmalloc(char_set_size * sizeof(int *))))
+	goto bail_out;
+    if (NULL == (long_profile = (int *)xmalloc(sizeof(int) * char_set_size *
+					       tmp_seq2_len)))
+	goto bail_out;
     if (NULL == (long_left_edge = (int *) xmalloc ( sizeof(int) * tmp_seq1_len))) {
 	goto bail_out;
     }
@@ -152,6 +262,7 @@ int compare_spans (
     seq2 = &tmp_seq2[half_window+1];
 
     score = &long_score[half_window+1];
+    next_score = &long_next_score[half_window+1];
     left_edge = &long_left_edge[half_window+1];
 
     /*  fill in temp seqs */
@@ -187,6 +298,14 @@ int compare_spans (
     }
 
 
+    /*	Profile seq2 against each character */
+
+    for (i = 0; i < char_set_size; i++) {
+	profile[i] = &long_profile[i * tmp_seq2_len + half_window+1];
+	for (j = -half_window-1; j < tmp_seq2_len-half_window-1; j++)
+	    profile[i][j] = row_vectors[i][(int)seq2[j]];
+    }
+
     /*	Set the scores for the first row */
 
     for ( column = -1; column < seq2_rreg - seq2_lreg + 1; column++ ) {
@@ -210,6 +329,8 @@ int compare_spans (
 
     /* loop for each row */
 
+    ncols = seq2_rreg - seq2_lreg + 1;
+
     for ( row = 0, 
 	 trailing_row = row - half_window - 1,
 	 leading_row = row + half_window;
@@ -217,45 +338,42 @@ int compare_spans (
 	 row++, trailing_row++, leading_row++ ) {
 
 	score [ -1 ] = left_edge [ row - 1 ];
-	trailing_row_index = seq1 [ trailing_row]; 
-	leading_row_index = seq1 [leading_row]; 
-	matrix_trow = row_vectors [ trailing_row_index ];
-	matrix_lrow = row_vectors [ leading_row_index ]; 
+	prof_t = profile [ (int)seq1 [ trailing_row ] ] - half_window - 1;
+	prof_l = profile [ (int)seq1 [ leading_row ] ] + half_window;
 
-	/* loop right to left for each column */
+	hit = span_row(next_score, score, prof_t, prof_l, ncols, min_scorem1);
 
-	for ( column = seq2_rreg-seq2_lreg,
-	     trailing_column = column -half_window - 1,
-	     leading_column = column + half_window;
-	     column > -1; 
-	     column--, trailing_column--, leading_column-- ) {
+	swap = score;
+	score = next_score;
+	next_score = swap;
 
-	    temp_score =
-		score [ column-1 ]
-		- matrix_trow [seq2 [trailing_column]]
-	      	+ matrix_lrow [seq2 [leading_column]];
-	    if ( min_scorem1 < temp_score ) {
+	if ( !hit )
+	    continue;
 
-		if ( match_number == max_matches ) {
+	/* pick out the matches, right to left as they have always been */
 
-		    sip_realloc_matches(seq1_match, seq2_match,
-					match_score, &max_matches);
-		}
-
-		if ( ! ( same_seq && ( row == column ) ) ) {
-
-		    (*seq1_match) [ match_number ] = row + seq1_lreg - half_window;
-		    (*seq2_match) [ match_number ] = column + seq2_lreg - half_window;
-		    (*match_score) [ match_number ] = temp_score;
-		    match_number++;
-		}
+	for ( column = ncols;
+	      (column = span_prev_hit(score, column, min_scorem1)) > -1; ) {
+	    if ( same_seq && ( row == column ) )
+		continue;
 
+	    if ( match_number == max_matches ) {
+		if (-1 == realloc_span_matches(seq1_match, seq2_match,
+					       match_score, &max_matches))
+		    goto bail_out;
 	    }
-	    score [ column ] = temp_score;
+
+	    (*seq1_match) [ match_number ] = row + seq1_lreg - half_window;
+	    (*seq2_match) [ match_number ] = column + seq2_lreg - half_window;
+	    (*match_score) [ match_number ] = score [ column ];
+	    match_number++;
 	}
     }
 
     if (long_score) xfree (long_score);
+    if (long_next_score) xfree (long_next_score);
+    if (long_profile) xfree (long_profile);
+    if (profile) xfree (profile);
     if (tmp_seq1) xfree(tmp_seq1);
     if (tmp_seq2) xfree(tmp_seq2);
     if (row_vectors) xfree(row_vectors);
@@ -265,6 +383,9 @@ int compare_spans (
  bail_out:
 
     if (long_score) xfree (long_score);
+    if (long_next_score) xfree (long_next_score);
+    if (long_profile) xfree (long_profile);
+    if (profile) xfree (profile);
     if (tmp_seq1) xfree(tmp_seq1);
     if (tmp_seq2) xfree(tmp_seq2);
     if (row_vectors) xfree(row_vectors);
@@ -333,13 +333,29 @@ typedef struct NODE
 	  long  TOP;
 	  long  BOT;
 	  long  LEFT;
-	  long  RIGHT; }  vertex, *vertexptr;
+	  long  RIGHT;
+	  long  IDX;			/* index into LIST */
+	  struct NODE *HNEXT; }  vertex, *vertexptr;	/* hash chain */
 		
 static vertexptr  *LIST;			/* an array for saving k best scores */
 static vertexptr  low = 0;			/* lowest score node in LIST */
 static vertexptr  most = 0;			/* latestly accessed node in LIST */
 static long numnode;			/* the number of nodes in LIST */
 
+/* The K best list is searched by start point for every cell scoring above
+   min, and the lowest node is needed whenever one is replaced. Rather than
+   scanning LIST each time we keep the active nodes (LIST[0..numnode-1])
+   in a hash table keyed on start point, and a tournament tree over the
+   LIST slots whose root is the lowest scoring slot (the first such in LIST
+   order, as the original linear scan chose). Both are bounded by K.	*/
+static vertexptr *HASH;			/* hash of active nodes by start */
+static unsigned long hash_mask;		/* HASH size - 1 */
+static long *WIN;			/* tournament tree of LIST slots */
+static long tsize;			/* number of leaves in WIN */
+
+#define HASH_KEY(ci, cj) \
+	((((unsigned long)(ci)) * 2654435761UL + (unsigned long)(cj)) & hash_mask)
+
 static long *CC, *DD;			/* saving matrix scores */
 static long *RR, *SS, *EE, *FF; 	/* saving start-points */
 static long *HH, *WW;		 	/* saving matrix scores */
@@ -420,6 +436,83 @@ void init_sim_globals(void)
 
 }
 
+/* Return the active node in LIST starting at (ci, cj), or 0 */
+static vertexptr hash_find(long ci, long cj)
+{ vertexptr  cur;
+
+  for ( cur = HASH[HASH_KEY(ci, cj)]; cur; cur = cur->HNEXT )
+    if ( cur->STARI == ci && cur->STARJ == cj )
+      return cur;
+  return 0;
+}
+
+static void hash_add(vertexptr node)
+{ unsigned long  h = HASH_KEY(node->STARI, node->STARJ);
+
+  node->HNEXT = HASH[h];
+  HASH[h] = node;
+}
+
+static void hash_del(vertexptr node)
+{ vertexptr  *cur;
+
+  for ( cur = &HASH[HASH_KEY(node->STARI, node->STARJ)]; *cur;
+	cur = &(*cur)->HNEXT )
+    if ( *cur == node )
+      { *cur = node->HNEXT;
+	break;
+      }
+}
+
+/* The lower of two LIST slots; inactive slots (-1) lose, ties go to the
+   first slot */
+static long win_low(long a, long b)
+{
+  if ( a < 0 ) return b;
+  if ( b < 0 ) return a;
+  if ( LIST[b]->SCORE < LIST[a]->SCORE ||
+       LIST[b]->SCORE == LIST[a]->SCORE && b < a )
+    return b;
+  return a;
+}
+
+/* Refresh slot d of the tournament tree after its node or score changed */
+static void win_update(long d)
+{ long  k;
+
+  k = tsize + d;
+  WIN[k] = d < numnode ? d : -1;
+  for ( k >>= 1; k >= 1; k >>= 1 )
+    WIN[k] = win_low(WIN[2*k], WIN[2*k+1]);
+}
+
+/* Release everything SIM() allocated */
+static void sim_free(long M, long K)
+{ register long  i;
+  pairptr  next;
+
+	ckfree((char *)CC); ckfree((char *)DD);
+	ckfree((char *)RR); ckfree((char *)SS);
+	ckfree((char *)EE); ckfree((char *)FF);
+	ckfree((char *)HH); ckfree((char *)WW);
+	ckfree((char *)II); ckfree((char *)JJ);
+	ckfree((char *)XX); ckfree((char *)YY);
+
+	for ( i = 1; i <= M; i++ )
+	  for ( z = row[i]; z != 0; z = next )
+	    { next = z->NEXT;
+	      ckfree((char *)z);
+	    }
+	ckfree((char *)row);
+
+	for ( i = 0; i < K; i++ )
+	  ckfree((char *)LIST[i]);
+	ckfree((char *)LIST);
+	ckfree((char *)HASH);
+	ckfree((char *)WIN);
+	low = most = 0;
+}
+
 /* SIM(A,B,M,N,K,V,Q,R) reports K best non-intersecting alignments of
    the segments of A and B in order of similarity scores, where
    V[a][b] is the score of aligning a and b, and -(Q+R*i) is the score
@@ -489,7 +582,19 @@ long SIM(char *A,
 
 	LIST = ( vertexptr * ) ckalloc( K * sizeof(vertexptr));
 	for ( i = 0; i < K ; i++ )
-	   LIST[i] = ( vertexptr ) ckalloc( (long) sizeof(vertex));
+	  { LIST[i] = ( vertexptr ) ckalloc( (long) sizeof(vertex));
+	    LIST[i]->IDX = i;
+	  }
+
+	for ( tsize = 1; tsize < K; tsize <<= 1 )
+	  ;
+	WIN = ( long * ) ckalloc( 2 * tsize * sizeof(long));
+	for ( i = 0; i < 2 * tsize; i++ )
+	  WIN[i] = -1;
+	HASH = ( vertexptr * ) ckalloc( 2 * tsize * sizeof(vertexptr));
+	for ( i = 0; i < 2 * tsize; i++ )
+	  HASH[i] = 0;
+	hash_mask = 2 * tsize - 1;
 
 #if 0
 	printf("s {\n  \"%s\" 1 %d\n  \"%s\" 1 %d\n}\n", name1, M, name2, N);
@@ -507,14 +612,17 @@ long SIM(char *A,
 	  { if ( numnode == 0 ) {
 	      verror(ERR_WARN, "local alignment", 
 		     "The number of alignments computed is too large");
+	      sim_free(M, K);
 	      return -1;
 	  }
             cur = findmax();	/* Return a pointer to a node with max score*/
             score = cur->SCORE;
 	    
 	    /* if searching for all alignments above a certain score */
-	    if (score_align > -1 && (score/10.0) < score_align)
+	    if (score_align > -1 && (score/10.0) < score_align) {
+		sim_free(M, K);
 		return (K-count-1);
+	    }
 
       	    stari = ++cur->STARI;
             starj = ++cur->STARJ;
@@ -556,6 +664,7 @@ long SIM(char *A,
 		   small_pass(A,B,count,nseq);
               }
 	  }
+	sim_free(M, K);
 	return K;
 }
 
@@ -944,24 +1053,21 @@ int small_pass(A,B,count,nseq) char A[], B[]; long count, nseq;
 
 long addnode(c, ci, cj, i, j, K, cost)  long c, ci, cj, i, j, K, cost;
 { short found;				/* 1 if the node is in LIST */
-  register long d;
+  vertexptr  node;
 
   found = 0;
   if ( most != 0 && most->STARI == ci && most->STARJ == cj )
     found = 1;
-  else
-     for ( d = 0; d < numnode ; d++ )
-	{ most = LIST[d];
-	  if ( most->STARI == ci && most->STARJ == cj )
-	    { found = 1;
-	      break;
-	    }
-        }
+  else if ( ( node = hash_find(ci, cj) ) != 0 )
+    { most = node;
+      found = 1;
+    }
   if ( found )
     { if ( most->SCORE < c )
         { most->SCORE = c;
           most->ENDI = i;
           most->ENDJ = j;
+	  win_update(most->IDX);
         }
       if ( most->TOP > i ) most->TOP = i;
       if ( most->BOT < i ) most->BOT = i;
@@ -970,7 +1076,9 @@ long addnode(c, ci, cj, i, j, K, cost)  long c, ci, cj, i, j, K, cost;
     }
   else
     { if ( numnode == K )	/* list full */
-	 most = low;
+	{ most = low;
+	  hash_del(most);
+	}
       else
          most = LIST[numnode++];
       most->SCORE = c;
@@ -980,13 +1088,12 @@ long addnode(c, ci, cj, i, j, K, cost)  long c, ci, cj, i, j, K, cost;
       most->ENDJ = j;
       most->TOP = most->BOT = i;
       most->LEFT = most->RIGHT = j;
+      hash_add(most);
+      win_update(most->IDX);
     }
   if ( numnode == K )
     { if ( low == most || ! low ) 
-        { for ( low = LIST[0], d = 1; d < numnode ; d++ )
-            if ( LIST[d]->SCORE < low->SCORE )
-              low = LIST[d];
-	}
+        low = LIST[WIN[1]];
       return ( low->SCORE ) ;
     }
   else
@@ -1003,10 +1110,15 @@ vertexptr findmax(void)
     if ( LIST[i]->SCORE > LIST[j]->SCORE )
        j = i;
   cur = LIST[j];
+  hash_del(cur);
   if ( j != --numnode )
     { LIST[j] = LIST[numnode];
       LIST[numnode] =  cur;
+      LIST[j]->IDX = j;
+      cur->IDX = numnode;
+      win_update(j);
     }
+  win_update(numnode);
   most = LIST[0];
   if ( low == cur ) low = LIST[0];
   return ( cur );
@@ -34,6 +34,15 @@ static void extend_array (sheet_array *a, int r, int c);
 #define GET_ARRAY_CELL(A,R,C)\
     ( &A->base[(R * A->cols + C)*A->size] )
 
+/*
+ * True when two inks render identically; the colours only matter when the
+ * hilight says to use them.
+ */
+#define INK_EQUAL(A,B) \
+    ((A)->sh == (B)->sh && \
+     (!((A)->sh & sh_fg) || (A)->fg == (B)->fg) && \
+     (!((A)->sh & sh_bg) || (A)->bg == (B)->bg))
+
 /* ---- External functions ---- */
 
 /*
@@ -880,7 +889,7 @@ void XawSheetPutText(Sheet *sw, SheetColumn c, SheetRow r, Dimension l,
 ** Put plain text
 */
 {
-    int i;
+    int i, lo = -1, hi = -1;
     sheet_ink ink_base;
     sheet_paper paper_base;
     char *sp;
@@ -898,9 +907,19 @@ void XawSheetPutText(Sheet *sw, SheetColumn c, SheetRow r, Dimension l,
 	    paper_base = (sheet_paper) GET_ARRAY_CELL(sw->paper,r,c);
 	    i < l;
 	    i++, ink_base++, paper_base++, sp++) {
+	    if (ink_base->sh != sh_default || *paper_base != *sp) {
+		if (lo == -1) lo = i;
+		hi = i;
+	    }
 	    ink_base->sh = sh_default;
 	    *paper_base = *sp;
 	}
+
+	/* Only repaint the span that differs from what is already shown */
+	if (lo == -1)
+	    return;
+	c += lo; s += lo; l = hi-lo+1;
+
 	if (Tk_IsMapped(sw->tkwin)) {
 	    _repaint(sw, c, r, l, (sheet_ink) GET_ARRAY_CELL(sw->ink,r,c), s);
 
@@ -922,7 +941,7 @@ void XawSheetPutJazzyText(Sheet *sw, SheetColumn c, SheetRow r, Dimension l, cha
 ** Put multi-coloured text
 */
 {
-    int i;
+    int i, lo = -1, hi = -1;
     sheet_ink ink_base;
     sheet_paper paper_base;
     char *sp;
@@ -938,11 +957,21 @@ void XawSheetPutJazzyText(Sheet *sw, SheetColumn c, SheetRow r, Dimension l, cha
 	    paper_base = (sheet_paper) GET_ARRAY_CELL(sw->paper,r,c);
 	    i < l;
 	    i++, ink_base++, ink_list++, paper_base++, sp++) {
+	    if (!INK_EQUAL(ink_base, ink_list) || *paper_base != *sp) {
+		if (lo == -1) lo = i;
+		hi = i;
+	    }
 	    ink_base->fg = ink_list->fg;
 	    ink_base->bg = ink_list->bg;
 	    ink_base->sh = ink_list->sh;
 	    *paper_base = *sp;
 	}
+
+	/* Only repaint the span that differs from what is already shown */
+	if (lo == -1)
+	    return;
+	c += lo; l = hi-lo+1;
+
 	if (Tk_IsMapped(sw->tkwin)) {
 	    repaintText(sw, c, r, l);
 
@@ -964,10 +993,15 @@ void XawSheetPutHilightText(Sheet *sw, SheetColumn c, SheetRow r, Dimension l, c
 ** Put text using default hilights
 */
 {
-    int i;
+    int i, lo = -1, hi = -1;
     sheet_ink ink_base;
     sheet_paper paper_base;
     char *sp;
+    sheet_ink_struct def_ink;
+
+    def_ink.sh = sw->default_sh;
+    def_ink.fg = sw->default_fg;
+    def_ink.bg = sw->default_bg;
 
     if (r>=0 && r<sw->rows &&
 	c+l>0 && c<sw->columns &&
@@ -980,11 +1014,21 @@ void XawSheetPutHilightText(Sheet *sw, SheetColumn c, SheetRow r, Dimension l, c
 	    paper_base = (sheet_paper) GET_ARRAY_CELL(sw->paper,r,c);
 	    i < l;
 	    i++, ink_base++, paper_base++, sp++) {
+	    if (!INK_EQUAL(ink_base, &def_ink) || *paper_base != *sp) {
+		if (lo == -1) lo = i;
+		hi = i;
+	    }
 	    ink_base->sh = sw->default_sh;
 	    ink_base->fg = sw->default_fg;
 	    ink_base->bg = sw->default_bg;
 	    *paper_base = *sp;
 	}
+
+	/* Only repaint the span that differs from what is already shown */
+	if (lo == -1)
+	    return;
+	c += lo; s += lo; l = hi-lo+1;
+
 	if (Tk_IsMapped(sw->tkwin)) {
 	    _repaint(sw, c, r, l, (sheet_ink) GET_ARRAY_CELL(sw->ink,r,c), s);
 	    if (sw->display_cursor &&
@@ -1131,6 +1175,91 @@ void XawSheetPositionCursor(Sheet *sw, SheetColumn c, SheetRow r)
 	redrawCursor(sw,True);
 }
 
+/*
+ * Scrolls the whole sheet sideways by n columns, positive n moving the
+ * existing text to the right. The paper, ink and painted pixels are shifted
+ * together and the exposed columns left blank, so when the owner then puts
+ * its new text only the exposed columns (and any cells which really did
+ * change) get redrawn.
+ */
+void XawSheetScrollColumns(Sheet *sw, int n)
+{
+    int r, c, keep, src, dst, clr, an = n < 0 ? -n : n;
+    int cursor;
+
+    if (n == 0 || an >= sw->columns || sw->rows <= 0 ||
+	!sw->paper || !sw->ink)
+	return;
+
+    keep = sw->columns - an;
+    src  = n > 0 ? 0 : an;
+    dst  = n > 0 ? an : 0;
+    clr  = n > 0 ? 0 : keep;
+
+    /* The cursor's pixels belong to its cell, not to the scrolled text */
+    cursor = Tk_IsMapped(sw->tkwin) && sw->display_cursor;
+    if (cursor)
+	redrawCursor(sw, False);
+
+    for (r = 0; r < sw->rows; r++) {
+	sheet_paper paper_base = (sheet_paper) GET_ARRAY_CELL(sw->paper,r,0);
+	sheet_ink ink_base = (sheet_ink) GET_ARRAY_CELL(sw->ink,r,0);
+
+	memmove(paper_base + dst, paper_base + src, keep);
+	memmove(ink_base + dst, ink_base + src, keep * sizeof(*ink_base));
+
+	memset(paper_base + clr, ' ', an);
+	for (c = clr; c < clr + an; c++)
+	    ink_base[c].sh = sh_default;
+    }
+
+    if (!Tk_IsMapped(sw->tkwin))
+	return;
+
+    if (!sw->dbl_buffer ||
+	DisplayPlanes(sw->display,DefaultScreen(sw->display))==1) {
+	/* Nothing to copy from; monochrome paints straight to the window */
+	sheet_display(sw);
+    } else {
+	XGCValues values;
+	GC copygc, bg_gc;
+	int y = sw->border_width;
+	int h = FONT_HEIGHT(sw) * sw->rows;
+
+	if (!sw->window)
+	    sw->window = Tk_WindowId(sw->tkwin);
+
+	values.function = GXcopy;
+	values.graphics_exposures = False;
+	values.foreground = sw->foreground;
+	copygc = Tk_GetGC(sw->tkwin,
+			  GCFunction|GCGraphicsExposures|GCForeground,
+			  &values);
+	values.foreground = sw->background;
+	values.fill_style = FillSolid;
+	bg_gc = Tk_GetGC(sw->tkwin, GCForeground|GCFunction|GCFillStyle,
+			 &values);
+
+	XCopyArea(sw->display, sw->dbl_buffer, sw->dbl_buffer, copygc,
+		  (int) COL_TO_PIXEL(sw,src), y,
+		  FONT_WIDTH(sw) * keep, h,
+		  (int) COL_TO_PIXEL(sw,dst), y);
+	XFillRectangle(sw->display, sw->dbl_buffer, bg_gc,
+		       (int) COL_TO_PIXEL(sw,clr), y,
+		       FONT_WIDTH(sw) * an, h);
+	XCopyArea(sw->display, sw->dbl_buffer, sw->window, copygc,
+		  (int) COL_TO_PIXEL(sw,0), y,
+		  FONT_WIDTH(sw) * sw->columns, h,
+		  (int) COL_TO_PIXEL(sw,0), y);
+
+	Tk_FreeGC(sw->display, bg_gc);
+	Tk_FreeGC(sw->display, copygc);
+    }
+
+    if (cursor)
+	redrawCursor(sw, True);
+}
+
 void XawSheetDisplayCursor(Sheet *sw, Boolean b)
 {
     if (sw->display_cursor^b) {/*state change*/
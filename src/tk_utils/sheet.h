@@ -149,5 +149,6 @@ void XawSheetPutJazzyText(Sheet *sw, SheetColumn c, SheetRow r, Dimension l,
 void XawSheetDisplayCursor(Sheet *sw, Boolean b);
 void XawSheetPositionCursor(Sheet *sw, SheetColumn c, SheetRow r);
 void XawSheetOpHilightText(Sheet *sw, SheetColumn c, SheetRow r, Dimension l, SheetHilight h, int op);
+void XawSheetScrollColumns(Sheet *sw, int n);
 
 #endif /* _TK_SheetP_h */
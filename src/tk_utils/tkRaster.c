@@ -171,6 +171,15 @@ typedef struct Raster_t {
     int px0, py0, px1, py1;
     int knownarea;
 
+    /*
+     *  Area being replotted (eg the sliver exposed by scrolling) when
+     *  'damage' is set, otherwise the whole pixmap. Primitives lying
+     *  wholly outside it are not sent to the X server.
+     */
+
+    int damage;
+    int dx0, dy0, dx1, dy1;
+
     /*
      *  Private storage needed for each primitive
      */
@@ -466,6 +475,7 @@ RasterCmd(ClientData clientData, Tcl_Interp *interp, int argc, char **argv)
     RasterPtr->px1 = LOW;
     RasterPtr->py1 = LOW;
     RasterPtr->knownarea = 0;
+    RasterPtr->damage = 0;
     RasterPtr->initialised = 0;
     RasterPtr->wx_start = DBL_MAX/2;
     RasterPtr->wy_start = DBL_MAX/2;
@@ -2587,6 +2597,31 @@ void SetRasterModifiedArea (raster, rx0, ry0, rx1, ry1)
    if (ry1 > RasterPtr->py1) RasterPtr->py1 = ry1;
 }
 
+/*
+ *  Fetches the area of the pixmap that drawing may currently affect,
+ *  widened by the line width, for culling primitives.
+ */
+static void RasterDamageArea(Raster *RasterPtr,
+			     int *x0, int *y0, int *x1, int *y1)
+{
+   int lw = RasterPtr->currentDrawEnv->gcValues.line_width + 1;
+
+   if (RasterPtr->damage) {
+      *x0 = RasterPtr->dx0; *y0 = RasterPtr->dy0;
+      *x1 = RasterPtr->dx1; *y1 = RasterPtr->dy1;
+   } else {
+      *x0 = 0; *y0 = 0;
+      *x1 = RasterPtr->width-1; *y1 = RasterPtr->height-1;
+   }
+
+   *x0 -= lw; *y0 -= lw;
+   *x1 += lw; *y1 += lw;
+}
+
+/* True when bounding box a0-a1 lies wholly outside damage area d0-d1 */
+#define OUTSIDE_DAMAGE(ax0,ay0,ax1,ay1,dx0,dy0,dx1,dy1) \
+   ((ax1) < (dx0) || (ax0) > (dx1) || (ay1) < (dy0) || (ay0) > (dy1))
+
 /*======================================================================
  *
  *  The following are utility functions to access elements of a Tk_Raster.
@@ -2643,18 +2678,30 @@ void RasterDrawPoints (raster, coord, npts)
    XPoint *pt, *ptptr;
    int rx, ry;
    int minx = HIGH, miny = HIGH, maxx = LOW, maxy = LOW;
+   int dx0, dy0, dx1, dy1;
 
    if (npts < 1) return;
 
+   RasterDamageArea ((Raster *)raster, &dx0, &dy0, &dx1, &dy1);
+
    for (i = 0, ptptr = pt = (XPoint*) malloc (sizeof (XPoint)*npts);
-	i < n; i+=2, ptptr++) {
+	i < n; i+=2) {
       WorldToRaster (raster, coord [i], coord [i+1], &rx, &ry);
+      if (OUTSIDE_DAMAGE(rx, ry, rx, ry, dx0, dy0, dx1, dy1))
+	 continue;
       if (rx < minx) minx = rx;
       if (rx > maxx) maxx = rx;
       if (ry < miny) miny = ry;
       if (ry > maxy) maxy = ry;
       ptptr->x = rx;
       ptptr->y = ry;
+      ptptr++;
+   }
+
+   if ((npts = ptptr - pt) == 0) {
+      free (pt);
+      SetRasterModifiedArea (raster, 0, 0, 0, 0);
+      return;
    }
 
    if (pointwid >= 2) {
@@ -2718,6 +2765,7 @@ RasterDrawLine (Tk_Raster *raster,
 {
    int rx1, ry1, rx2, ry2;
    int minx = HIGH, miny = HIGH, maxx = LOW, maxy = LOW;
+   int dx0, dy0, dx1, dy1;
 
    WorldToRaster (raster, x1, y1, &rx1, &ry1);
    WorldToRaster (raster, x2, y2, &rx2, &ry2);
@@ -2737,6 +2785,12 @@ RasterDrawLine (Tk_Raster *raster,
    if (ry2 < miny) miny = ry2;
    if (ry2 > maxy) maxy = ry2;
 
+   RasterDamageArea ((Raster *)raster, &dx0, &dy0, &dx1, &dy1);
+   if (OUTSIDE_DAMAGE(minx, miny, maxx, maxy, dx0, dy0, dx1, dy1)) {
+      SetRasterModifiedArea (raster, 0, 0, 0, 0);
+      return;
+   }
+
    XDrawLine (GetRasterDisplay (raster),
 	      GetRasterDrawable (raster),
 	      GetRasterGC (raster),
@@ -2761,6 +2815,7 @@ void RasterDrawLines (raster, coord, npts)
    XPoint *pt, *ptptr;
    int rx, ry;
    int minx = HIGH, miny = HIGH, maxx = LOW, maxy = LOW;
+   int dx0, dy0, dx1, dy1;
 
    if (npts < 1) return;
 
@@ -2775,6 +2830,13 @@ void RasterDrawLines (raster, coord, npts)
       ptptr->y = ry;
    }
 
+   RasterDamageArea ((Raster *)raster, &dx0, &dy0, &dx1, &dy1);
+   if (OUTSIDE_DAMAGE(minx, miny, maxx, maxy, dx0, dy0, dx1, dy1)) {
+      free (pt);
+      SetRasterModifiedArea (raster, 0, 0, 0, 0);
+      return;
+   }
+
    /*
     * fix to deal with x servers which can't cope with more than 2^16 lines
     */
@@ -2823,13 +2885,20 @@ void RasterDrawSegments (Tk_Raster * raster,
    XSegment *seg, *segptr;
    int rx1, ry1, rx2, ry2;
    int minx = HIGH, miny = HIGH, maxx = LOW, maxy = LOW;
+   int dx0, dy0, dx1, dy1;
 
    if (nsegs < 1) return;
 
+   RasterDamageArea ((Raster *)raster, &dx0, &dy0, &dx1, &dy1);
+
    for (i = 0, segptr = seg = (XSegment*) malloc (sizeof (XSegment)*(nsegs));
-	i < n; i+=4, segptr++) {
+	i < n; i+=4) {
       WorldToRaster (raster, coord [i], coord [i+1], &rx1, &ry1);
       WorldToRaster (raster, coord [i+2], coord [i+3], &rx2, &ry2);
+      if (OUTSIDE_DAMAGE(rx1 < rx2 ? rx1 : rx2, ry1 < ry2 ? ry1 : ry2,
+			 rx1 > rx2 ? rx1 : rx2, ry1 > ry2 ? ry1 : ry2,
+			 dx0, dy0, dx1, dy1))
+	 continue;
       if (rx1 < minx) minx = rx1;
       if (rx1 > maxx) maxx = rx1;
       if (ry1 < miny) miny = ry1;
@@ -2842,6 +2911,13 @@ void RasterDrawSegments (Tk_Raster * raster,
       segptr->y1 = ry1;
       segptr->x2 = rx2;
       segptr->y2 = ry2;
+      segptr++;
+   }
+
+   if ((nsegs = segptr - seg) == 0) {
+      free (seg);
+      SetRasterModifiedArea (raster, 0, 0, 0, 0);
+      return;
    }
 
    /*
@@ -2886,29 +2962,37 @@ void RasterDrawRectangles (raster, coord, nrects)
    int i;
    int n = nrects*4;
    XRectangle *rect, *rectptr;
-   int rx, ry, tmp;
+   int rx0, ry0, rx, ry, tmp;
    int minx = HIGH, miny = HIGH, maxx = LOW, maxy = LOW;
+   int dx0, dy0, dx1, dy1;
 
    if (nrects < 1) return;
 
+   RasterDamageArea ((Raster *)raster, &dx0, &dy0, &dx1, &dy1);
+
    for (i = 0, rectptr= rect= (XRectangle*) malloc(sizeof (XRectangle)*nrects);
-	i < n; i+=4, rectptr++) {
-      WorldToRaster (raster, coord [i], coord [i+1], &rx, &ry);
-      if (rx < minx) minx = rx;
-      if (rx > maxx) maxx = rx;
-      if (ry < miny) miny = ry;
-      if (ry > maxy) maxy = ry;
-      rectptr->x = rx;
-      rectptr->y = ry;
+	i < n; i+=4) {
+      WorldToRaster (raster, coord [i], coord [i+1], &rx0, &ry0);
       WorldToRaster (raster, coord [i+2], coord [i+3], &rx, &ry);
-      if (rx < minx) minx = rx;
+      if (rx0 > rx) { tmp = rx0; rx0 = rx; rx = tmp; }
+      if (ry0 > ry) { tmp = ry0; ry0 = ry; ry = tmp; }
+      if (OUTSIDE_DAMAGE(rx0, ry0, rx, ry, dx0, dy0, dx1, dy1))
+	 continue;
+      if (rx0 < minx) minx = rx0;
       if (rx > maxx) maxx = rx;
-      if (ry < miny) miny = ry;
+      if (ry0 < miny) miny = ry0;
       if (ry > maxy) maxy = ry;
-      if (rectptr->x > rx) { tmp = rectptr->x; rectptr->x = rx; rx = tmp; }
-      if (rectptr->y > ry) { tmp = rectptr->y; rectptr->y = ry; ry = tmp; }
-      rectptr->width = rx - rectptr->x;
-      rectptr->height = ry - rectptr->y;
+      rectptr->x = rx0;
+      rectptr->y = ry0;
+      rectptr->width = rx - rx0;
+      rectptr->height = ry - ry0;
+      rectptr++;
+   }
+
+   if ((nrects = rectptr - rect) == 0) {
+      free (rect);
+      SetRasterModifiedArea (raster, 0, 0, 0, 0);
+      return;
    }
 
    XDrawRectangles (GetRasterDisplay (raster),
@@ -2934,29 +3018,37 @@ void RasterFillRectangles (raster, coord, nrects)
    int i;
    int n = nrects*4;
    XRectangle *rect, *rectptr;
-   int rx, ry, tmp;
+   int rx0, ry0, rx, ry, tmp;
    int minx = HIGH, miny = HIGH, maxx = LOW, maxy = LOW;
+   int dx0, dy0, dx1, dy1;
 
    if (nrects < 1) return;
 
+   RasterDamageArea ((Raster *)raster, &dx0, &dy0, &dx1, &dy1);
+
    for (i = 0, rectptr= rect= (XRectangle*) malloc(sizeof (XRectangle)*nrects);
-	i < n; i+=4, rectptr++) {
-      WorldToRaster (raster, coord [i], coord [i+1], &rx, &ry);
-      if (rx < minx) minx = rx;
-      if (rx > maxx) maxx = rx;
-      if (ry < miny) miny = ry;
-      if (ry > maxy) maxy = ry;
-      rectptr->x = rx;
-      rectptr->y = ry;
+	i < n; i+=4) {
+      WorldToRaster (raster, coord [i], coord [i+1], &rx0, &ry0);
       WorldToRaster (raster, coord [i+2], coord [i+3], &rx, &ry);
-      if (rx < minx) minx = rx;
+      if (rx0 > rx) { tmp = rx0; rx0 = rx; rx = tmp; }
+      if (ry0 > ry) { tmp = ry0; ry0 = ry; ry = tmp; }
+      if (OUTSIDE_DAMAGE(rx0, ry0, rx, ry, dx0, dy0, dx1, dy1))
+	 continue;
+      if (rx0 < minx) minx = rx0;
       if (rx > maxx) maxx = rx;
-      if (ry < miny) miny = ry;
+      if (ry0 < miny) miny = ry0;
       if (ry > maxy) maxy = ry;
-      if (rectptr->x > rx) { tmp = rectptr->x; rectptr->x = rx; rx = tmp; }
-      if (rectptr->y > ry) { tmp = rectptr->y; rectptr->y = ry; ry = tmp; }
-      rectptr->width = rx - rectptr->x;
-      rectptr->height = ry - rectptr->y;
+      rectptr->x = rx0;
+      rectptr->y = ry0;
+      rectptr->width = rx - rx0;
+      rectptr->height = ry - ry0;
+      rectptr++;
+   }
+
+   if ((nrects = rectptr - rect) == 0) {
+      free (rect);
+      SetRasterModifiedArea (raster, 0, 0, 0, 0);
+      return;
    }
 
    XFillRectangles (GetRasterDisplay (raster),
@@ -2985,6 +3077,7 @@ void RasterFillPolygon (raster, coord, npts)
    XPoint *pt, *ptptr;
    int rx, ry;
    int minx = HIGH, miny = HIGH, maxx = LOW, maxy = LOW;
+   int dx0, dy0, dx1, dy1;
 
    if (npts < 1) return;
 
@@ -2999,6 +3092,13 @@ void RasterFillPolygon (raster, coord, npts)
       ptptr->y = ry;
    }
 
+   RasterDamageArea ((Raster *)raster, &dx0, &dy0, &dx1, &dy1);
+   if (OUTSIDE_DAMAGE(minx, miny, maxx, maxy, dx0, dy0, dx1, dy1)) {
+      free (pt);
+      SetRasterModifiedArea (raster, 0, 0, 0, 0);
+      return;
+   }
+
    XFillPolygon (GetRasterDisplay (raster),
 		 GetRasterDrawable (raster),
 		 GetRasterGC (raster),
@@ -3181,9 +3281,22 @@ RasterScrollX(Raster *raster,
 /*    printf("SetRasterCoords wx0 %f wx1 %f\n", wx0, wx1);*/
 #endif
     if (raster->plot_func) {
+	int rx0, rx1, ry;
+
+	/* Only the exposed sliver needs drawing */
+	WorldToRaster(raster, wx0, raster->wy0, &rx0, &ry);
+	WorldToRaster(raster, wx1+1, raster->wy0, &rx1, &ry);
+	raster->damage = 1;
+	raster->dx0 = rx0 < rx1 ? rx0 : rx1;
+	raster->dx1 = rx0 < rx1 ? rx1 : rx0;
+	raster->dy0 = 0;
+	raster->dy1 = raster->height-1;
+
 	raster->plot_func(raster, Tk_PathName(raster->tkwin),
 			  RASTER_REPLOT_SLIVER,
 			  (int)wx0, 0, (int)(wx1+1), 0);
+
+	raster->damage = 0;
     }
 }
 
@@ -116,6 +116,8 @@ static Tk_ConfigSpec configSpecs[] = {
 
 static int TraceCmd(ClientData clientData, Tcl_Interp *interp,
 		    int argc, char **argv);
+static int TraceCacheFlushCmd(ClientData clientData, Tcl_Interp *interp,
+			      int argc, char **argv);
 void TraceEventProc(ClientData clientData, XEvent *eventPtr);
 static int TraceConfigure(Tcl_Interp *interp, DNATrace *tracePtr,
 			  int argc, char **argv, int flags);
@@ -135,6 +137,17 @@ static int save_image(DNATrace *t, char *fname, int height,
 int Trace_Init(Tcl_Interp *interp) {
     Tcl_CreateCommand(interp, "dnatrace", TraceCmd,
 		      NULL, (Tcl_CmdDeleteProc *)NULL);
+    Tcl_CreateCommand(interp, "trace_cache_flush", TraceCacheFlushCmd,
+		      NULL, (Tcl_CmdDeleteProc *)NULL);
+    return TCL_OK;
+}
+
+/*
+ * Drops all cached and queued traces. Called when a database is closed.
+ */
+static int TraceCacheFlushCmd(ClientData clientData, Tcl_Interp *interp,
+			      int argc, char **argv) {
+    trace_cache_flush();
     return TCL_OK;
 }
 
@@ -173,6 +186,7 @@ static int TraceCmd(ClientData clientData, Tcl_Interp *interp,
     tracePtr->cursor_pos = 0;
     tracePtr->cursor_pos_old = 0;
     tracePtr->read = NULL;
+    tracePtr->decimate = NULL;
     tracePtr->Agc = NULL;
     tracePtr->Cgc = NULL;
     tracePtr->Ggc = NULL;
@@ -2063,6 +2077,7 @@ static int resample(DNATrace *t, int spacing) {
     xfree(r->traceG); r->traceG = traceG;
     xfree(r->traceT); r->traceT = traceT;
     r->NPoints = nsamples;
+    trace_decimate_reset(t);
 
     t->tracePos = (uint_2 *)xrealloc(t->tracePos, r->NPoints * sizeof(uint_2));
     t->tracePosE= (uint_2 *)xrealloc(t->tracePosE,r->NPoints * sizeof(uint_2));
@@ -33,6 +33,19 @@ typedef struct {
     char		*title;
 } PS_TRACE;
 
+/*
+ * The per pixel column extremes of each trace channel at a given X scale.
+ * Zoomed out traces have many samples per pixel, so these are drawn in
+ * place of the individual samples.
+ */
+typedef struct {
+    Read *read;			/* Read and scale this was computed for */
+    double scale_x;
+    int ncols;			/* Number of pixel columns */
+    int_2 *min[4];		/* A, C, G and T minimum in each column */
+    int_2 *max[4];		/* A, C, G and T maximum in each column */
+} trace_decimate_t;
+
 /*
  * A data structure of the following type is kept for each
  * frame that currently exists for this process:
@@ -146,6 +159,7 @@ typedef struct {
 				 */
     int yticks;			/* Horizontal lines in plot. zero => none */
 
+    trace_decimate_t *decimate;	/* Cached min/max per column, or NULL */
 } DNATrace;
 
 /* Flags */
@@ -203,6 +217,8 @@ extern void complement_trace(DNATrace *t); /* from tkTraceComp.c */
 
 extern void trace_flash(DNATrace *t);
 
+extern void trace_decimate_reset(DNATrace *t);
+
 int    	*trace_index_to_basePos(uint_2 *basePos, int NBases, int NPoints);
 int   visible_region(DNATrace *t);
 
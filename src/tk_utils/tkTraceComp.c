@@ -175,6 +175,7 @@ void complement_trace(DNATrace *t) {
 	return;
 
     complement_read(t->read, t->Ned);
+    trace_decimate_reset(t);
 
     i = t->leftVector;
     if (t->rightVector != -1)
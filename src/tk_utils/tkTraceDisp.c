@@ -232,27 +232,144 @@ void trace_draw_confidence4(DNATrace *t, Display *d, Pixmap p,
     }
 }
 
+/*
+ * Discards the cached per column trace extremes. This needs calling whenever
+ * the trace samples are replaced or modified.
+ */
+void trace_decimate_reset(DNATrace *t) {
+    if (!t->decimate)
+	return;
+
+    xfree(t->decimate->min[0]);
+    xfree(t->decimate);
+    t->decimate = NULL;
+}
+
+/*
+ * Returns the minimum and maximum of each trace channel within each pixel
+ * column at the current X scale. Sample i lies in column (int)(i*scale_x),
+ * as in trace_draw2. These are computed once per read and scale, so
+ * redrawing or scrolling a zoomed out trace costs the number of pixels
+ * drawn rather than the number of samples.
+ *
+ * Returns decimate struct on success
+ *         NULL on failure
+ */
+static trace_decimate_t *trace_decimate(DNATrace *t) {
+    trace_decimate_t *dc = t->decimate;
+    Read *r = t->read;
+    TRACE *tr[4];
+    int ch, i, j, c, ncols;
+
+    if (dc && dc->read == r && dc->scale_x == t->scale_x)
+	return dc;
+
+    trace_decimate_reset(t);
+
+    if (r->NPoints <= 0 || t->scale_x >= 1)
+	return NULL;
+
+    ncols = (int)((r->NPoints-1) * t->scale_x) + 1;
+    if (NULL == (dc = (trace_decimate_t *)xmalloc(sizeof(*dc))))
+	return NULL;
+    if (NULL == (dc->min[0] = (int_2 *)xmalloc(8 * ncols * sizeof(int_2)))) {
+	xfree(dc);
+	return NULL;
+    }
+    for (ch = 0; ch < 4; ch++) {
+	dc->min[ch] = dc->min[0] + 2 * ch * ncols;
+	dc->max[ch] = dc->min[ch] + ncols;
+    }
+    dc->read = r;
+    dc->scale_x = t->scale_x;
+    dc->ncols = ncols;
+
+    tr[0] = r->traceA;
+    tr[1] = r->traceC;
+    tr[2] = r->traceG;
+    tr[3] = r->traceT;
+
+    /* Less than one pixel per sample, so every column has a sample */
+    for (i = 0; i < r->NPoints; i = j) {
+	c = (int)(i * t->scale_x);
+	for (j = i+1; j < r->NPoints && (int)(j * t->scale_x) == c; j++)
+	    ;
+
+	for (ch = 0; ch < 4; ch++) {
+	    TRACE *trp = tr[ch];
+	    int k, mn = (int_2)trp[i], mx = mn;
+
+	    for (k = i+1; k < j; k++) {
+		int v = (int_2)trp[k];
+		if (mn > v) mn = v;
+		if (mx < v) mx = v;
+	    }
+	    dc->min[ch][c] = mn;
+	    dc->max[ch][c] = mx;
+	}
+    }
+
+    t->decimate = dc;
+    return dc;
+}
+
 /*
  * Draws a segment of a single trace. We draw 'samples' points from the 'tr'
  * trace array to pixel coordinates (x,y) with scale xs, ys.
  *
+ * When zoomed out to several samples per pixel we instead draw the cached
+ * minimum and maximum of channel 'ch' in each pixel column.
+ *
  * The confidence display is quite wide, and draws more than x0-xn.
  * To compensate, we need to increase x0-xn.
  */
 static void trace_draw2(DNATrace *t, TRACE *tr, Display *d, Pixmap p, int max,
 			GC gc, int x0, int xn, int yoff, int height, double ys,
-			int off, int sign) {
+			int off, int sign, int ch) {
     int i, h = height-1, o;
     XPoint *xp, *xp2;
+    trace_decimate_t *dc;
 
-    if (xn <= 0 || NULL == (xp = (XPoint *)xmalloc(xn * sizeof(XPoint)))) {
+    if (xn <= 0)
 	return;
-    }
 
     o = t->disp_offset * t->scale_x;
 
     if (t->read->maxTraceVal)
 	h -= h*(double)off/t->read->maxTraceVal;
+
+    if (sign && t->scale_x < 0.5 && (dc = trace_decimate(t))) {
+	int c, n, c0, c1;
+
+	c0 = (int)(x0 * t->scale_x);
+	c1 = (int)((x0 + xn - 1) * t->scale_x);
+	if (c1 >= dc->ncols)
+	    c1 = dc->ncols-1;
+	if (c0 > c1)
+	    return;
+
+	if (NULL == (xp = (XPoint *)xmalloc(2 * (c1-c0+1) * sizeof(XPoint))))
+	    return;
+
+	for (n = 0, c = c0; c <= c1; c++) {
+	    if (c - o < 0)
+		continue;
+	    xp[n].x = c - o;
+	    xp[n++].y = h - ys * (dc->max[ch][c]-off) + yoff;
+	    xp[n].x = c - o;
+	    xp[n++].y = h - ys * (dc->min[ch][c]-off) + yoff;
+	}
+
+	if (n > 0)
+	    XDrawLines(d, p, gc, xp, n, CoordModeOrigin);
+
+	xfree(xp);
+	return;
+    }
+
+    if (NULL == (xp = (XPoint *)xmalloc(xn * sizeof(XPoint))))
+	return;
+
     for (i = 0; i < xn; i++, tr++) {
 	xp[i].x = (int)((x0 + i) * t->scale_x) - o;
 	if (sign) {
@@ -568,16 +685,16 @@ void trace_draw_trace(DNATrace *t, Display *d, Pixmap p,
     case STYLE_CHROMA:
 	trace_draw2(t, &t->read->traceA[x0], d, p, m,
 		    t->Agc, x0, xn, yoff, height, yscale,
-		    t->read->baseline, 1);
+		    t->read->baseline, 1, 0);
 	trace_draw2(t, &t->read->traceC[x0], d, p, m,
 		    t->Cgc, x0, xn, yoff, height, yscale,
-		    t->read->baseline, 1);
+		    t->read->baseline, 1, 1);
 	trace_draw2(t, &t->read->traceG[x0], d, p, m,
 		    t->Ggc, x0, xn, yoff, height, yscale,
-		    t->read->baseline, 1);
+		    t->read->baseline, 1, 2);
 	trace_draw2(t, &t->read->traceT[x0], d, p, m,
 		    t->Tgc, x0, xn, yoff, height, yscale,
-		    t->read->baseline, 1);
+		    t->read->baseline, 1, 3);
 	break;
 #if 0
     case STYLE_FILLED:
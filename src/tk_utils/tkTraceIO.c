@@ -1,5 +1,9 @@
 #include <assert.h>
 #include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <os.h>
 #include <io_lib/Read.h>
 #include <io_lib/traceType.h>
@@ -13,10 +17,231 @@
 
 #define PYRO_SCALE 1000
 
+/*
+ * A small least recently used cache of decoded traces, keyed on filename
+ * and format. Widgets are handed copies as they edit, complement and free
+ * their own Read structures. Traces may be decoded ahead of need from the
+ * Tcl idle loop by trace_prefetch().
+ *
+ * Names are often bare reading names found via the current directory and
+ * RAWDATA, both of which change when a database is opened. io_lib does not
+ * tell us which path it finally opened, so the whole cache and prefetch
+ * queue are dropped whenever either changes. Entries whose file can be
+ * stat()ed directly also record its size and mtime, and are decoded again
+ * if the file on disk no longer matches.
+ */
+#define TRACE_CACHE_SIZE 32
+#define TRACE_PREFETCH_SIZE (TRACE_CACHE_SIZE/2)
+
+typedef struct {
+    char *file;
+    int format;
+    Read *read;
+    int age;
+    time_t mtime;	/* 0 if file could not be stat()ed directly */
+    off_t size;
+} trace_cache_t;
+
+static trace_cache_t trace_cache[TRACE_CACHE_SIZE];
+static int trace_cache_age = 0;
+static char *trace_cache_ctx = NULL;	/* cwd and RAWDATA at decode time */
+
+static struct {
+    char *file;
+    int format;
+} prefetch_queue[TRACE_PREFETCH_SIZE];
+static int prefetch_len = 0;
+
 static int trace_load_private(DNATrace *t);
 void trace_pyroalign(Read *r);
 
+/*
+ * Empties the trace cache and the prefetch queue.
+ */
+void trace_cache_flush(void) {
+    int i;
+
+    for (i = 0; i < TRACE_CACHE_SIZE; i++) {
+	if (trace_cache[i].read) {
+	    read_deallocate(trace_cache[i].read);
+	    free(trace_cache[i].file);
+	    trace_cache[i].read = NULL;
+	    trace_cache[i].file = NULL;
+	}
+    }
+
+    for (i = 0; i < prefetch_len; i++)
+	free(prefetch_queue[i].file);
+    prefetch_len = 0;
+}
+
+/*
+ * Flushes the cache if the current directory or RAWDATA differ from when
+ * its contents were decoded, as the same names may now find other files.
+ */
+static void trace_cache_check_ctx(void) {
+    char cwd[1024], *rawdata, *ctx;
+
+    if (NULL == getcwd(cwd, 1024))
+	*cwd = 0;
+    if (NULL == (rawdata = getenv("RAWDATA")))
+	rawdata = "";
+
+    if (trace_cache_ctx) {
+	size_t l = strlen(cwd);
+	if (strncmp(trace_cache_ctx, cwd, l) == 0 &&
+	    trace_cache_ctx[l] == '\n' &&
+	    strcmp(trace_cache_ctx + l + 1, rawdata) == 0)
+	    return;
+    }
+
+    trace_cache_flush();
+
+    if (NULL == (ctx = malloc(strlen(cwd) + strlen(rawdata) + 2)))
+	return;
+    sprintf(ctx, "%s\n%s", cwd, rawdata);
+    free(trace_cache_ctx);
+    trace_cache_ctx = ctx;
+}
+
+/*
+ * Returns the cache entry holding file in the given format, decoding it
+ * into the least recently used slot if it is not already present or is
+ * older than the file on disk.
+ *
+ * Returns entry on success
+ *         NULL on failure
+ */
+static trace_cache_t *trace_cache_get(char *file, int format) {
+    trace_cache_t *tc = NULL;
+    struct stat sb;
+    Read *r;
+    int i, tmp;
+
+    trace_cache_check_ctx();
+
+    if (stat(file, &sb) != 0)
+	sb.st_mtime = 0, sb.st_size = 0;
+
+    for (i = 0; i < TRACE_CACHE_SIZE; i++) {
+	if (trace_cache[i].read && trace_cache[i].format == format &&
+	    strcmp(trace_cache[i].file, file) == 0) {
+	    if (trace_cache[i].mtime == sb.st_mtime &&
+		trace_cache[i].size == sb.st_size) {
+		trace_cache[i].age = ++trace_cache_age;
+		return &trace_cache[i];
+	    }
+
+	    /* Stale; decode it again into this slot */
+	    tc = &trace_cache[i];
+	    break;
+	}
+
+	/* Otherwise reuse an empty slot, else the least recently used */
+	if (!tc || (tc->read && (!trace_cache[i].read ||
+				 trace_cache[i].age < tc->age)))
+	    tc = &trace_cache[i];
+    }
+
+    tmp = read_experiment_redirect(2);
+    r = read_reading(file, format);
+    read_experiment_redirect(tmp);
+    if (NULLRead == r)
+	return NULL;
+
+    if (tc->read) {
+	read_deallocate(tc->read);
+	free(tc->file);
+    }
+    if (NULL == (tc->file = strdup(file))) {
+	read_deallocate(r);
+	tc->read = NULL;
+	return NULL;
+    }
+    tc->format = format;
+    tc->read = r;
+    tc->age = ++trace_cache_age;
+    tc->mtime = sb.st_mtime;
+    tc->size = sb.st_size;
+
+    return tc;
+}
+
+/*
+ * Removes any cached copies of file, eg after it has been written to.
+ */
+void trace_cache_forget(char *file) {
+    int i;
+
+    for (i = 0; i < TRACE_CACHE_SIZE; i++) {
+	if (trace_cache[i].read && strcmp(trace_cache[i].file, file) == 0) {
+	    read_deallocate(trace_cache[i].read);
+	    free(trace_cache[i].file);
+	    trace_cache[i].read = NULL;
+	    trace_cache[i].file = NULL;
+	}
+    }
+}
+
+/*
+ * Idle callback decoding one queued trace at a time, so that user events
+ * are still processed between each load.
+ */
+static void trace_prefetch_idle(ClientData cd) {
+    char *file;
+    int format;
+
+    trace_cache_check_ctx();
+    if (prefetch_len == 0)
+	return;
+
+    file = prefetch_queue[0].file;
+    format = prefetch_queue[0].format;
+    memmove(&prefetch_queue[0], &prefetch_queue[1],
+	    --prefetch_len * sizeof(prefetch_queue[0]));
+
+    trace_cache_get(file, format);
+    free(file);
+
+    if (prefetch_len)
+	Tcl_DoWhenIdle(trace_prefetch_idle, NULL);
+}
+
+/*
+ * Queues file to be decoded into the trace cache when Tk is next idle, so a
+ * later trace_load of it need not wait on the disk or decompression. The
+ * oldest queued request is dropped when the queue is full.
+ */
+void trace_prefetch(char *file, char *format) {
+    int i, form = trace_type_str2int(format);
+    char *f;
+
+    trace_cache_check_ctx();
+    for (i = 0; i < prefetch_len; i++)
+	if (prefetch_queue[i].format == form &&
+	    strcmp(prefetch_queue[i].file, file) == 0)
+	    return;
+
+    if (NULL == (f = strdup(file)))
+	return;
+
+    if (prefetch_len == TRACE_PREFETCH_SIZE) {
+	free(prefetch_queue[0].file);
+	memmove(&prefetch_queue[0], &prefetch_queue[1],
+		--prefetch_len * sizeof(prefetch_queue[0]));
+    }
+
+    if (prefetch_len == 0)
+	Tcl_DoWhenIdle(trace_prefetch_idle, NULL);
+
+    prefetch_queue[prefetch_len].file = f;
+    prefetch_queue[prefetch_len].format = form;
+    prefetch_len++;
+}
+
 void trace_unload(DNATrace *t) {
+    trace_decimate_reset(t);
+
     if (t->read)
 	read_deallocate(t->read);
 
@@ -197,18 +422,16 @@ void trace_recalc_baseline(DNATrace *t) {
  */
 int trace_load(DNATrace *t, char *file, char *format) {
     int form = trace_type_str2int(format);
-    int tmp;
+    trace_cache_t *tc;
 
     /* Load the Read structure */
     if (t->read)
 	trace_unload(t);
 
-    tmp = read_experiment_redirect(2);
-    if (NULLRead == (t->read = read_reading(file, form))) {
-	read_experiment_redirect(tmp);
+    if (NULL == (tc = trace_cache_get(file, form)))
+	return -1;
+    if (NULLRead == (t->read = read_dup(tc->read, NULL)))
 	return -1;
-    }
-    read_experiment_redirect(tmp);
 
     /* Auto-detect pyrosequencing by presence of flows */
     if (t->read->flow_order && t->read->flow && t->read->nflows) {
@@ -252,6 +475,8 @@ static int trace_load_private(DNATrace *t) {
     register int i;
     Exp_info *e = NULL;
 
+    trace_decimate_reset(t);
+
     /*
      * Allocate and initialise the edited base values.
      * These come directly from the Read structure. When dealing with an
@@ -658,6 +883,7 @@ int trace_save( DNATrace* t, char* file, char *format )
 	case TT_PLN: ret = trace_save_as_plain_text_file( t, file );  break;
         default:     ret = trace_save_as_trace_file( t, file, fmt );  break;
     }
+    trace_cache_forget( file );
     return ret;
 }
 
@@ -44,4 +44,20 @@ int trace_memory_load(DNATrace *t, Read *r);
  */
 void trace_unload(DNATrace *t);
 
+/*
+ * Queues a trace to be decoded into the trace cache when Tk is next idle,
+ * so that a subsequent trace_load of it is fast.
+ */
+void trace_prefetch(char *file, char *format);
+
+/*
+ * Removes any cached copies of a trace file, eg after it has been written.
+ */
+void trace_cache_forget(char *file);
+
+/*
+ * Empties the trace cache and prefetch queue, eg when closing a database.
+ */
+void trace_cache_flush(void);
+
 #endif /* TK_TRACEIO_H */
@@ -20,6 +20,7 @@
 #include <cctype>           // For isspace(), toupper()
 #include <cstring>          // For strcpy(), strcat(), etc
 #include <cstdlib>          // For atof()
+#include <dirent.h>         // For opendir(), readdir()
 #include <staden.h>         // For io_lib and licence stuff
 #include <mutlib.h>         // For mutation library
 #include <pathutil.h>       // For MakeFullPath()
@@ -53,6 +54,7 @@ void PrintBanner()
 void PrintUsage( tracediff_t& td )
 {
     std::fprintf( stdout, "Usage  : tracediff [options] <experiment-files>\n"
+    "         tracediff -r<reference-trace> [options] <trace-files>\n"
     "Options:\n"
     "[-a<peak-alignment>]    = Maximum peak alignment deviation (default=%0.2f)\n"
     "[-c]                    = Complement reverse strand tags   (default=off)\n"
@@ -63,6 +65,11 @@ void PrintUsage( tracediff_t& td )
     "[-s<sensitivity>]       = Mutation detection sensitivity   (default=%0.2f)\n"
     "[-t<noise-threshold]    = Noise level threshold percentage (default=%0.2f)\n"
     "[-w<peak-width-max>]    = Maximum peak width in bases      (default=%0.2f)\n"
+    "Trace mode options, the inputs are trace files rather than experiment files:\n"
+    "[-r<reference-trace>]   = Reference trace for all inputs\n"
+    "[-D<trace-directory>]   = Add all traces in a directory\n"
+    "[-o<report-file>]       = Write tags to a report file      (default=stdout)\n"
+    "[-v]                    = Inputs are reverse strand        (default=off)\n"
     "[-y]                    = Y-scale traces before difference (default=off)\n"
     "[-z]                    = Enter debugging loop and wait... (default=off)\n",
      td.Parameter[TRACEDIFF_PARAMETER_PEAK_ALIGNMENT],
@@ -76,6 +83,176 @@ void PrintUsage( tracediff_t& td )
 
 
 
+// Returns true if the filename has a trace file extension we can read
+bool IsTraceFile( const char* pName )
+{
+    static const char* pExt[] = { ".scf", ".ztr", ".abi", ".ab1", 0 };
+    int nLen = std::strlen( pName );
+    if( nLen < 4 )
+        return false;
+    for( int i=0; pExt[i]; i++ )
+    {
+        int k;
+        for( k=0; k<4; k++ )
+        {
+            if( std::tolower(pName[nLen-4+k]) != pExt[i][k] )
+                break;
+        }
+        if( k == 4 )
+            return true;
+    }
+    return false;
+}
+
+
+
+// Appends the trace files found in directory pDir to the list
+void AddDirectory( StringList& FileList, const char* pDir )
+{
+    char           pBuffer[BUFSIZE];
+    DIR*           pDirectory;
+    struct dirent* pEntry;
+
+    pDirectory = opendir( pDir );
+    if( !pDirectory )
+    {
+        std::fprintf( stderr, "Unable to open directory %s, skipping.\n", pDir );
+        std::fflush( stderr );
+        return;
+    }
+    while( (pEntry = readdir(pDirectory)) )
+    {
+        if( !IsTraceFile(pEntry->d_name) )
+            continue;
+        if( std::strlen(pDir) + std::strlen(pEntry->d_name) + 2 > (std::size_t)BUFSIZE )
+            continue;
+        std::sprintf( pBuffer, "%s/%s", pDir, pEntry->d_name );
+        FileList.Append( pBuffer );
+    }
+    closedir( pDirectory );
+}
+
+
+
+// Compares every trace in FileList with a single reference trace. Inputs
+// are loaded one at a time and their tags streamed to pReport as soon as
+// they are found, so the memory used does not grow with the list length.
+// The reference is preprocessed by the first TraceDiffExecute() and reused
+// for every subsequent input. Returns the number of traces that failed.
+int ProcessTraces( tracediff_t& td, StringList& FileList, const char* pRefFile,
+                   mutlib_strand_t nStrand, std::FILE* pReport, bool bQuiet,
+                   bool bOutputDifferenceTrace )
+{
+    char  pBuffer[BUFSIZE];
+    int   nRefClipL   = -1;
+    int   nRefClipR   = -1;
+    int   nFailed     = 0;
+    Read* pInputTrace = 0;
+
+
+
+    // Open reference trace file
+    Read* pRefTrace = read_reading( const_cast<char*>(pRefFile), TT_ANY );
+    if( !pRefTrace )
+    {
+        std::fprintf( stderr, "Unable to open reference trace file %s.\n", pRefFile );
+        std::fflush( stderr );
+        return FileList.Length();
+    }
+
+
+
+    // Use the reference experiment file's QL/QR records if it has one,
+    // otherwise use the entire reference trace
+    std::strcpy( pBuffer, pRefFile );
+    ReplaceExtension( pBuffer, ".exp" );
+    Exp_info* pRefExpFile = exp_read_info( pBuffer );
+    if( pRefExpFile )
+    {
+        exp_get_int( pRefExpFile, EFLT_QL, &nRefClipL );
+        exp_get_int( pRefExpFile, EFLT_QR, &nRefClipR );
+        exp_destroy_info(pRefExpFile);
+    }
+    TraceDiffSetReference( &td, pRefTrace, nStrand, nRefClipL, nRefClipR );
+
+
+
+    // Trace processing loop
+    for( int n=0; n<FileList.Length(); n++ )
+    {
+        char* p = (n==0) ? FileList.First() : FileList.Next();
+        if( !bQuiet )
+        {
+            std::fprintf( stdout, "Processing: %s\n", p );
+            std::fflush( stdout );
+        }
+
+
+
+        // Open input trace
+        pInputTrace = read_reading( p, TT_ANY );
+        if( !pInputTrace )
+        {
+            std::fprintf( stderr, "Unable to open input trace file %s, skipping.\n", p );
+            std::fflush( stderr );
+            nFailed++;
+            continue;
+        }
+
+
+
+        // Execute the algorithm
+        TraceDiffSetInput( &td, pInputTrace, nStrand, -1, -1 );
+        if( TraceDiffExecute( &td, TRACEDIFF_ALGORITHM_DEFAULT ) )
+        {
+            std::fprintf( stderr, "%s: %s", p, TraceDiffGetResultString(&td) );
+            std::fflush( stderr );
+            read_deallocate(pInputTrace);
+            pInputTrace = 0;
+            nFailed++;
+            continue;
+        }
+
+
+
+        // Output Difference Trace
+        if( bOutputDifferenceTrace )
+        {
+            Read* pDiff = TraceDiffGetDifference( &td, 0, 0 );
+            std::strcpy( pBuffer, p );
+            ReplaceExtension( pBuffer, "_diff.ztr" );
+            if( write_reading( pBuffer, pDiff, TT_ZTR ) < 0 )
+            {
+                std::fprintf( stderr, "Unable to write out difference trace %s.\n", pBuffer );
+                std::fflush( stderr );
+            }
+        }
+
+
+
+        // Stream the results
+        int nTags = TraceDiffGetTagCount( &td );
+        for( int i=0; i<nTags; i++ )
+        {
+            mutlib_tag_t* pTag = TraceDiffGetTag( &td, i );
+            assert(pTag != NULL);
+            char c = (pTag->Strand==MUTLIB_STRAND_FORWARD) ? '+' : '-';
+            std::fprintf( pReport, "%s %s %c %5d %s\n", p, pTag->Type, c, *pTag->Position, pTag->Comment );
+        }
+        std::fflush( pReport );
+        read_deallocate(pInputTrace);
+        pInputTrace = 0;
+    }
+
+
+
+    // Cleanup & exit
+    read_deallocate(pRefTrace);
+    return nFailed;
+}
+
+
+
 //-----------
 // Tracediff
 //-----------
@@ -106,6 +283,12 @@ int main( int argc, char* argv[] )
     double          nPeakWidthMaximum      = -1.0;
     double          nNoiseWindowLength     = -1.0;
     double          nNoiseThreshold        = -1.0;
+    char            pRefFile[BUFSIZE]      = { 0 };
+    char            pReportFile[BUFSIZE]   = { 0 };
+    std::FILE*      pReport                = stdout;
+    StringList      DirList;
+    mutlib_strand_t nTraceStrand           = MUTLIB_STRAND_FORWARD;
+    int             nResult                = 0;
     TraceDiffInit( &td );
 
 
@@ -160,6 +343,12 @@ int main( int argc, char* argv[] )
                     break;
 
 
+                case 'D':
+                    // Directory of traces
+                    DirList.Append( pBuffer );
+                    break;
+
+
                 case 'd':
                     // Difference traces
                     bOutputDifferenceTrace = true;
@@ -178,12 +367,24 @@ int main( int argc, char* argv[] )
                     break;
 
 
+                case 'o':
+                    // Report file
+                    std::strcpy( pReportFile, pBuffer );
+                    break;
+
+
                 case 'q':
                     // Quiet mode on
                     bQuiet = true;
                     break;
 
 
+                case 'r':
+                    // Reference trace
+                    std::strcpy( pRefFile, pBuffer );
+                    break;
+
+
                 case 's':
                     // Sensitivity
                     nSensitivity = std::atof( pBuffer );
@@ -196,6 +397,12 @@ int main( int argc, char* argv[] )
                     break;
 
 
+                case 'v':
+                    // Reverse strand trace inputs
+                    nTraceStrand = MUTLIB_STRAND_REVERSE;
+                    break;
+
+
                 case 'w':
                     // Peak width maximum
                     nPeakWidthMaximum = std::atof( pBuffer );
@@ -224,6 +431,17 @@ int main( int argc, char* argv[] )
 
 
 
+        // Trace directories only make sense against a reference trace
+        if( DirList.Length() && !pRefFile[0] )
+        {
+            std::fprintf( stderr, "The -D option requires a reference trace, specify one with -r.\n" );
+            std::fflush( stderr );
+            PrintUsage( td );
+            return -1;
+        }
+
+
+
         // Show banner
         if( !bQuiet )
             PrintBanner();
@@ -263,6 +481,8 @@ int main( int argc, char* argv[] )
         // Add any experiment files on the command line
         for( n=n; n<argc; n++ )
             FileList.Append( argv[n] );
+        for( n=0; n<DirList.Length(); n++ )
+            AddDirectory( FileList, (n==0) ? DirList.First() : DirList.Next() );
         if( FileList.Length() < 1 )
         {
             PrintUsage( td );
@@ -289,6 +509,30 @@ int main( int argc, char* argv[] )
 
 
 
+        // Trace mode, compare all inputs against a single reference trace
+        if( pRefFile[0] )
+        {
+            if( pReportFile[0] )
+            {
+                pReport = std::fopen( pReportFile, "wt" );
+                if( !pReport )
+                {
+                    std::fprintf( stderr, "Unable to open report file %s.\n", pReportFile );
+                    std::fflush( stderr );
+                    TraceDiffDestroy( &td );
+                    return -1;
+                }
+            }
+            nResult = ProcessTraces( td, FileList, pRefFile, nTraceStrand, pReport,
+                                     bQuiet, bOutputDifferenceTrace );
+            if( pReport != stdout )
+                std::fclose( pReport );
+            TraceDiffDestroy( &td );
+            return nResult ? 1 : 0;
+        }
+
+
+
         // File processing loop
         for( n=0; n<FileList.Length(); n++ )
         {
@@ -31,6 +31,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <ctype.h>
+#include <sys/time.h>
 
 #include "misc.h" 
 #include "dna_utils.h"
@@ -102,6 +103,10 @@ int init_hash8 ( int seq1_len, int seq2_len,
 		 int **word_count, int **hash_values2,
 		 int **diag );
 
+void free_hash8 ( int *hash_values1, int *last_word,
+		  int *word_count, int *hash_values2,
+		  int *diag );
+
 int hash_seq8 ( char *seq, int *hash_values, int seq_len);
 
 int init_hash ( int word_length, int seq1_len, int seq2_len,
@@ -134,6 +139,34 @@ typedef struct vector_specs_ {
   int         number;
 } Vector_specs;
 
+/*
+ * A hashed vector sequence. The hash tables are only read by the search
+ * routines (do_hash, do_hash_tr, do_hash_vr) so an entry can be reused for
+ * every reading cloned into the same vector.
+ */
+typedef struct vector_hash_ {
+  char file_name[FILENAME_MAX+1]; /* "" if the entry holds nothing */
+  int  key;			  /* mode specific, eg the cloning site */
+  int  length;
+  char *seq;
+  int  *hash_values;
+  int  *last_word;
+  int  *word_count;
+  int  last_used;
+} Vector_hash;
+
+#define VECTOR_CACHE_SIZE 8
+
+typedef struct vector_cache_ {
+  Vector_hash entry[VECTOR_CACHE_SIZE];
+  int         max_vector;
+  int         size_hash;
+  int         clock;
+} Vector_cache;
+
+/* Number of readings looked at, for the throughput report */
+static int nreads = 0;
+
 Vector_specs* get_vector_info(FILE *fp_vf ) {
 
   char line[MAX_LINE], *file_name, *vector_name = NULL, *f_primer_seq = NULL,*r_primer_seq = NULL;
@@ -420,6 +453,93 @@ void store_hash (
     }
 }
 
+/************************************************************/
+
+/*
+ * Readings in one batch are often cloned into several different vectors.
+ * Rather than rereading and rehashing the vector whenever it differs from
+ * that of the previous reading we keep the VECTOR_CACHE_SIZE most recently
+ * used vectors together with their hash tables.
+ */
+
+Vector_cache *vector_cache_create ( int max_vector, int size_hash ) {
+
+    Vector_cache *vc;
+
+    if ( ! (vc = (Vector_cache *) xcalloc ( 1, sizeof(Vector_cache) )))
+	return NULL;
+    vc->max_vector = max_vector;
+    vc->size_hash = size_hash;
+    return vc;
+}
+
+void vector_cache_destroy ( Vector_cache *vc ) {
+
+    int i;
+
+    if ( !vc ) return;
+    for ( i = 0; i < VECTOR_CACHE_SIZE; i++ ) {
+	Vector_hash *vh = &vc->entry[i];
+	if ( vh->seq )         xfree ( vh->seq );
+	if ( vh->hash_values ) xfree ( vh->hash_values );
+	if ( vh->last_word )   xfree ( vh->last_word );
+	if ( vh->word_count )  xfree ( vh->word_count );
+    }
+    xfree ( vc );
+}
+
+/* Returns the entry holding file_name with the given key, or NULL */
+Vector_hash *vector_cache_find ( Vector_cache *vc, char *file_name, int key ) {
+
+    int i;
+
+    for ( i = 0; i < VECTOR_CACHE_SIZE; i++ ) {
+	Vector_hash *vh = &vc->entry[i];
+	if ( vh->file_name[0] && vh->key == key &&
+	     0 == strcmp ( vh->file_name, file_name ) ) {
+	    vh->last_used = ++vc->clock;
+	    return vh;
+	}
+    }
+    return NULL;
+}
+
+/*
+ * Returns an empty entry, evicting the least recently used one if need be.
+ * The caller fills in seq and the hash tables and sets file_name and key
+ * once they are valid.
+ */
+Vector_hash *vector_cache_new ( Vector_cache *vc ) {
+
+    Vector_hash *vh = &vc->entry[0];
+    int i;
+
+    for ( i = 1; i < VECTOR_CACHE_SIZE; i++ ) {
+	if ( vc->entry[i].last_used < vh->last_used )
+	    vh = &vc->entry[i];
+    }
+
+    if ( !vh->seq ) {
+	vh->seq = (char *) xmalloc ( sizeof(char)*vc->max_vector );
+	vh->hash_values = (int *) xmalloc ( sizeof(int)*vc->max_vector );
+	vh->last_word = (int *) xmalloc ( sizeof(int)*vc->size_hash );
+	vh->word_count = (int *) xmalloc ( sizeof(int)*vc->size_hash );
+	if ( !vh->seq || !vh->hash_values || !vh->last_word || !vh->word_count ) {
+	    if ( vh->seq )         xfree ( vh->seq );
+	    if ( vh->hash_values ) xfree ( vh->hash_values );
+	    if ( vh->last_word )   xfree ( vh->last_word );
+	    if ( vh->word_count )  xfree ( vh->word_count );
+	    vh->seq = NULL;
+	    vh->hash_values = vh->last_word = vh->word_count = NULL;
+	    return NULL;
+	}
+    }
+    vh->file_name[0] = '\0';
+    vh->length = 0;
+    vh->last_used = ++vc->clock;
+    return vh;
+}
+
 /***************************************************************************/
 
 /*
@@ -434,6 +554,10 @@ void store_hash (
  * we only have 3 choices for moving: across, down or diagonally and so we encode these
  * in 2 bits. This reduces the storage by a factor of 16 over using a byte for each
  * element so is worth the complication.
+ * nw is called several times for every reading so the work arrays are kept between
+ * calls and only grown. The directions for four elements are packed in a register
+ * and stored a byte at a time, so the trace array needs no clearing: the traceback
+ * only visits elements we have written.
  */
 
 int nw ( char seq1[], 
@@ -446,11 +570,14 @@ int nw ( char seq1[],
 	) {
     int i,j, gap_pen=-2;
     int size_mat, s_c, s_r, row, column, s, e;
-    int b_s, b_e, b_r, b_c, r, c,*rows1,*rows2,*rowsp1,*rowsp2;
-    int r_u, r_l, r_d, t,max_seq,byte,nibble;
+    int b_s, b_e, b_r, b_c, r, c,*rowsp1,*rowsp2;
+    int r_u, r_l, r_d, t,max_seq,byte,nibble,trace_byte;
     char *seq1_out,*seq2_out;
-    unsigned char *bit_trace, byte_across=1, byte_down=2, byte_diagonal=3;
-    unsigned char mask = 3;
+    unsigned char byte_across=1, byte_down=2, byte_diagonal=3;
+    unsigned char mask = 3, trace_bits;
+    static int *rows1 = NULL, *rows2 = NULL, rows_size = 0;
+    static unsigned char *bit_trace = NULL;
+    static int bit_trace_size = 0;
     int s_matrix[]={	3,0,0,0,0,
 			0,3,0,0,0,
 			0,0,3,0,0,
@@ -460,15 +587,20 @@ int nw ( char seq1[],
     max_seq = seq1_len + seq2_len + 1;
     size_mat = (seq1_len + 1) * (seq2_len + 1);
 
-    if ( ! (rows1 = (int *) xmalloc ( sizeof(int)*(seq1_len+1) ))) return -1;
-    if ( ! (rows2 = (int *) xmalloc ( sizeof(int)*(seq1_len+1) ))) {
-	xfree ( rows1 );
-	return -1;
-    }
-    if ( ! (bit_trace = (unsigned char *) xmalloc ( 1 + sizeof(char)*size_mat/4 ))) {
-	xfree ( rows1 );
-	xfree (rows2 );
-	return -1;
+    if ( rows_size < seq1_len+1 ) {
+	int *p1, *p2;
+	if ( ! (p1 = (int *) xrealloc ( rows1, sizeof(int)*(seq1_len+1) ))) return -1;
+	rows1 = p1;
+	if ( ! (p2 = (int *) xrealloc ( rows2, sizeof(int)*(seq1_len+1) ))) return -1;
+	rows2 = p2;
+	rows_size = seq1_len+1;
+    }
+    if ( bit_trace_size < 1 + size_mat/4 ) {
+	unsigned char *p;
+	if ( ! (p = (unsigned char *) xrealloc ( bit_trace, 1 + sizeof(char)*size_mat/4 )))
+	    return -1;
+	bit_trace = p;
+	bit_trace_size = 1 + size_mat/4;
     }
 
     /* initialise our own extra copy of the output pointers */
@@ -476,10 +608,6 @@ int nw ( char seq1[],
     seq1_out = seq1_res;
     seq2_out = seq2_res;
 
-    j = 1 + size_mat/4;
-    for(i=0;i<j;i++) {
-	bit_trace[i] = 0;
-    }
     for ( i=0;i<=seq1_len;i++) {
 /*
 	rows1[i] = gap_pen;
@@ -492,6 +620,8 @@ int nw ( char seq1[],
 
     b_s = b_e = b_r = b_c = 0;
     t = 0;
+    trace_byte = (seq1_len+2)/4;
+    trace_bits = 0;
 
     /* proceed row by row */
 
@@ -530,12 +660,17 @@ int nw ( char seq1[],
 	    want to find max (r_d + s, r_u + gap, r_l + gap) 
 	    */
 
-	    byte = e/4, nibble = 2*(e%4);
+	    byte = e>>2, nibble = (e&3)<<1;
+	    if ( byte != trace_byte ) {
+		bit_trace[trace_byte] = trace_bits;
+		trace_byte = byte;
+		trace_bits = 0;
+	    }
 	    r_d += s;
 	    r_u += gap_pen;
 	    r_l += gap_pen;
 	    if (( r_d >= r_u ) & ( r_d >= r_l )) {
-		bit_trace[byte] |= byte_diagonal << nibble;
+		trace_bits |= byte_diagonal << nibble;
 		*rowsp2 = r_d;
 		if ( r_d > b_s ) {
 		    b_s = r_d;
@@ -545,7 +680,7 @@ int nw ( char seq1[],
 		}
 	    }
 	    else if ( r_u >= r_l ) {
-		bit_trace[byte] |= byte_down << nibble;
+		trace_bits |= byte_down << nibble;
 		*rowsp2 = r_u;
 		if ( r_u > b_s ) {
 		    b_s = r_u;
@@ -555,7 +690,7 @@ int nw ( char seq1[],
 		}
 	    }
 	    else {
-		bit_trace[byte] |= byte_across << nibble;
+		trace_bits |= byte_across << nibble;
 		*rowsp2 = r_l;
 		if ( r_l > b_s ) {
 		    b_s = r_l;
@@ -567,6 +702,7 @@ int nw ( char seq1[],
 
 	}
     }
+    bit_trace[trace_byte] = trace_bits;
 
     /* now use the bit_trace to create the alignment */
 
@@ -667,9 +803,6 @@ int nw ( char seq1[],
 	seq2_res[i] = seq2_res[j];
     }
     *len_align = i - 1;
-    xfree ( rows1 );
-    xfree ( rows2 );
-    xfree ( bit_trace );
     return 0;
 }
 
@@ -834,6 +967,7 @@ int do_it_3p ( FILE *fp_i, FILE *fp_p, FILE *fp_f,
     while ( fgets ( file_name, FILENAME_MAX, fp_i )) {
 
 	if ( cp = strchr ( file_name, '\n' )) *cp = '\0';
+	nreads++;
 	if ( tmode ) {
 	    printf(">>>>>>>>>>>>>>>>>>>>>> %s\n", file_name );
 	}
@@ -990,6 +1124,7 @@ int do_it_sv ( char *vector_seq, int max_vector,
     while ( fgets ( file_name, FILENAME_MAX, fp_i )) {
 
 	if ( cp = strchr ( file_name, '\n' )) *cp = '\0';
+	nreads++;
 
 	if ( tmode ) {
 	    printf(">>>>>>>>>>>>>>>>>>>>>> %s\n", file_name );
@@ -1294,6 +1429,7 @@ int do_it_sv_pvf ( char *vector_seq, int max_vector,
     while ( fgets ( file_name, FILENAME_MAX, fp_i )) {
 
 	if ( cp = strchr ( file_name, '\n' )) *cp = '\0';
+	nreads++;
 
 	if ( tmode ) {
 	    printf(">>>>>>>>>>>>>>>>>>>>>> %s\n", file_name );
@@ -1635,10 +1771,10 @@ int do_it_tr ( char *vector_seq, int max_vector,
     int *hash_values1, *hash_values2, *last_word, *word_count, *diag;
     int vector_length = 0;
     char vector_file_name[FILENAME_MAX+1], *vfn;
-    char prev_vector_file_name[FILENAME_MAX+1];
     FILE *vf;
-    int sc, prev_sc, prev_sp;
-    int new_vector;
+    int sc;
+    Vector_cache *vc;
+    Vector_hash *vh;
     double score_3f, score_3r, score_vf, score_vr;
     int score_f, score_r;
     int lg, rg, xf=0, xr=0, yf=0, yr=0; 
@@ -1668,21 +1804,21 @@ int do_it_tr ( char *vector_seq, int max_vector,
           (and hence the read) relative to the vector) (dynamic program).
 	  If we find a match >= cut_score_3 reset SR.
     */
-    prev_sp = prev_sc = 0;
-
     /* initialise this algorithm */
 
     if ( min_match < 8 ) min_match = 8;
-    prev_vector_file_name[0] = '\0';
 
     if ( init_hash8 ( max_vector, MAX_READ,
-		     &hash_values1, &last_word, &word_count,
+		     NULL, NULL, NULL,
 		     &hash_values2, &diag ))
 	return -1;
+    if ( ! (vc = vector_cache_create ( max_vector, size_hash )))
+	return -1;
 
     while ( fgets ( file_name, FILENAME_MAX, fp_i )) {
 
 	if ( cp = strchr ( file_name, '\n' )) *cp = '\0';
+	nreads++;
 
 	if ( tmode ) {
 	    printf(">>>>>>>>>>>>>>>>>>>>>> %s\n", file_name );
@@ -1755,11 +1891,6 @@ int do_it_tr ( char *vector_seq, int max_vector,
 		sp = atoi ( expline );
 	      }
 
-	      new_vector = 0;
-	      if (( sp != prev_sp) || ( sc != prev_sc)) new_vector = 1; 
-	      prev_sp = sp;
-	      prev_sc = sc;
-
 	      /* get the vector file */
 
 	      if ( exp_Nentries ( e, EFLT_SF )) {
@@ -1776,15 +1907,17 @@ int do_it_tr ( char *vector_seq, int max_vector,
 		continue;
 	      }
 
-		/* we only get the vector seq if it is different from
-		   the previous one, or the cloning site is different,
-		   or the primer site is different (actually this only
-		   matters if has moved to the other strand)
+		/* we only read and hash the vector seq if we do not
+		   already have it rotated to this cloning site
 		*/
 
-	      if ( strcmp ( vector_file_name, prev_vector_file_name )) new_vector = 1;
+	      if ( ! (vh = vector_cache_find ( vc, vector_file_name, sc ))) {
+		if ( ! (vh = vector_cache_new ( vc ))) {
+		  eret =  vep_error ( fp_f, file_name, 11 );
+		  exp_destroy_info ( e );
+		  continue;
+		}
 
-	      if ( new_vector ) {
 		vf = fopen(vector_file_name, "r");
 		if (vf == NULL ) {
 		  eret =  vep_error ( fp_f, file_name, 7 );
@@ -1792,7 +1925,7 @@ int do_it_tr ( char *vector_seq, int max_vector,
 		  continue;
 		}
 
-		ret = get_text_seq ( vector_seq, max_vector, &vector_length, vf);
+		ret = get_text_seq ( vh->seq, max_vector, &vh->length, vf);
 
 		fclose(vf);
 		if ( ret ) {
@@ -1803,25 +1936,30 @@ int do_it_tr ( char *vector_seq, int max_vector,
 
 		/* rotate sequence so that cloning site at vector_seq[0] */
 
-		ret = rotate_seq ( vector_seq, vector_length, sc+1);
+		ret = rotate_seq ( vh->seq, vh->length, sc+1);
 		if ( ret ) {
 		  eret =  vep_error ( fp_f, file_name, 13 );
 		  exp_destroy_info ( e );
 		  continue;
 		}
 
-		strcpy( prev_vector_file_name, vector_file_name );
-
-		if ( hash_seq8 ( vector_seq, hash_values1, vector_length )  != 0 ) {
+		if ( hash_seq8 ( vh->seq, vh->hash_values, vh->length )  != 0 ) {
 		  eret =  vep_error ( fp_f, file_name, 11 );
 		  exp_destroy_info ( e );
 		  continue;
 		}
 
-		(void) store_hash ( hash_values1, vector_length, last_word, 
-				   word_count, word_length, size_hash);
-	      
+		(void) store_hash ( vh->hash_values, vh->length, vh->last_word, 
+				   vh->word_count, word_length, size_hash);
+
+		strcpy( vh->file_name, vector_file_name );
+		vh->key = sc;
 	      }
+	      vector_seq = vh->seq;
+	      vector_length = vh->length;
+	      hash_values1 = vh->hash_values;
+	      last_word = vh->last_word;
+	      word_count = vh->word_count;
 
 	      /* try all primer pairs */
 
@@ -1899,7 +2037,6 @@ int do_it_tr ( char *vector_seq, int max_vector,
 	      }
 
 
-	      new_vector = 0;
 	      complement_seq ( &seq[lg], rg-lg+1);
 	      
 	      ret = do_hash_tr ( vector_length, rg-lg+1,
@@ -2106,7 +2243,9 @@ int do_it_tr ( char *vector_seq, int max_vector,
 	    if (!(tmode)) (void) write_dot();
 	  }
       }
-    
+
+    free_hash8 ( NULL, NULL, NULL, hash_values2, diag );
+    vector_cache_destroy ( vc );
     return 0;
   }
 
@@ -2129,8 +2268,9 @@ int do_it_cv ( char *vector_seq, int max_vector,
     int vector_length = 0, x, y, ret, eret;
     DI *hist;
     char vector_file_name[FILENAME_MAX+1], *vfn;
-    char prev_vector_file_name[FILENAME_MAX+1];
     FILE *vf;
+    Vector_cache *vc;
+    Vector_hash *vh;
     int sl, sr; /* sequencing vector left and right */
     double score_3f, score_f, score_3r, score_r;
     int lg, rg, xf=0, xr=0, cl=0, cr=0;
@@ -2149,16 +2289,17 @@ int do_it_cv ( char *vector_seq, int max_vector,
 			    expected_scores )) return -1;
     }
 
-    prev_vector_file_name[0] = '\0';
-
     if ( init_hash ( word_length, max_vector, MAX_READ,
-	     &hash_values1, &last_word, &word_count,
+	     NULL, NULL, NULL,
 		     &hash_values2, &diag, &hist, &size_hash, &line ))
 	return -1;
+    if ( ! (vc = vector_cache_create ( max_vector, size_hash )))
+	return -1;
 
     while ( fgets ( file_name, FILENAME_MAX, fp_i )) {
 
 	if ( cp = strchr ( file_name, '\n' )) *cp = '\0';
+	nreads++;
 
 	if ( tmode ) {
 	    printf(">>>>>>>>>>>>>>>>>>>>>> %s\n", file_name );
@@ -2221,11 +2362,17 @@ int do_it_cv ( char *vector_seq, int max_vector,
 		}
 
 
-		/* we only get the vector seq if it is different from
-		   the previous one.
+		/* we only read and hash the vector seq if it is not
+		   already in the cache.
 		*/
 
-		if ( strcmp ( vector_file_name, prev_vector_file_name )) {
+		if ( ! (vh = vector_cache_find ( vc, vector_file_name, 0 ))) {
+
+		    if ( ! (vh = vector_cache_new ( vc ))) {
+			eret =  vep_error ( fp_f, file_name, 11 );
+			exp_destroy_info ( e );
+			continue;
+		    }
 
 		    vf = fopen(vector_file_name, "r");
 		    if (vf == NULL ) {
@@ -2234,26 +2381,32 @@ int do_it_cv ( char *vector_seq, int max_vector,
 			continue;
 		    }
 
-		    ret = get_text_seq ( vector_seq, max_vector, &vector_length, vf);
+		    ret = get_text_seq ( vh->seq, max_vector, &vh->length, vf);
 		    fclose(vf);
 		    if ( ret ) {
 			eret =  vep_error ( fp_f, file_name, 9 );
 			exp_destroy_info ( e );
 			continue;
 		    }
-		    strcpy( prev_vector_file_name, vector_file_name );
 
 
-		    if ( hash_seq ( word_length, vector_seq, hash_values1, 
-				   vector_length )  != 0 ) {
+		    if ( hash_seq ( word_length, vh->seq, vh->hash_values, 
+				   vh->length )  != 0 ) {
 		      eret =  vep_error ( fp_f, file_name, 11 );
 		      exp_destroy_info ( e );
 		      continue;
 		    }
 
-		    (void) store_hash ( hash_values1, vector_length, last_word,
-				       word_count, word_length, size_hash);
+		    (void) store_hash ( vh->hash_values, vh->length, vh->last_word,
+				       vh->word_count, word_length, size_hash);
+		    strcpy( vh->file_name, vector_file_name );
+		    vh->key = 0;
 		}
+		vector_seq = vh->seq;
+		vector_length = vh->length;
+		hash_values1 = vh->hash_values;
+		last_word = vh->last_word;
+		word_count = vh->word_count;
 
 		/* we have to search both strands so we call do_hash
 		   with the read in its original sense, then its
@@ -2402,9 +2555,10 @@ int do_it_cv ( char *vector_seq, int max_vector,
 	exp_destroy_info ( e ); 
 	if (!(tmode)) (void) write_dot();
     }
-    free_hash ( hash_values1, last_word,
-	       word_count, hash_values2,
+    free_hash ( NULL, NULL,
+	       NULL, hash_values2,
 	       diag, hist );
+    vector_cache_destroy ( vc );
 
     xfree(expected_scores);
 
@@ -2447,16 +2601,18 @@ int init_hash8 ( int seq1_len, int seq2_len,
 
     size_hash = 65536;
 
+    /* the vector tables are optional as they may come from a Vector_cache */
 
-    if ( NULL == (*hash_values1 = (int *) xmalloc ( sizeof(int)*(seq1_len) ))) {
+    if ( hash_values1 &&
+	 NULL == (*hash_values1 = (int *) xmalloc ( sizeof(int)*(seq1_len) ))) {
 	return -2;
     }
 
-    if ( ! (*last_word = (int *) xmalloc ( sizeof(int)*size_hash ))) {
+    if ( last_word && ! (*last_word = (int *) xmalloc ( sizeof(int)*size_hash ))) {
 	return -2;
     }
 
-    if ( ! (*word_count = (int *) xmalloc ( sizeof(int)*size_hash ))) {
+    if ( word_count && ! (*word_count = (int *) xmalloc ( sizeof(int)*size_hash ))) {
 	return -2;
     }
 
@@ -2705,8 +2861,9 @@ int do_it_vr ( char *vector_seq, int max_vector,
     int *diag;
     int vector_length = 0, x, y, ret, eret;
     char vector_file_name[FILENAME_MAX+1], *vfn;
-    char prev_vector_file_name[FILENAME_MAX+1];
     FILE *vf;
+    Vector_cache *vc;
+    Vector_hash *vh;
     int sl, sr; /* sequencing vector left and right */
     int score, score_f, score_r;
     int lg, rg, xf=0, xr=0, yf=0, yr=0;
@@ -2719,17 +2876,19 @@ int do_it_vr ( char *vector_seq, int max_vector,
 
 
     if ( min_match < 8 ) min_match = 8;
-    prev_vector_file_name[0] = '\0';
 
     if ( init_hash8 ( max_vector, MAX_READ,
-		     &hash_values1, &last_word, &word_count,
+		     NULL, NULL, NULL,
 		     &hash_values2, &diag ))
 	return -1;
+    if ( ! (vc = vector_cache_create ( max_vector, size_hash )))
+	return -1;
 
 
     while ( fgets ( file_name, FILENAME_MAX, fp_i )) {
 
 	if ( cp = strchr ( file_name, '\n' )) *cp = '\0';
+	nreads++;
 
 	if ( tmode ) {
 	    printf(">>>>>>>>>>>>>>>>>>>>>> %s\n", file_name );
@@ -2803,11 +2962,17 @@ int do_it_vr ( char *vector_seq, int max_vector,
 		  }
 		}
 
-		/* we only get the vector seq if it is different from
-		   the previous one.
+		/* we only read and hash the vector seq if it is not
+		   already in the cache.
 		*/
 
-		if ( strcmp ( vector_file_name, prev_vector_file_name )) {
+		if ( ! (vh = vector_cache_find ( vc, vector_file_name, 0 ))) {
+		    if ( ! (vh = vector_cache_new ( vc ))) {
+			eret =  vep_error ( fp_f, file_name, 11 );
+			exp_destroy_info ( e );
+			continue;
+		    }
+
 		    vf = fopen(vector_file_name, "r");
 		    if (vf == NULL ) {
 			eret =  vep_error ( fp_f, file_name, 7 );
@@ -2815,26 +2980,32 @@ int do_it_vr ( char *vector_seq, int max_vector,
 			continue;
 		    }
 
-		    ret = get_text_seq ( vector_seq, max_vector, &vector_length, vf);
+		    ret = get_text_seq ( vh->seq, max_vector, &vh->length, vf);
 		    fclose(vf);
-/* 		    printf("vector length %d\n",vector_length); */
+/* 		    printf("vector length %d\n",vh->length); */
 		    if ( ret ) {
 			eret =  vep_error ( fp_f, file_name, 9 );
 			exp_destroy_info ( e );
 			continue;
 		    }
-		    strcpy( prev_vector_file_name, vector_file_name );
 
-		    if ( hash_seq8 ( vector_seq, hash_values1, vector_length )  != 0 ) {
+		    if ( hash_seq8 ( vh->seq, vh->hash_values, vh->length )  != 0 ) {
 		      eret =  vep_error ( fp_f, file_name, 11 );
 		      exp_destroy_info ( e );
 		      continue;
 		    }
 
-		    (void) store_hash ( hash_values1, vector_length, last_word, 
-				       word_count,
+		    (void) store_hash ( vh->hash_values, vh->length, vh->last_word, 
+				       vh->word_count,
 			    word_length, size_hash);
+		    strcpy( vh->file_name, vector_file_name );
+		    vh->key = 0;
 		  }
+		vector_seq = vh->seq;
+		vector_length = vh->length;
+		hash_values1 = vh->hash_values;
+		last_word = vh->last_word;
+		word_count = vh->word_count;
 
 		/* we have to search both strands so we call do_hash
 		   with the read in its original sense, then its
@@ -2948,9 +3119,10 @@ int do_it_vr ( char *vector_seq, int max_vector,
 	exp_destroy_info ( e );
 	if (!(tmode)) (void) write_dot();
     }
-    free_hash8 ( hash_values1, last_word,
-	         word_count, hash_values2,
+    free_hash8 ( NULL, NULL,
+	         NULL, hash_values2,
 	         diag );
+    vector_cache_destroy ( vc );
     return 0;
 }
 
@@ -3085,16 +3257,18 @@ int init_hash ( int word_length, int seq1_len, int seq2_len,
 
     *size_hash = pow(char_set_size-1, word_length);
 
+    /* the vector tables are optional as they may come from a Vector_cache */
 
-    if ( NULL == (*hash_values1 = (int *) xmalloc ( sizeof(int)*(seq1_len) ))) {
+    if ( hash_values1 &&
+	 NULL == (*hash_values1 = (int *) xmalloc ( sizeof(int)*(seq1_len) ))) {
 	return -2;
     }
 
-    if ( ! (*last_word = (int *) xmalloc ( sizeof(int)*(*size_hash) ))) {
+    if ( last_word && ! (*last_word = (int *) xmalloc ( sizeof(int)*(*size_hash) ))) {
 	return -2;
     }
 
-    if ( ! (*word_count = (int *) xmalloc ( sizeof(int)*(*size_hash) ))) {
+    if ( word_count && ! (*word_count = (int *) xmalloc ( sizeof(int)*(*size_hash) ))) {
 	return -2;
     }
 
@@ -3418,6 +3592,8 @@ int main(int argc, char **argv) {
     char expanded_fn[FILENAME_MAX+1];
     FILE *fp_p, *fp_f, *fp_i, *fp_vf;
     Vector_specs *v = NULL;
+    struct timeval tv_start, tv_end;
+    double elapsed;
 
     fofn_p = fofn_f = fofn_i = vf = NULL;
     fp_p = fp_f = fp_i = fp_vf = NULL;
@@ -3567,6 +3743,8 @@ int main(int argc, char **argv) {
 
     if ( ! (vector_seq = (char *) xmalloc ( sizeof(char)*max_vector ))) return -1;
 
+    gettimeofday ( &tv_start, NULL );
+
     if ( mode == HGMP ) {
 
 	i = do_it_3p ( fp_i, fp_p, fp_f, 
@@ -3604,6 +3782,13 @@ int main(int argc, char **argv) {
     }
 
     fprintf(stdout,"\n");
+
+    gettimeofday ( &tv_end, NULL );
+    elapsed = (tv_end.tv_sec - tv_start.tv_sec) +
+	(tv_end.tv_usec - tv_start.tv_usec) / 1000000.0;
+    fprintf(stdout, "%d readings in %.2f seconds (%.1f readings/second)\n",
+	    nreads, elapsed, elapsed > 0.0 ? nreads / elapsed : 0.0);
+
     xfree ( vector_seq );
     return 0;
 }